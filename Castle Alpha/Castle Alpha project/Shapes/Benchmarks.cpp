@@ -0,0 +1,1230 @@
+#include "Benchmarks.h"
+#include "FrameResource.h"
+#include "../../Common/GeometryGenerator.h"
+#include "../../Common/BoundsUtil.h"
+#include "../../Common/FrustumCuller.h"
+#include "../../Common/SceneBvh.h"
+#include "../../Common/RenderQueue.h"
+#include "../../Common/VertexQuantizer.h"
+#include "../../Common/UploadRing.h"
+#include "../../Common/AffineTransform.h"
+#include "../../Common/ThreadPool.h"
+#include "../../Common/MathHelper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	// Runs fn repeatCount times and returns the average wall time in milliseconds.
+	template<typename Fn>
+	double TimeMs(int repeatCount, Fn fn)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < repeatCount; ++i)
+			fn();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count() / repeatCount;
+	}
+
+	void Report(const std::ostringstream& ss)
+	{
+		::OutputDebugStringA(ss.str().c_str());
+	}
+
+	// The scalar ring loop CreateSphere used before the slice and stack angles were
+	// tabulated: sinf/cosf for every vertex and one push_back at a time.  Only the
+	// vertices are built, which is the part the table kernels replace.
+	void ScalarSphereVertices(float radius, GeometryGenerator::uint32 sliceCount,
+		GeometryGenerator::uint32 stackCount, std::vector<GeometryGenerator::Vertex>& vertices)
+	{
+		using namespace DirectX;
+
+		vertices.clear();
+		vertices.push_back(GeometryGenerator::Vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+
+		float phiStep = XM_PI/stackCount;
+		float thetaStep = 2.0f*XM_PI/sliceCount;
+
+		for(GeometryGenerator::uint32 i = 1; i <= stackCount-1; ++i)
+		{
+			float phi = i*phiStep;
+			for(GeometryGenerator::uint32 j = 0; j <= sliceCount; ++j)
+			{
+				float theta = j*thetaStep;
+
+				GeometryGenerator::Vertex v;
+				v.Position = XMFLOAT3(radius*sinf(phi)*cosf(theta), radius*cosf(phi), radius*sinf(phi)*sinf(theta));
+				v.TangentU = XMFLOAT3(-radius*sinf(phi)*sinf(theta), 0.0f, +radius*sinf(phi)*cosf(theta));
+
+				XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMLoadFloat3(&v.TangentU)));
+				XMStoreFloat3(&v.Normal, XMVector3Normalize(XMLoadFloat3(&v.Position)));
+
+				v.TexC = XMFLOAT2(theta/XM_2PI, phi/XM_PI);
+				vertices.push_back(v);
+			}
+		}
+
+		vertices.push_back(GeometryGenerator::Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	//
+	// The ring path CreateSphere and CreateCylinder used before they moved onto the
+	// sweep kernel: a ring writer specialized to circles about the y-axis, fed from
+	// sin/cos tables, with the cylinder caps built separately.
+	//
+
+	struct RingSinCosTable
+	{
+		RingSinCosTable(GeometryGenerator::uint32 count, float step)
+		{
+			using namespace DirectX;
+
+			const GeometryGenerator::uint32 paddedCount = (count + 4) & ~3u;
+			Sin.resize(paddedCount);
+			Cos.resize(paddedCount);
+
+			const XMVECTOR lanes = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+			for(GeometryGenerator::uint32 i = 0; i < paddedCount; i += 4)
+			{
+				XMVECTOR s, c;
+				XMVectorSinCos(&s, &c, (XMVectorReplicate((float)i) + lanes)*step);
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&Sin[i]), s);
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&Cos[i]), c);
+			}
+		}
+
+		std::vector<float> Sin;
+		std::vector<float> Cos;
+	};
+
+	void WriteRing(const RingSinCosTable& slices, GeometryGenerator::uint32 sliceCount, float radius, float y,
+		float normalRadial, float normalY, float v, GeometryGenerator::Vertex* ring)
+	{
+		using namespace DirectX;
+
+		const XMVECTOR r = XMVectorReplicate(radius);
+		const XMVECTOR nr = XMVectorReplicate(normalRadial);
+		const XMVECTOR sliceCountV = XMVectorReplicate((float)sliceCount);
+		const XMVECTOR lanes = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+
+		XMFLOAT4 x, z, nx, nz, u;
+		for(GeometryGenerator::uint32 j = 0; j <= sliceCount; j += 4)
+		{
+			XMVECTOR c = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&slices.Cos[j]));
+			XMVECTOR s = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&slices.Sin[j]));
+
+			XMStoreFloat4(&x, r*c);
+			XMStoreFloat4(&z, r*s);
+			XMStoreFloat4(&nx, nr*c);
+			XMStoreFloat4(&nz, nr*s);
+			XMStoreFloat4(&u, (XMVectorReplicate((float)j) + lanes)/sliceCountV);
+
+			const GeometryGenerator::uint32 laneCount = std::min<GeometryGenerator::uint32>(4, sliceCount + 1 - j);
+			for(GeometryGenerator::uint32 k = 0; k < laneCount; ++k)
+			{
+				GeometryGenerator::Vertex& vertex = ring[j + k];
+				vertex.Position = XMFLOAT3((&x.x)[k], y, (&z.x)[k]);
+				vertex.Normal = XMFLOAT3((&nx.x)[k], normalY, (&nz.x)[k]);
+				vertex.TangentU = XMFLOAT3(-slices.Sin[j + k], 0.0f, slices.Cos[j + k]);
+				vertex.TexC = XMFLOAT2((&u.x)[k], v);
+			}
+		}
+	}
+
+	GeometryGenerator::MeshData RingSphere(float radius, GeometryGenerator::uint32 sliceCount, GeometryGenerator::uint32 stackCount)
+	{
+		using namespace DirectX;
+		using uint32 = GeometryGenerator::uint32;
+
+		GeometryGenerator::MeshData meshData;
+
+		RingSinCosTable stacks(stackCount, XM_PI/stackCount);
+		RingSinCosTable slices(sliceCount, 2.0f*XM_PI/sliceCount);
+
+		uint32 ringCount = stackCount - 1;
+		uint32 ringVertexCount = sliceCount + 1;
+
+		meshData.Vertices.resize(ringCount*ringVertexCount + 2);
+		meshData.Indices32.resize(6*sliceCount*ringCount);
+
+		meshData.Vertices.front() = GeometryGenerator::Vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		meshData.Vertices.back() = GeometryGenerator::Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+
+		for(uint32 i = 1; i <= ringCount; ++i)
+		{
+			WriteRing(slices, sliceCount, radius*stacks.Sin[i], radius*stacks.Cos[i], stacks.Sin[i], stacks.Cos[i],
+				(float)i/stackCount, &meshData.Vertices[1 + (i-1)*ringVertexCount]);
+		}
+
+		uint32* index = meshData.Indices32.data();
+		for(uint32 i = 1; i <= sliceCount; ++i)
+		{
+			*index++ = 0;
+			*index++ = i+1;
+			*index++ = i;
+		}
+
+		for(uint32 i = 0; i < stackCount-2; ++i)
+		{
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				*index++ = 1 + i*ringVertexCount + j;
+				*index++ = 1 + i*ringVertexCount + j+1;
+				*index++ = 1 + (i+1)*ringVertexCount + j;
+
+				*index++ = 1 + (i+1)*ringVertexCount + j;
+				*index++ = 1 + i*ringVertexCount + j+1;
+				*index++ = 1 + (i+1)*ringVertexCount + j+1;
+			}
+		}
+
+		uint32 southPoleIndex = (uint32)meshData.Vertices.size()-1;
+		uint32 baseIndex = southPoleIndex - ringVertexCount;
+		for(uint32 i = 0; i < sliceCount; ++i)
+		{
+			*index++ = southPoleIndex;
+			*index++ = baseIndex+i;
+			*index++ = baseIndex+i+1;
+		}
+
+		return meshData;
+	}
+
+	void AppendRingCylinderCap(const RingSinCosTable& slices, float radius, float height,
+		GeometryGenerator::uint32 sliceCount, bool top, GeometryGenerator::MeshData& meshData)
+	{
+		using uint32 = GeometryGenerator::uint32;
+
+		uint32 baseIndex = (uint32)meshData.Vertices.size();
+		float y = top ? 0.5f*height : -0.5f*height;
+		float normalY = top ? 1.0f : -1.0f;
+
+		for(uint32 i = 0; i <= sliceCount; ++i)
+		{
+			float x = radius*slices.Cos[i];
+			float z = radius*slices.Sin[i];
+			meshData.Vertices.push_back(GeometryGenerator::Vertex(x, y, z, 0.0f, normalY, 0.0f, 1.0f, 0.0f, 0.0f,
+				x/height + 0.5f, z/height + 0.5f));
+		}
+
+		uint32 centerIndex = (uint32)meshData.Vertices.size();
+		meshData.Vertices.push_back(GeometryGenerator::Vertex(0.0f, y, 0.0f, 0.0f, normalY, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f));
+
+		for(uint32 i = 0; i < sliceCount; ++i)
+		{
+			meshData.Indices32.push_back(centerIndex);
+			meshData.Indices32.push_back(baseIndex + (top ? i+1 : i));
+			meshData.Indices32.push_back(baseIndex + (top ? i : i+1));
+		}
+	}
+
+	GeometryGenerator::MeshData RingCylinder(float radius, float height, GeometryGenerator::uint32 sliceCount,
+		GeometryGenerator::uint32 stackCount)
+	{
+		using namespace DirectX;
+		using uint32 = GeometryGenerator::uint32;
+
+		GeometryGenerator::MeshData meshData;
+
+		RingSinCosTable slices(sliceCount, 2.0f*XM_PI/sliceCount);
+
+		uint32 ringCount = stackCount+1;
+		uint32 ringVertexCount = sliceCount+1;
+
+		meshData.Vertices.reserve(ringCount*ringVertexCount + 2*(ringVertexCount+1));
+		meshData.Indices32.reserve(6*stackCount*sliceCount + 6*sliceCount);
+		meshData.Vertices.resize(ringCount*ringVertexCount);
+		meshData.Indices32.resize(6*stackCount*sliceCount);
+
+		for(uint32 i = 0; i < ringCount; ++i)
+		{
+			WriteRing(slices, sliceCount, radius, -0.5f*height + i*height/stackCount, 1.0f, 0.0f,
+				1.0f - (float)i/stackCount, &meshData.Vertices[i*ringVertexCount]);
+		}
+
+		uint32* index = meshData.Indices32.data();
+		for(uint32 i = 0; i < stackCount; ++i)
+		{
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				*index++ = i*ringVertexCount + j;
+				*index++ = (i+1)*ringVertexCount + j;
+				*index++ = (i+1)*ringVertexCount + j+1;
+
+				*index++ = i*ringVertexCount + j;
+				*index++ = (i+1)*ringVertexCount + j+1;
+				*index++ = i*ringVertexCount + j+1;
+			}
+		}
+
+		AppendRingCylinderCap(slices, radius, height, sliceCount, true, meshData);
+		AppendRingCylinderCap(slices, radius, height, sliceCount, false, meshData);
+
+		return meshData;
+	}
+
+	// Vertices whose normal is not unit length, NaN normals included.
+	size_t CountBadNormals(const GeometryGenerator::MeshData& mesh)
+	{
+		using namespace DirectX;
+
+		size_t badCount = 0;
+		for(const GeometryGenerator::Vertex& v : mesh.Vertices)
+		{
+			float length = XMVectorGetX(XMVector3Length(XMLoadFloat3(&v.Normal)));
+			if(!(fabsf(length - 1.0f) < 1.0e-3f))
+				badCount++;
+		}
+
+		return badCount;
+	}
+
+	//
+	// Candy shapes described only as lathe profiles and extrusion paths.
+	//
+
+	// A straight stick that bends into a half circle hook at the top, with closed ends.
+	void CandyCanePath(GeometryGenerator::uint32 segmentCount, std::vector<DirectX::XMFLOAT3>& path, std::vector<float>& radii)
+	{
+		using namespace DirectX;
+
+		const float radius = 0.15f;
+		const float stickHeight = 3.0f;
+		const float hookRadius = 0.6f;
+
+		path.clear();
+		for(GeometryGenerator::uint32 i = 0; i <= segmentCount; ++i)
+			path.push_back(XMFLOAT3(0.0f, stickHeight*i/segmentCount, 0.0f));
+
+		for(GeometryGenerator::uint32 i = 1; i <= segmentCount; ++i)
+		{
+			float angle = XM_PI*i/segmentCount;
+			path.push_back(XMFLOAT3(hookRadius - hookRadius*cosf(angle), stickHeight + hookRadius*sinf(angle), 0.0f));
+		}
+
+		path.insert(path.begin(), path.front());
+		path.push_back(path.back());
+
+		radii.assign(path.size(), radius);
+		radii.front() = 0.0f;
+		radii.back() = 0.0f;
+	}
+
+	// A flat round candy: a rounded rim between two flat faces.
+	void LollipopProfile(GeometryGenerator::uint32 rimSegmentCount, std::vector<DirectX::XMFLOAT2>& profile)
+	{
+		using namespace DirectX;
+
+		const float radius = 1.0f;
+		const float halfThickness = 0.2f;
+
+		profile.clear();
+		profile.push_back(XMFLOAT2(0.0f, -halfThickness));
+		for(GeometryGenerator::uint32 i = 0; i <= rimSegmentCount; ++i)
+		{
+			float angle = -XM_PIDIV2 + XM_PI*i/rimSegmentCount;
+			profile.push_back(XMFLOAT2(radius + halfThickness*cosf(angle), halfThickness*sinf(angle)));
+		}
+		profile.push_back(XMFLOAT2(0.0f, halfThickness));
+	}
+
+	// A flat spiral that thins towards its center.
+	void SwirlPath(GeometryGenerator::uint32 segmentCount, std::vector<DirectX::XMFLOAT3>& path, std::vector<float>& radii)
+	{
+		using namespace DirectX;
+
+		const float turnCount = 3.0f;
+
+		path.clear();
+		radii.clear();
+		for(GeometryGenerator::uint32 i = 0; i <= segmentCount; ++i)
+		{
+			float t = (float)i/segmentCount;
+			float angle = XM_2PI*turnCount*t;
+			float distance = 0.1f + 0.9f*t;
+			path.push_back(XMFLOAT3(distance*cosf(angle), 0.0f, distance*sinf(angle)));
+			radii.push_back(0.02f + 0.06f*t);
+		}
+	}
+}
+
+void RunBenchmarks(ID3D12Device* device, ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* perObjectPso, ID3D12PipelineState* objectBufferPso)
+{
+	BenchmarkSubdivide();
+	BenchmarkBounds();
+	BenchmarkFrustumCull();
+	BenchmarkSceneBvh();
+	BenchmarkRenderQueueSort();
+	BenchmarkVertexQuantizer();
+	BenchmarkRingGeneration();
+	BenchmarkSweep();
+	BenchmarkUploadRing();
+	BenchmarkObjectBuffer(device, rootSignature, perObjectPso, objectBufferPso);
+	BenchmarkAffineTransform();
+	BenchmarkDirtyObjects();
+	BenchmarkParallelObjectUpdate();
+}
+
+void BenchmarkSubdivide()
+{
+	GeometryGenerator geoGen;
+
+	// Level 0 geosphere is the projected icosahedron both paths start from.
+	GeometryGenerator::MeshData icosahedron = geoGen.CreateGeosphere(1.0f, 0);
+
+	for(GeometryGenerator::uint32 level = 1; level <= 6; ++level)
+	{
+		const int repeatCount = level < 5 ? 50 : 5;
+
+		size_t sharedVerts = 0;
+		size_t unsharedVerts = 0;
+
+		double sharedMs = TimeMs(repeatCount, [&]()
+		{
+			GeometryGenerator::MeshData mesh = icosahedron;
+			for(GeometryGenerator::uint32 i = 0; i < level; ++i)
+				geoGen.Subdivide(mesh);
+			sharedVerts = mesh.Vertices.size();
+		});
+
+		double unsharedMs = TimeMs(repeatCount, [&]()
+		{
+			GeometryGenerator::MeshData mesh = icosahedron;
+			for(GeometryGenerator::uint32 i = 0; i < level; ++i)
+				geoGen.SubdivideUnshared(mesh);
+			unsharedVerts = mesh.Vertices.size();
+		});
+
+		std::ostringstream ss;
+		ss << "Subdivide level " << level
+		   << ": indexed " << sharedMs << " ms (" << sharedVerts << " verts)"
+		   << ", unshared " << unsharedMs << " ms (" << unsharedVerts << " verts)\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkBounds()
+{
+	using namespace DirectX;
+
+	GeometryGenerator geoGen;
+
+	// 100k submeshes the size of a box, laid end to end like the packed vertex buffer.
+	const size_t objectCount = 100000;
+	GeometryGenerator::MeshData box = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 0);
+	const size_t vertsPerObject = box.Vertices.size();
+
+	std::vector<GeometryGenerator::Vertex> vertices;
+	vertices.reserve(objectCount*vertsPerObject);
+	for(size_t i = 0; i < objectCount; ++i)
+		vertices.insert(vertices.end(), box.Vertices.begin(), box.Vertices.end());
+
+	std::vector<BoundingBox> boxes(objectCount);
+	std::vector<BoundingSphere> spheres(objectCount);
+
+	double kernelMs = TimeMs(10, [&]()
+	{
+		for(size_t i = 0; i < objectCount; ++i)
+		{
+			BoundsUtil::ComputeBounds(&vertices[i*vertsPerObject].Position, vertsPerObject,
+				sizeof(GeometryGenerator::Vertex), boxes[i], spheres[i]);
+		}
+	});
+
+	double collisionMs = TimeMs(10, [&]()
+	{
+		for(size_t i = 0; i < objectCount; ++i)
+		{
+			BoundingBox::CreateFromPoints(boxes[i], vertsPerObject,
+				&vertices[i*vertsPerObject].Position, sizeof(GeometryGenerator::Vertex));
+			BoundingSphere::CreateFromPoints(spheres[i], vertsPerObject,
+				&vertices[i*vertsPerObject].Position, sizeof(GeometryGenerator::Vertex));
+		}
+	});
+
+	std::ostringstream ss;
+	ss << "Bounds of " << objectCount << " submeshes: BoundsUtil " << kernelMs
+	   << " ms, BoundingBox + BoundingSphere::CreateFromPoints " << collisionMs << " ms\n";
+	Report(ss);
+}
+
+void BenchmarkFrustumCull()
+{
+	using namespace DirectX;
+
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 20.0f, -100.0f, 1.0f),
+		XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 1000.0f);
+	XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	const size_t objectCounts[] = { 10000, 100000 };
+	for(size_t objectCount : objectCounts)
+	{
+		// Small boxes scattered over a 1000 x 1000 area, like a large castle scene.
+		FrustumCuller culler;
+		culler.Resize(objectCount);
+		for(size_t i = 0; i < objectCount; ++i)
+		{
+			BoundingBox box;
+			box.Center = XMFLOAT3(MathHelper::RandF(-500.0f, 500.0f), MathHelper::RandF(0.0f, 20.0f), MathHelper::RandF(-500.0f, 500.0f));
+			box.Extents = XMFLOAT3(MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f));
+			culler.SetBox(i, box);
+		}
+
+		std::vector<FrustumCuller::uint32> visible;
+		std::vector<FrustumCuller::uint32> scalarVisible;
+		size_t visibleCount = 0;
+
+		double simdMs = TimeMs(100, [&]() { visibleCount = culler.Cull(viewProj, visible); });
+		double scalarMs = TimeMs(100, [&]() { culler.CullScalar(viewProj, scalarVisible); });
+
+		std::sort(visible.begin(), visible.end());
+		std::sort(scalarVisible.begin(), scalarVisible.end());
+		bool identical = visible == scalarVisible;
+
+		std::ostringstream ss;
+		ss << "Frustum cull " << objectCount << " boxes (" << visibleCount << " visible): "
+#if defined(__AVX__)
+		   << "AVX "
+#else
+		   << "SSE "
+#endif
+		   << simdMs << " ms (" << simdMs*1.0e6 / objectCount << " ns/box), scalar "
+		   << scalarMs << " ms (" << scalarMs*1.0e6 / objectCount << " ns/box"
+		   << (identical ? ")\n" : ", MISMATCH)\n");
+		Report(ss);
+	}
+}
+
+void BenchmarkSceneBvh()
+{
+	using namespace DirectX;
+
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 20.0f, -100.0f, 1.0f),
+		XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 1000.0f);
+	XMMATRIX viewProj = XMMatrixMultiply(view, proj);
+
+	const size_t objectCounts[] = { 10000, 100000 };
+	for(size_t objectCount : objectCounts)
+	{
+		// Same scene as BenchmarkFrustumCull.
+		std::vector<BoundingBox> boxes(objectCount);
+		FrustumCuller culler;
+		culler.Resize(objectCount);
+		for(size_t i = 0; i < objectCount; ++i)
+		{
+			boxes[i].Center = XMFLOAT3(MathHelper::RandF(-500.0f, 500.0f), MathHelper::RandF(0.0f, 20.0f), MathHelper::RandF(-500.0f, 500.0f));
+			boxes[i].Extents = XMFLOAT3(MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f), MathHelper::RandF(0.5f, 3.0f));
+			culler.SetBox(i, boxes[i]);
+		}
+
+		SceneBvh bvh;
+		double buildMs = TimeMs(5, [&]() { bvh.Build(boxes); });
+
+		// Nudge every box, as a frame of small movements would.
+		for(BoundingBox& box : boxes)
+			box.Center.y += 0.1f;
+		double refitMs = TimeMs(20, [&]() { bvh.Refit(boxes); });
+
+		std::vector<SceneBvh::uint32> visible;
+		double bvhCullMs = TimeMs(100, [&]()
+		{
+			visible.clear();
+			bvh.QueryFrustum(viewProj, visible);
+		});
+		double flatCullMs = TimeMs(100, [&]() { culler.Cull(viewProj, visible); });
+
+		// A small view from inside the scene, where the tree can skip most of it.
+		XMMATRIX closeViewProj = XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f*MathHelper::Pi, 16.0f / 9.0f, 1.0f, 150.0f));
+		double bvhCloseMs = TimeMs(100, [&]()
+		{
+			visible.clear();
+			bvh.QueryFrustum(closeViewProj, visible);
+		});
+		size_t closeVisible = visible.size();
+		double flatCloseMs = TimeMs(100, [&]() { culler.Cull(closeViewProj, visible); });
+
+		const int rayCount = 1000;
+		int rayHits = 0;
+		double rayMs = TimeMs(1, [&]()
+		{
+			for(int r = 0; r < rayCount; ++r)
+			{
+				XMVECTOR origin = XMVectorSet(MathHelper::RandF(-500.0f, 500.0f), 50.0f, MathHelper::RandF(-500.0f, 500.0f), 1.0f);
+				XMVECTOR direction = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), -1.0f, MathHelper::RandF(-1.0f, 1.0f), 0.0f);
+
+				SceneBvh::uint32 hitIndex;
+				float hitDistance;
+				if(bvh.RayCast(origin, direction, 100.0f, hitIndex, hitDistance))
+					++rayHits;
+			}
+		});
+
+		const int overlapCount = 1000;
+		size_t overlapResults = 0;
+		double overlapMs = TimeMs(1, [&]()
+		{
+			std::vector<SceneBvh::uint32> results;
+			for(int q = 0; q < overlapCount; ++q)
+			{
+				BoundingBox query;
+				query.Center = XMFLOAT3(MathHelper::RandF(-500.0f, 500.0f), 10.0f, MathHelper::RandF(-500.0f, 500.0f));
+				query.Extents = XMFLOAT3(10.0f, 10.0f, 10.0f);
+
+				results.clear();
+				bvh.QueryOverlap(query, results);
+				overlapResults += results.size();
+			}
+		});
+
+		std::ostringstream ss;
+		ss << "Scene BVH " << objectCount << " boxes (" << bvh.GetNodeCount() << " nodes): build "
+		   << buildMs << " ms, refit " << refitMs << " ms\n"
+		   << "  frustum " << bvhCullMs << " ms vs flat " << flatCullMs << " ms, "
+		   << "near frustum (" << closeVisible << " visible) " << bvhCloseMs << " ms vs flat " << flatCloseMs << " ms\n"
+		   << "  " << rayCount << " rays " << rayMs << " ms (" << rayHits << " hits), "
+		   << overlapCount << " overlap queries " << overlapMs << " ms (" << overlapResults << " results)\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkRenderQueueSort()
+{
+	const size_t packetCounts[] = { 10000, 100000 };
+	for(size_t packetCount : packetCounts)
+	{
+		// A handful of PSOs and geometries, random depths.
+		std::vector<DrawPacket> packets(packetCount);
+		for(size_t i = 0; i < packetCount; ++i)
+		{
+			packets[i].Key = RenderQueue::MakeKey(MathHelper::Rand(0, 1), MathHelper::Rand(0, 7), 4,
+				MathHelper::RandF(1.0f, 1000.0f));
+			packets[i].Item = (RenderQueue::uint32)i;
+		}
+
+		RenderQueue queue;
+		double radixMs = TimeMs(20, [&]()
+		{
+			queue.Clear();
+			for(const DrawPacket& packet : packets)
+				queue.Push(packet.Key, packet.Item);
+			queue.Sort();
+		});
+
+		std::vector<DrawPacket> sorted;
+		double stdMs = TimeMs(20, [&]()
+		{
+			sorted = packets;
+			std::stable_sort(sorted.begin(), sorted.end(),
+				[](const DrawPacket& a, const DrawPacket& b) { return a.Key < b.Key; });
+		});
+
+		// Runs of equal state, which is how many times each bind is issued.
+		size_t stateRuns = 0;
+		const std::vector<DrawPacket>& result = queue.GetPackets();
+		for(size_t i = 0; i < result.size(); ++i)
+		{
+			if(i == 0 || (result[i].Key >> 32) != (result[i - 1].Key >> 32))
+				++stateRuns;
+		}
+
+		std::ostringstream ss;
+		ss << "Draw packet sort " << packetCount << " packets: radix " << radixMs << " ms, std::stable_sort "
+		   << stdMs << " ms, " << stateRuns << " state changes after sorting\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkVertexQuantizer()
+{
+	using namespace DirectX;
+
+	GeometryGenerator geoGen;
+
+	struct Shape
+	{
+		const char* Name;
+		GeometryGenerator::MeshData Mesh;
+	};
+
+	Shape shapes[] =
+	{
+		{ "box", geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3) },
+		{ "grid", geoGen.CreateGrid(20.0f, 30.0f, 60, 40) },
+		{ "sphere", geoGen.CreateSphere(0.5f, 20, 20) },
+		{ "cylinder", geoGen.CreateCylinder(0.5f, 0.5f, 1.0f, 20, 20) },
+		{ "cone", geoGen.CreateCone(0.5f, 1.0f, 20, 20) },
+		{ "geosphere", geoGen.CreateGeosphere(0.5f, 3) },
+		{ "geosphere6", geoGen.CreateGeosphere(0.5f, 6) },
+	};
+
+	for(const Shape& shape : shapes)
+	{
+		const std::vector<GeometryGenerator::Vertex>& vertices = shape.Mesh.Vertices;
+
+		BoundingBox bounds;
+		BoundingBox::CreateFromPoints(bounds, vertices.size(), &vertices[0].Position, sizeof(GeometryGenerator::Vertex));
+
+		const int repeatCount = vertices.size() > 10000 ? 10 : 100;
+
+		std::vector<QuantizedVertex> encoded;
+		std::vector<CompactQuantizedVertex> compact;
+		std::vector<GeometryGenerator::Vertex> decoded;
+		std::vector<GeometryGenerator::Vertex> compactDecoded;
+
+		double encodeMs = TimeMs(repeatCount, [&]() { VertexQuantizer::Encode(vertices, bounds, encoded); });
+		double decodeMs = TimeMs(repeatCount, [&]() { VertexQuantizer::Decode(encoded, bounds, decoded); });
+		double compactEncodeMs = TimeMs(repeatCount, [&]() { VertexQuantizer::Encode(vertices, bounds, compact); });
+		double compactDecodeMs = TimeMs(repeatCount, [&]() { VertexQuantizer::Decode(compact, bounds, compactDecoded); });
+
+		QuantizationError error = VertexQuantizer::MeasureError(vertices, decoded);
+		QuantizationError compactError = VertexQuantizer::MeasureError(vertices, compactDecoded);
+
+		std::ostringstream ss;
+		ss << "Quantize " << shape.Name << " (" << vertices.size() << " verts):\n"
+		   << "  " << sizeof(QuantizedVertex) << " bytes: encode " << encodeMs << " ms, decode " << decodeMs
+		   << " ms, position max " << error.MaxPosition << " mean " << error.MeanPosition
+		   << ", normal " << error.MaxNormalDegrees << " deg, tangent " << error.MaxTangentDegrees
+		   << " deg, uv " << error.MaxTexC << "\n"
+		   << "  " << sizeof(CompactQuantizedVertex) << " bytes: encode " << compactEncodeMs << " ms, decode " << compactDecodeMs
+		   << " ms, position max " << compactError.MaxPosition << " mean " << compactError.MeanPosition
+		   << ", normal " << compactError.MaxNormalDegrees << " deg, tangent " << compactError.MaxTangentDegrees
+		   << " deg, uv " << compactError.MaxTexC << "\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkRingGeneration()
+{
+	GeometryGenerator geoGen;
+
+	for(GeometryGenerator::uint32 tessellation : { 64u, 256u, 512u })
+	{
+		const int repeatCount = tessellation < 512 ? 20 : 5;
+
+		size_t sphereVerts = 0;
+		size_t cylinderVerts = 0;
+		size_t coneVerts = 0;
+
+		double sphereMs = TimeMs(repeatCount, [&]()
+		{
+			sphereVerts = geoGen.CreateSphere(1.0f, tessellation, tessellation).Vertices.size();
+		});
+
+		std::vector<GeometryGenerator::Vertex> scalarVertices;
+		double scalarSphereMs = TimeMs(repeatCount, [&]()
+		{
+			ScalarSphereVertices(1.0f, tessellation, tessellation, scalarVertices);
+		});
+
+		double cylinderMs = TimeMs(repeatCount, [&]()
+		{
+			cylinderVerts = geoGen.CreateCylinder(1.0f, 0.5f, 2.0f, tessellation, tessellation).Vertices.size();
+		});
+
+		double coneMs = TimeMs(repeatCount, [&]()
+		{
+			coneVerts = geoGen.CreateCone(1.0f, 2.0f, tessellation, tessellation).Vertices.size();
+		});
+
+		std::ostringstream ss;
+		ss << "Ring generation " << tessellation << "x" << tessellation
+		   << ": sphere " << sphereMs << " ms (" << sphereVerts << " verts, scalar vertices " << scalarSphereMs << " ms)"
+		   << ", cylinder " << cylinderMs << " ms (" << cylinderVerts << " verts)"
+		   << ", cone " << coneMs << " ms (" << coneVerts << " verts)\n";
+		Report(ss);
+	}
+
+	// The projection of the subdivided icosahedron is timed against the
+	// subdivision it follows.
+	GeometryGenerator::MeshData icosahedron = geoGen.CreateGeosphere(1.0f, 0);
+
+	size_t geosphereVerts = 0;
+	double geosphereMs = TimeMs(5, [&]()
+	{
+		geosphereVerts = geoGen.CreateGeosphere(1.0f, 6).Vertices.size();
+	});
+
+	double subdivideMs = TimeMs(5, [&]()
+	{
+		GeometryGenerator::MeshData mesh = icosahedron;
+		for(int i = 0; i < 6; ++i)
+			geoGen.Subdivide(mesh);
+	});
+
+	std::ostringstream ss;
+	ss << "Ring generation geosphere level 6: " << geosphereMs << " ms (" << geosphereVerts
+	   << " verts), of which subdivision " << subdivideMs << " ms\n";
+	Report(ss);
+}
+
+void BenchmarkSweep()
+{
+	using namespace DirectX;
+
+	GeometryGenerator geoGen;
+
+	for(GeometryGenerator::uint32 tessellation : { 64u, 512u })
+	{
+		const int repeatCount = tessellation < 512 ? 20 : 5;
+
+		// The same surfaces from the earlier per-shape ring path and from lathe
+		// profiles through the sweep kernel, which CreateSphere and CreateCylinder
+		// now also use.
+		std::vector<XMFLOAT2> sphereProfile;
+		for(GeometryGenerator::uint32 i = 0; i <= tessellation; ++i)
+		{
+			float phi = XM_PI*i/tessellation;
+			sphereProfile.push_back(XMFLOAT2(sinf(phi), -cosf(phi)));
+		}
+
+		std::vector<XMFLOAT2> cylinderProfile;
+		cylinderProfile.push_back(XMFLOAT2(0.0f, -1.0f));
+		cylinderProfile.push_back(XMFLOAT2(1.0f, -1.0f));
+		for(GeometryGenerator::uint32 i = 0; i <= tessellation; ++i)
+			cylinderProfile.push_back(XMFLOAT2(1.0f, -1.0f + 2.0f*i/tessellation));
+		cylinderProfile.push_back(XMFLOAT2(1.0f, 1.0f));
+		cylinderProfile.push_back(XMFLOAT2(0.0f, 1.0f));
+
+		double sphereMs = TimeMs(repeatCount, [&]() { RingSphere(1.0f, tessellation, tessellation); });
+		double sphereLatheMs = TimeMs(repeatCount, [&]() { geoGen.CreateLathe(sphereProfile, tessellation); });
+		double cylinderMs = TimeMs(repeatCount, [&]() { RingCylinder(1.0f, 2.0f, tessellation, tessellation); });
+		double cylinderLatheMs = TimeMs(repeatCount, [&]() { geoGen.CreateLathe(cylinderProfile, tessellation); });
+
+		std::ostringstream ss;
+		ss << "Sweep " << tessellation << "x" << tessellation
+		   << ": sphere rings " << sphereMs << " ms, lathe " << sphereLatheMs << " ms"
+		   << "; cylinder rings " << cylinderMs << " ms, lathe " << cylinderLatheMs << " ms\n";
+		Report(ss);
+	}
+
+	std::vector<XMFLOAT3> path;
+	std::vector<float> radii;
+	std::vector<XMFLOAT2> profile;
+
+	CandyCanePath(128, path, radii);
+	size_t caneVerts = 0;
+	double caneMs = TimeMs(20, [&]() { caneVerts = geoGen.CreateExtrusion(path, radii, 32).Vertices.size(); });
+
+	// Every normal of the closed sweeps must be a unit vector, the end caps included.
+	size_t badNormals = CountBadNormals(geoGen.CreateExtrusion(path, radii, 32));
+
+	// A six pointed star section gives the cane its ridges.
+	std::vector<XMFLOAT2> star;
+	for(int i = 0; i < 12; ++i)
+	{
+		float angle = XM_2PI*i/12;
+		float r = (i % 2) ? 0.11f : 0.15f;
+		star.push_back(XMFLOAT2(r*cosf(angle), r*sinf(angle)));
+	}
+	size_t ridgedCaneVerts = 0;
+	double ridgedCaneMs = TimeMs(20, [&]() { ridgedCaneVerts = geoGen.CreateExtrusion(path, radii, star).Vertices.size(); });
+	badNormals += CountBadNormals(geoGen.CreateExtrusion(path, radii, star));
+
+	// Closed straight tubes along y and x, which start with no direction to follow.
+	badNormals += CountBadNormals(geoGen.CreateExtrusion(
+		{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, 2.0f, 0.0f) },
+		{ 0.0f, 0.5f, 0.5f, 0.5f, 0.0f }, 16));
+	badNormals += CountBadNormals(geoGen.CreateExtrusion(
+		{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) },
+		{ 0.0f, 0.5f, 0.5f, 0.0f }, 16));
+
+	LollipopProfile(16, profile);
+	size_t lollipopVerts = 0;
+	double lollipopMs = TimeMs(20, [&]() { lollipopVerts = geoGen.CreateLathe(profile, 64).Vertices.size(); });
+
+	SwirlPath(512, path, radii);
+	size_t swirlVerts = 0;
+	double swirlMs = TimeMs(20, [&]() { swirlVerts = geoGen.CreateExtrusion(path, radii, 16).Vertices.size(); });
+
+	std::ostringstream ss;
+	ss << "Sweep candies: cane " << caneMs << " ms (" << caneVerts << " verts)"
+	   << ", ridged cane " << ridgedCaneMs << " ms (" << ridgedCaneVerts << " verts)"
+	   << ", lollipop " << lollipopMs << " ms (" << lollipopVerts << " verts)"
+	   << ", swirl " << swirlMs << " ms (" << swirlVerts << " verts)"
+	   << (badNormals == 0 ? "\n" : ", BAD NORMALS\n");
+	Report(ss);
+}
+
+void BenchmarkUploadRing()
+{
+	using namespace DirectX;
+
+	// The per object constants, padded as a constant buffer.
+	const size_t constantsByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+
+	const int frameCount = 60;
+	const int framesInFlight = 3;
+
+	for(size_t objectCount : { 1000, 10000, 100000 })
+	{
+		ObjectConstants constants;
+		constants.World.Store(XMMatrixIdentity());
+
+		// One fixed slot per object in each frame's buffer, as UploadBuffer::CopyData
+		// writes them.
+		std::vector<std::uint8_t> slots(framesInFlight*objectCount*constantsByteSize);
+		double slotMs = TimeMs(frameCount, [&, frame = 0]() mutable
+		{
+			std::uint8_t* frameSlots = &slots[(frame++ % framesInFlight)*objectCount*constantsByteSize];
+			for(size_t i = 0; i < objectCount; ++i)
+				std::memcpy(&frameSlots[i*constantsByteSize], &constants, sizeof(ObjectConstants));
+		});
+
+		// The ring on host memory, with the "GPU" finishing each frame two frames
+		// after it was submitted.  Sized for one frame fewer than are in flight, so
+		// some allocations have to wait for a retire.
+		std::vector<std::uint8_t> memory((framesInFlight - 1)*objectCount*constantsByteSize + constantsByteSize);
+		UploadRing ring;
+		ring.Reset(memory.data(), 0, memory.size());
+
+		std::uint64_t fence = 0;
+		std::uint64_t stalls = 0;
+		double ringMs = TimeMs(frameCount, [&]()
+		{
+			for(size_t i = 0; i < objectCount; ++i)
+			{
+				UploadRing::Allocation allocation = ring.Push(constants, constantsByteSize);
+				while(allocation.CpuAddress == nullptr)
+				{
+					ring.Retire(ring.GetOldestFence());
+					stalls++;
+					allocation = ring.Push(constants, constantsByteSize);
+				}
+			}
+
+			ring.EndFrame(++fence);
+			if(fence > framesInFlight - 1)
+				ring.Retire(fence - (framesInFlight - 1));
+		});
+
+		std::ostringstream ss;
+		ss << "Upload ring " << objectCount << " objects: fixed slots " << slotMs << " ms, ring "
+		   << ringMs << " ms per frame; high water " << ring.GetFrameHighWater()/1024 << " KB per frame, "
+		   << ring.GetUsedHighWater()/1024 << " KB in flight of " << ring.GetCapacity()/1024 << " KB, "
+		   << stalls << " waits for a retire\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkObjectBuffer(ID3D12Device* device, ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* perObjectPso, ID3D12PipelineState* objectBufferPso)
+{
+	using namespace DirectX;
+	using Microsoft::WRL::ComPtr;
+
+	const size_t constantsByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+
+	const int frameCount = 20;
+
+	// The draws are recorded into a real command list, which is closed and thrown away
+	// without being executed, so only the CPU cost of recording is measured.
+	ComPtr<ID3D12CommandAllocator> allocator;
+	ComPtr<ID3D12GraphicsCommandList> commandList;
+	ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+	ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), perObjectPso,
+		IID_PPV_ARGS(&commandList)));
+	ThrowIfFailed(commandList->Close());
+
+	auto beginRecording = [&](ID3D12PipelineState* pso)
+	{
+		ThrowIfFailed(allocator->Reset());
+		ThrowIfFailed(commandList->Reset(allocator.Get(), pso));
+		commandList->SetGraphicsRootSignature(rootSignature);
+	};
+
+	for(size_t objectCount : { 1000, 10000, 100000 })
+	{
+		std::vector<XMFLOAT4X4> worlds(objectCount);
+		for(size_t i = 0; i < objectCount; ++i)
+			XMStoreFloat4x4(&worlds[i], XMMatrixTranslation((float)i, 0.0f, 0.0f));
+
+		UploadRingBuffer uploadRing(device, objectCount*constantsByteSize + 64*1024);
+		UploadRing& ring = uploadRing.Ring();
+
+		UploadBuffer<ObjectData> objectBuffer(device, (UINT)objectCount, false);
+
+		// Every object drawn on its own with its constants written and bound per draw.
+		double perObjectMs = TimeMs(frameCount, [&]()
+		{
+			beginRecording(perObjectPso);
+			for(size_t i = 0; i < objectCount; ++i)
+			{
+				ObjectConstants constants;
+				constants.World.Store(XMLoadFloat4x4(&worlds[i]));
+
+				UploadRing::Allocation allocation = ring.Push(constants, constantsByteSize);
+				commandList->SetGraphicsRootConstantBufferView(0, allocation.GpuAddress);
+				commandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+			}
+			ThrowIfFailed(commandList->Close());
+
+			ring.EndFrame(1);
+			ring.Retire(1);
+		});
+
+		// Through the object buffer: one SRV for the frame, an index per draw, and
+		// object data only for the objects that moved, here none or all of them.
+		auto objectBufferFrame = [&](bool allMoved)
+		{
+			beginRecording(objectBufferPso);
+			if(allMoved)
+			{
+				for(size_t i = 0; i < objectCount; ++i)
+				{
+					ObjectData data;
+					data.World.Store(XMLoadFloat4x4(&worlds[i]));
+					objectBuffer.CopyData((int)i, data);
+				}
+			}
+
+			commandList->SetGraphicsRootShaderResourceView(2, objectBuffer.Resource()->GetGPUVirtualAddress());
+
+			UploadRing::Allocation allocation = ring.Allocate(objectCount*sizeof(std::uint32_t), 16);
+			std::uint32_t* objectIndices = reinterpret_cast<std::uint32_t*>(allocation.CpuAddress);
+			for(size_t i = 0; i < objectCount; ++i)
+			{
+				objectIndices[i] = (std::uint32_t)i;
+				commandList->DrawIndexedInstanced(36, 1, 0, 0, (UINT)i);
+			}
+			ThrowIfFailed(commandList->Close());
+
+			ring.EndFrame(1);
+			ring.Retire(1);
+		};
+		double staticMs = TimeMs(frameCount, [&]() { objectBufferFrame(false); });
+		double movingMs = TimeMs(frameCount, [&]() { objectBufferFrame(true); });
+
+		std::ostringstream ss;
+		ss << "Object buffer " << objectCount << " objects recorded: per object CBVs " << perObjectMs << " ms ("
+		   << objectCount*constantsByteSize/1024 << " KB), object buffer " << staticMs << " ms static ("
+		   << objectCount*sizeof(std::uint32_t)/1024 << " KB), " << movingMs << " ms all moving ("
+		   << objectCount*(sizeof(ObjectData) + sizeof(std::uint32_t))/1024 << " KB)\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkAffineTransform()
+{
+	using namespace DirectX;
+
+	const size_t objectCount = 100000;
+	const size_t paddedByteSize = 256;
+
+	std::vector<XMFLOAT4X4> matrices(objectCount);
+	for(size_t i = 0; i < objectCount; ++i)
+	{
+		XMMATRIX world = XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixRotationY(0.001f*i)*XMMatrixTranslation((float)i, 0.0f, 0.0f);
+		XMStoreFloat4x4(&matrices[i], world);
+	}
+
+	// What UpdateObjectCBs did before: the whole matrix transposed into a constant
+	// buffer slot padded to 256 bytes.
+	std::vector<std::uint8_t> padded(objectCount*paddedByteSize);
+	double paddedMs = TimeMs(20, [&]()
+	{
+		for(size_t i = 0; i < objectCount; ++i)
+		{
+			XMFLOAT4X4 transposed;
+			XMStoreFloat4x4(&transposed, XMMatrixTranspose(XMLoadFloat4x4(&matrices[i])));
+			std::memcpy(&padded[i*paddedByteSize], &transposed, sizeof(transposed));
+		}
+	});
+
+	std::vector<AffineTransform> transforms(objectCount);
+	double packMs = TimeMs(20, [&]()
+	{
+		for(size_t i = 0; i < objectCount; ++i)
+			transforms[i].Store(XMLoadFloat4x4(&matrices[i]));
+	});
+
+	// The packed transforms must rebuild the original matrices.
+	float maxError = 0.0f;
+	for(size_t i = 0; i < objectCount; ++i)
+	{
+		XMMATRIX rebuilt = transforms[i].Load();
+		XMMATRIX original = XMLoadFloat4x4(&matrices[i]);
+		for(int r = 0; r < 4; ++r)
+			maxError = std::max(maxError, XMVectorGetX(XMVector4LengthSq(rebuilt.r[r] - original.r[r])));
+	}
+
+	std::ostringstream ss;
+	ss << "Affine transforms " << objectCount << ": padded 4x4 " << paddedMs << " ms (" << paddedByteSize
+	   << " bytes each), 3x4 " << packMs << " ms (" << sizeof(AffineTransform)
+	   << " bytes each), max squared error " << maxError << "\n";
+	Report(ss);
+}
+
+void BenchmarkDirtyObjects()
+{
+	using namespace DirectX;
+
+	// Same layout as ObjectData.
+	struct Object
+	{
+		AffineTransform World;
+		XMFLOAT4 Color;
+	};
+
+	const size_t objectCount = 100000;
+
+	std::vector<Object> objects(objectCount);
+	std::vector<Object> mapped(objectCount);
+
+	struct Case
+	{
+		const char* Name;
+		size_t Count;
+		bool Scattered;
+	};
+	const Case cases[] =
+	{
+		{ "none", 0, false },
+		{ "100 scattered", 100, true },
+		{ "1000 in a block", 1000, false },
+		{ "10000 scattered", 10000, true },
+		{ "all", objectCount, false },
+	};
+
+	for(const Case& c : cases)
+	{
+		// The changed objects, scattered with a stride coprime to the count or in one
+		// block, queued in the order they changed.
+		std::vector<std::uint32_t> changed;
+		for(size_t i = 0; i < c.Count; ++i)
+			changed.push_back((std::uint32_t)(c.Scattered ? (i*7919) % objectCount : i));
+
+		// What UpdateObjectCBs did before: a dirty counter per object, scanned every frame.
+		std::vector<int> framesDirty(objectCount, 0);
+		double scanMs = TimeMs(20, [&]()
+		{
+			for(std::uint32_t i : changed)
+				framesDirty[i] = 1;
+
+			for(size_t i = 0; i < objectCount; ++i)
+			{
+				if(framesDirty[i] > 0)
+				{
+					mapped[i] = objects[i];
+					framesDirty[i]--;
+				}
+			}
+		});
+
+		// The dirty list: sorted, or for a large share of the objects gathered in
+		// order from the per object flags, then one copy per run of consecutive indices.
+		std::vector<std::uint8_t> flags(objectCount, 0);
+		std::vector<std::uint32_t> dirty;
+		size_t copyCount = 0;
+		double listMs = TimeMs(20, [&]()
+		{
+			dirty = changed;
+			for(std::uint32_t i : changed)
+				flags[i] = 1;
+
+			if(dirty.size()*32 > objectCount)
+			{
+				dirty.clear();
+				for(size_t i = 0; i < objectCount; ++i)
+				{
+					if(flags[i])
+						dirty.push_back((std::uint32_t)i);
+				}
+			}
+			else
+			{
+				std::sort(dirty.begin(), dirty.end());
+			}
+
+			copyCount = 0;
+			for(size_t first = 0; first < dirty.size(); )
+			{
+				size_t last = first + 1;
+				while(last < dirty.size() && dirty[last] == dirty[last - 1] + 1)
+					++last;
+
+				std::memcpy(&mapped[dirty[first]], &objects[dirty[first]], (last - first)*sizeof(Object));
+				copyCount++;
+
+				for(size_t k = first; k < last; ++k)
+					flags[dirty[k]] = 0;
+
+				first = last;
+			}
+		});
+
+		std::ostringstream ss;
+		ss << "Dirty objects " << c.Name << " of " << objectCount << ": scan " << scanMs << " ms, dirty list "
+		   << listMs << " ms in " << copyCount << " copies\n";
+		Report(ss);
+	}
+}
+
+void BenchmarkParallelObjectUpdate()
+{
+	using namespace DirectX;
+
+	const size_t objectCount = 100000;
+
+	// 256 transforms of 48 bytes are three 4KB pages, so with the output starting on a
+	// page boundary no two chunks share a page.
+	const size_t chunkSize = 256;
+	const size_t pageSize = 4096;
+	const size_t chunkCount = (objectCount + chunkSize - 1)/chunkSize;
+
+	std::vector<XMFLOAT4X4> matrices(objectCount);
+	for(size_t i = 0; i < objectCount; ++i)
+	{
+		XMMATRIX world = XMMatrixRotationY(0.001f*i)*XMMatrixTranslation((float)i, 0.0f, (float)(i % 7));
+		XMStoreFloat4x4(&matrices[i], world);
+	}
+
+	// Stands in for the mapped upload buffer.
+	std::vector<std::uint8_t> memory(objectCount*sizeof(AffineTransform) + pageSize);
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(memory.data());
+	AffineTransform* mapped = reinterpret_cast<AffineTransform*>((base + pageSize - 1) & ~(std::uintptr_t)(pageSize - 1));
+
+	// Load, transpose and store one chunk.
+	auto updateChunk = [&](size_t chunk)
+	{
+		size_t last = std::min(objectCount, (chunk + 1)*chunkSize);
+		for(size_t i = chunk*chunkSize; i < last; ++i)
+			mapped[i].Store(XMLoadFloat4x4(&matrices[i]));
+	};
+
+	// The single threaded result every other thread count must match exactly.
+	std::vector<AffineTransform> reference(objectCount);
+	for(size_t i = 0; i < objectCount; ++i)
+		reference[i].Store(XMLoadFloat4x4(&matrices[i]));
+
+	double serialMs = TimeMs(20, [&]()
+	{
+		for(size_t chunk = 0; chunk < chunkCount; ++chunk)
+			updateChunk(chunk);
+	});
+
+	std::ostringstream ss;
+	ss << "Parallel object update " << objectCount << " objects in " << chunkCount << " chunks: 1 thread "
+	   << serialMs << " ms";
+
+	unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+	for(unsigned threadCount = 2; threadCount <= maxThreads; ++threadCount)
+	{
+		ThreadPool pool(threadCount - 1);
+		std::memset(memory.data(), 0, memory.size());
+
+		double ms = TimeMs(20, [&]() { pool.ParallelFor(chunkCount, updateChunk); });
+		bool identical = std::memcmp(mapped, reference.data(), objectCount*sizeof(AffineTransform)) == 0;
+
+		ss << ", " << threadCount << " threads " << ms << " ms (" << serialMs/ms << "x"
+		   << (identical ? ")" : ", MISMATCH)");
+	}
+	ss << "\n";
+	Report(ss);
+}
@@ -0,0 +1,30 @@
+//***************************************************************************************
+// Benchmarks.h
+//
+// CPU micro-benchmarks for the geometry and scene stages.  Results are written to the
+// debugger output window.  Build with SHAPES_RUN_BENCHMARKS defined to run them once
+// at startup.  The object buffer benchmark records real command lists, so it takes the
+// app's device, root signature and the PSOs of the two object paths.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+
+void RunBenchmarks(ID3D12Device* device, ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* perObjectPso, ID3D12PipelineState* objectBufferPso);
+
+void BenchmarkSubdivide();
+void BenchmarkBounds();
+void BenchmarkFrustumCull();
+void BenchmarkSceneBvh();
+void BenchmarkRenderQueueSort();
+void BenchmarkVertexQuantizer();
+void BenchmarkRingGeneration();
+void BenchmarkSweep();
+void BenchmarkUploadRing();
+void BenchmarkObjectBuffer(ID3D12Device* device, ID3D12RootSignature* rootSignature,
+	ID3D12PipelineState* perObjectPso, ID3D12PipelineState* objectBufferPso);
+void BenchmarkAffineTransform();
+void BenchmarkDirtyObjects();
+void BenchmarkParallelObjectUpdate();
@@ -1,13 +1,12 @@
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount)
+FrameResource::FrameResource(ID3D12Device* device, UINT objectCount)
 {
     ThrowIfFailed(device->CreateCommandAllocator(
         D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
-    PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
-    ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
+    ObjectBuffer = std::make_unique<UploadBuffer<ObjectData>>(device, objectCount > 0 ? objectCount : 1, false);
 }
 
 FrameResource::~FrameResource()
@@ -3,10 +3,33 @@
 #include "../../Common/d3dUtil.h"
 #include "../../Common/MathHelper.h"
 #include "../../Common/UploadBuffer.h"
+#include "../../Common/AffineTransform.h"
 
+// The world transform of every object is uploaded in 3x4 form: the shader reads it
+// as a row_major float3x4 and rebuilds the point transform from its three rows.
 struct ObjectConstants
 {
-    DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+    AffineTransform World;
+
+    // Every vertex of a mesh has the same color, so it is set per object instead of
+    // being repeated in the vertex buffer.
+    DirectX::XMFLOAT4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+// Per instance vertex data for instanced draws, the world transform as three rows of
+// WORLD.
+struct InstanceData
+{
+    AffineTransform World;
+    DirectX::XMFLOAT4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+// One entry of the per frame object buffer, read by the vertex shader as a
+// StructuredBuffer and indexed through the instance stream.  Tightly packed, 64 bytes.
+struct ObjectData
+{
+    AffineTransform World;
+    DirectX::XMFLOAT4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
 };
 
 struct PassConstants
@@ -27,19 +50,20 @@ struct PassConstants
     float DeltaTime = 0.0f;
 };
 
+// Position only, 12 bytes.  The color comes from the object constants.
 struct Vertex
 {
     DirectX::XMFLOAT3 Pos;
-    DirectX::XMFLOAT4 Color;
 };
 
 // Stores the resources needed for the CPU to build the command lists
-// for a frame.  
+// for a frame.  Constants and instance data are not kept here: they are allocated
+// from the upload ring each frame and freed with the frame's fence.
 struct FrameResource
 {
 public:
     
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount);
+    FrameResource(ID3D12Device* device, UINT objectCount);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
@@ -48,10 +72,14 @@ public:
     // So each frame needs their own allocator.
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
-    // We cannot update a cbuffer until the GPU is done processing the commands
-    // that reference it.  So each frame needs their own cbuffers.
-    std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-    std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
+    // ObjectData of every render item at its ObjCBIndex.  Unlike the ring data it
+    // persists between frames, so only the items that changed are rewritten; each
+    // frame resource has its own copy because the GPU may still read the others.
+    std::unique_ptr<UploadBuffer<ObjectData>> ObjectBuffer = nullptr;
+
+    // ObjCBIndex of the items changed since this frame resource's object buffer was
+    // last updated, each at most once.
+    std::vector<UINT> DirtyObjects;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
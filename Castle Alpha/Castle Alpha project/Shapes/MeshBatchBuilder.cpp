@@ -0,0 +1,205 @@
+//***************************************************************************************
+// MeshBatchBuilder.cpp
+//***************************************************************************************
+
+#include "MeshBatchBuilder.h"
+#include "../../Common/ThreadPool.h"
+
+MeshBatchBuilder::IndexWidth MeshBatchBuilder::GetRequiredWidth(const GeometryGenerator::MeshData& mesh)
+{
+	return mesh.Vertices.size() <= kMaxVerticesPerPage ? IndexWidth::Bits16 : IndexWidth::Bits32;
+}
+
+void MeshBatchBuilder::Add(const std::string& name, const GeometryGenerator::MeshData& mesh, const DirectX::XMFLOAT4& color,
+	IndexWidth minWidth)
+{
+	IndexWidth width = minWidth == IndexWidth::Bits32 ? IndexWidth::Bits32 : GetRequiredWidth(mesh);
+	mEntries.push_back({ name, &mesh, color, width });
+}
+
+UINT MeshBatchBuilder::AddPaged(const std::string& name, const GeometryGenerator::MeshData& mesh, const DirectX::XMFLOAT4& color)
+{
+	if(GetRequiredWidth(mesh) == IndexWidth::Bits16)
+	{
+		Add(name, mesh, color);
+		return 1;
+	}
+
+	//
+	// Walk the triangles in order, giving each vertex a local index the first time the
+	// current page uses it.  A triangle that would push the page past the limit starts
+	// a new one, so triangle order, and with it vertex cache order, is kept.
+	//
+
+	const GeometryGenerator::uint32 kUnassigned = 0xffffffff;
+
+	// Local index of each source vertex in the current page, valid when its entry in
+	// pageOfVertex is the current page.
+	std::vector<GeometryGenerator::uint32> localIndex(mesh.Vertices.size());
+	std::vector<UINT> pageOfVertex(mesh.Vertices.size(), kUnassigned);
+
+	UINT pageCount = 0;
+	GeometryGenerator::MeshData* page = nullptr;
+
+	for(size_t i = 0; i + 2 < mesh.Indices32.size(); i += 3)
+	{
+		const GeometryGenerator::uint32* tri = &mesh.Indices32[i];
+
+		size_t newVertices = 0;
+		if(page != nullptr)
+		{
+			for(int k = 0; k < 3; ++k)
+			{
+				bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+				if(pageOfVertex[tri[k]] != pageCount - 1 && !repeated)
+					++newVertices;
+			}
+		}
+
+		if(page == nullptr || page->Vertices.size() + newVertices > kMaxVerticesPerPage)
+		{
+			mPages.emplace_back();
+			page = &mPages.back();
+			++pageCount;
+		}
+
+		for(int k = 0; k < 3; ++k)
+		{
+			GeometryGenerator::uint32 v = tri[k];
+			if(pageOfVertex[v] != pageCount - 1)
+			{
+				pageOfVertex[v] = pageCount - 1;
+				localIndex[v] = (GeometryGenerator::uint32)page->Vertices.size();
+				page->Vertices.push_back(mesh.Vertices[v]);
+			}
+
+			page->Indices32.push_back(localIndex[v]);
+		}
+	}
+
+	for(UINT i = 0; i < pageCount; ++i)
+	{
+		const GeometryGenerator::MeshData& pageMesh = mPages[mPages.size() - pageCount + i];
+		Add(name + "_page" + std::to_string(i), pageMesh, color);
+	}
+
+	mPageCounts[name] = pageCount;
+	return pageCount;
+}
+
+void MeshBatchBuilder::Build(ThreadPool* pool)
+{
+	//
+	// Exclusive prefix sums of the vertex and index counts give every mesh its
+	// location in its batch, and the totals size the buffers in one allocation.
+	//
+
+	std::vector<SubmeshGeometry> submeshes(mEntries.size());
+
+	size_t vertexCounts[2] = {};
+	size_t indexCounts[2] = {};
+	for(size_t i = 0; i < mEntries.size(); ++i)
+	{
+		const GeometryGenerator::MeshData& mesh = *mEntries[i].Mesh;
+		int batch = (int)mEntries[i].Width;
+
+		submeshes[i].IndexCount = (UINT)mesh.Indices32.size();
+		submeshes[i].StartIndexLocation = (UINT)indexCounts[batch];
+		submeshes[i].BaseVertexLocation = (INT)vertexCounts[batch];
+
+		vertexCounts[batch] += mesh.Vertices.size();
+		indexCounts[batch] += mesh.Indices32.size();
+	}
+
+	for(int batch = 0; batch < 2; ++batch)
+		mBatches[batch].Vertices.resize(vertexCounts[batch]);
+
+	mIndices16.resize(indexCounts[(int)IndexWidth::Bits16]);
+	mIndices32.resize(indexCounts[(int)IndexWidth::Bits32]);
+
+	// Each mesh writes only its own ranges.  The indices are narrowed here rather than
+	// through MeshData::GetIndices16, which caches into the mesh and is not safe to call
+	// from several threads on a mesh added more than once.
+	auto fill = [&](size_t i)
+	{
+		const Entry& entry = mEntries[i];
+		const GeometryGenerator::MeshData& mesh = *entry.Mesh;
+
+		Vertex* vertices = mBatches[(int)entry.Width].Vertices.data() + submeshes[i].BaseVertexLocation;
+		for(size_t v = 0; v < mesh.Vertices.size(); ++v)
+			vertices[v].Pos = mesh.Vertices[v].Position;
+
+		if(entry.Width == IndexWidth::Bits16)
+		{
+			std::uint16_t* indices = mIndices16.data() + submeshes[i].StartIndexLocation;
+			for(size_t n = 0; n < mesh.Indices32.size(); ++n)
+				indices[n] = static_cast<std::uint16_t>(mesh.Indices32[n]);
+		}
+		else
+		{
+			std::copy(mesh.Indices32.begin(), mesh.Indices32.end(), mIndices32.begin() + submeshes[i].StartIndexLocation);
+		}
+	};
+
+	if(pool != nullptr)
+		pool->ParallelFor(mEntries.size(), fill);
+	else
+	{
+		for(size_t i = 0; i < mEntries.size(); ++i)
+			fill(i);
+	}
+
+	for(Batch& batch : mBatches)
+		batch.DrawArgs.clear();
+	mColors.clear();
+
+	for(size_t i = 0; i < mEntries.size(); ++i)
+	{
+		mBatches[(int)mEntries[i].Width].DrawArgs[mEntries[i].Name] = submeshes[i];
+		mColors[mEntries[i].Name] = mEntries[i].Color;
+	}
+
+	for(const auto& paged : mPageCounts)
+		mColors[paged.first] = mColors.at(paged.first + "_page0");
+}
+
+std::vector<Vertex>& MeshBatchBuilder::GetVertices(IndexWidth width)
+{
+	return mBatches[(int)width].Vertices;
+}
+
+std::vector<std::uint16_t>& MeshBatchBuilder::GetIndices16()
+{
+	return mIndices16;
+}
+
+std::vector<std::uint32_t>& MeshBatchBuilder::GetIndices32()
+{
+	return mIndices32;
+}
+
+std::unordered_map<std::string, SubmeshGeometry>& MeshBatchBuilder::GetDrawArgs(IndexWidth width)
+{
+	return mBatches[(int)width].DrawArgs;
+}
+
+const std::unordered_map<std::string, DirectX::XMFLOAT4>& MeshBatchBuilder::GetColors()const
+{
+	return mColors;
+}
+
+const std::unordered_map<std::string, UINT>& MeshBatchBuilder::GetPageCounts()const
+{
+	return mPageCounts;
+}
+
+const SubmeshGeometry& MeshBatchBuilder::GetSubmesh(const std::string& name)const
+{
+	return mBatches[(int)GetIndexWidth(name)].DrawArgs.at(name);
+}
+
+MeshBatchBuilder::IndexWidth MeshBatchBuilder::GetIndexWidth(const std::string& name)const
+{
+	const auto& drawArgs16 = mBatches[(int)IndexWidth::Bits16].DrawArgs;
+	return drawArgs16.find(name) != drawArgs16.end() ? IndexWidth::Bits16 : IndexWidth::Bits32;
+}
@@ -0,0 +1,111 @@
+//***************************************************************************************
+// MeshBatchBuilder.h
+//
+// Packs a list of named meshes into shared vertex and index buffers.  Every mesh's
+// offsets are worked out up front with a prefix sum over the vertex and index counts,
+// so the buffers are allocated once at their final size and the meshes are copied
+// straight into place in parallel.
+//
+// Indices are relative to a submesh's BaseVertexLocation, so any mesh of up to 64K
+// vertices is packed with 16-bit indices wherever it lands in the buffer.  Larger
+// meshes are split into 16-bit pages of up to 64K vertices each, drawn one per page.
+// Only a mesh that must be drawn as a single range, like the source of a LOD chain or
+// a mesh split into meshlets, falls back to a second batch with 32-bit indices.
+//***************************************************************************************
+
+#pragma once
+
+#include "../../Common/d3dUtil.h"
+#include "../../Common/GeometryGenerator.h"
+#include "FrameResource.h"
+#include <deque>
+
+class ThreadPool;
+
+class MeshBatchBuilder
+{
+public:
+	enum class IndexWidth
+	{
+		Bits16,
+		Bits32
+	};
+
+	// Vertices one 16-bit indexed draw can reach from its base vertex.
+	static const size_t kMaxVerticesPerPage = 65536;
+
+	///<summary>
+	/// The narrowest index width that can address every vertex of mesh.
+	///</summary>
+	static IndexWidth GetRequiredWidth(const GeometryGenerator::MeshData& mesh);
+
+	///<summary>
+	/// Queues mesh to be packed under name as one range, to be drawn in color.  It goes
+	/// in the 16-bit batch if it fits and minWidth allows, otherwise in the 32-bit batch;
+	/// meshes that must be drawn from the same buffers, like the levels of a LOD chain,
+	/// should be given the widest width any of them needs.  The mesh is read during
+	/// Build, so it must stay alive and unchanged until then.
+	///</summary>
+	void Add(const std::string& name, const GeometryGenerator::MeshData& mesh, const DirectX::XMFLOAT4& color,
+		IndexWidth minWidth = IndexWidth::Bits16);
+
+	///<summary>
+	/// Queues mesh like Add, but keeps it on 16-bit indices by splitting it into pages
+	/// of at most kMaxVerticesPerPage vertices, drawn one per page.  Vertices shared by
+	/// triangles in different pages are duplicated.  A mesh that fits is added as-is
+	/// under name; otherwise page i is named "<name>_page<i>".  Returns the page count.
+	///</summary>
+	UINT AddPaged(const std::string& name, const GeometryGenerator::MeshData& mesh, const DirectX::XMFLOAT4& color);
+
+	///<summary>
+	/// Packs the queued meshes in the order they were added, one ThreadPool piece per
+	/// mesh.  pool may be null to run on the calling thread.
+	///</summary>
+	void Build(ThreadPool* pool);
+
+	std::vector<Vertex>& GetVertices(IndexWidth width);
+	std::vector<std::uint16_t>& GetIndices16();
+	std::vector<std::uint32_t>& GetIndices32();
+
+	// Where each mesh of a batch ended up, keyed by the name it was added under.
+	std::unordered_map<std::string, SubmeshGeometry>& GetDrawArgs(IndexWidth width);
+
+	// Color each mesh was added with, keyed by name.  Vertices only hold positions, so
+	// the color is up to whatever draws the mesh.  A paged mesh has its color under its
+	// own name as well as under its pages'.
+	const std::unordered_map<std::string, DirectX::XMFLOAT4>& GetColors()const;
+
+	// Names of the meshes AddPaged split, with their page counts.
+	const std::unordered_map<std::string, UINT>& GetPageCounts()const;
+
+	// Looks name up in both batches.
+	const SubmeshGeometry& GetSubmesh(const std::string& name)const;
+	IndexWidth GetIndexWidth(const std::string& name)const;
+
+private:
+	struct Entry
+	{
+		std::string Name;
+		const GeometryGenerator::MeshData* Mesh;
+		DirectX::XMFLOAT4 Color;
+		IndexWidth Width;
+	};
+
+	struct Batch
+	{
+		std::vector<Vertex> Vertices;
+		std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
+	};
+
+	std::vector<Entry> mEntries;
+
+	// Pages split off by AddPaged.  A deque so the entries' pointers stay valid.
+	std::deque<GeometryGenerator::MeshData> mPages;
+	std::unordered_map<std::string, UINT> mPageCounts;
+
+	Batch mBatches[2];
+	std::vector<std::uint16_t> mIndices16;
+	std::vector<std::uint32_t> mIndices32;
+
+	std::unordered_map<std::string, DirectX::XMFLOAT4> mColors;
+};
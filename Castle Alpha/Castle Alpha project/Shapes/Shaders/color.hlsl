@@ -4,9 +4,12 @@
 // Transforms and colors geometry.
 //***************************************************************************************
  
+// World transforms are affine, so only the three rows that produce x, y and z are
+// sent; see AffineTransform.h.
 cbuffer cbPerObject : register(b0)
 {
-	float4x4 gWorld; 
+	row_major float3x4 gWorld; 
+	float4 gColor;
 };
 
 cbuffer cbPass : register(b1)
@@ -27,12 +30,37 @@ cbuffer cbPass : register(b1)
     float gDeltaTime;
 };
 
+// Object data of every render item, used by VSObjectBuffer.
+struct ObjectData
+{
+    row_major float3x4 World;
+    float4 Color;
+};
+
+StructuredBuffer<ObjectData> gObjects : register(t0);
+
 struct VertexIn
 {
 	float3 PosL  : POSITION;
+};
+
+// Instanced draws take the world matrix and color from a second, per instance vertex
+// buffer.
+struct InstancedVertexIn
+{
+	float3 PosL  : POSITION;
+    row_major float3x4 World : WORLD;
     float4 Color : COLOR;
 };
 
+// Draws through the object buffer step an index per instance from the instance
+// stream.  The stream honors StartInstanceLocation, which SV_InstanceID does not.
+struct ObjectVertexIn
+{
+	float3 PosL  : POSITION;
+    uint ObjectIndex : OBJECTINDEX;
+};
+
 struct VertexOut
 {
 	float4 PosH  : SV_POSITION;
@@ -44,15 +72,41 @@ VertexOut VS(VertexIn vin)
 	VertexOut vout;
 	
 	// Transform to homogeneous clip space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
-    vout.PosH = mul(posW, gViewProj);
+    float3 posW = mul(gWorld, float4(vin.PosL, 1.0f));
+    vout.PosH = mul(float4(posW, 1.0f), gViewProj);
 	
-	// Just pass vertex color into the pixel shader.
-    vout.Color = vin.Color;
+	// Just pass the object color into the pixel shader.
+    vout.Color = gColor;
     
     return vout;
 }
 
+VertexOut VSInstanced(InstancedVertexIn vin)
+{
+	VertexOut vout;
+
+    float3 posW = mul(vin.World, float4(vin.PosL, 1.0f));
+    vout.PosH = mul(float4(posW, 1.0f), gViewProj);
+
+    vout.Color = vin.Color;
+
+    return vout;
+}
+
+VertexOut VSObjectBuffer(ObjectVertexIn vin)
+{
+	VertexOut vout;
+
+    ObjectData object = gObjects[vin.ObjectIndex];
+
+    float3 posW = mul(object.World, float4(vin.PosL, 1.0f));
+    vout.PosH = mul(float4(posW, 1.0f), gViewProj);
+
+    vout.Color = object.Color;
+
+    return vout;
+}
+
 float4 PS(VertexOut pin) : SV_Target
 {
     return pin.Color;
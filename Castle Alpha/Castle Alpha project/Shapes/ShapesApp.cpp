@@ -2,13 +2,30 @@
 // ShapesApp.cpp by Macro Orders (C) 2015 All Rights Reserved.
 //
 // Hold down '1' key to view scene in wireframe mode.
+// Hold down '2' key to bind per object constant buffers instead of the object buffer.
 //***************************************************************************************
 
 #include "../../Common/d3dApp.h"
 #include "../../Common/MathHelper.h"
+#include "../../Common/AffineTransform.h"
 #include "../../Common/UploadBuffer.h"
 #include "../../Common/GeometryGenerator.h"
+#include "../../Common/MeshOptimizer.h"
+#include "../../Common/MeshSimplifier.h"
+#include "../../Common/MeshletBuilder.h"
+#include "../../Common/BoundsUtil.h"
+#include "../../Common/FrustumCuller.h"
+#include "../../Common/SceneBvh.h"
+#include "../../Common/OcclusionCuller.h"
+#include "../../Common/ThreadPool.h"
+#include "../../Common/RenderQueue.h"
 #include "FrameResource.h"
+#include "MeshBatchBuilder.h"
+#include "Benchmarks.h"
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <tuple>
 
 #define deg2rad(x)(x * 3.14159265358979323846 / 180)
 
@@ -18,6 +35,104 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// A LOD level is used while its simplification error covers less than this many pixels.
+const float gLodPixelError = 1.0f;
+
+// Fraction of gLodPixelError a level must be under before switching to it, or over
+// before switching away, so objects near a threshold do not flicker between levels.
+const float gLodHysteresis = 0.25f;
+
+// Scenes with at least this many items are culled through the BVH instead of testing
+// every box; below it the flat SIMD loop is faster than walking the tree.  Holding '3'
+// culls through the BVH at any size, to compare the two paths on the same scene.
+const size_t gBvhCullThreshold = 1024;
+
+// Submeshes rasterized into the software depth buffer as occluders: the castle walls,
+// which hide most of the interior from outside.
+const char* const gOccluderDrawArgs[] = { "boxthree", "boxfour", "boxfive", "boxsix" };
+
+// Size of the software depth buffer occluders are rasterized into.
+const UINT gOcclusionBufferWidth = 256;
+const UINT gOcclusionBufferHeight = 128;
+
+// Pipeline state objects by the id stored in a draw packet's sort key.  The instanced
+// variants are the plain ones plus gInstancedPsoOffset, and the ones reading the
+// object buffer plus gObjectBufferPsoOffset.
+const char* const gPsoNames[] = { "opaque", "opaque_wireframe", "opaque_instanced", "opaque_instanced_wireframe",
+	"opaque_objects", "opaque_objects_wireframe" };
+const UINT gInstancedPsoOffset = 2;
+const UINT gObjectBufferPsoOffset = 4;
+
+// Once more than 1/gDirtySortRatio of the objects changed, the dirty ones are found by
+// walking the per object flags in index order instead of sorting the queue.
+const size_t gDirtySortRatio = 32;
+
+// Objects one worker updates when the object buffer update is split across the thread
+// pool.  The buffer starts on a 64KB boundary, so chunks of whole 4KB pages keep any
+// two workers from writing the same write-combined page or cache line.
+const size_t gObjectChunkSize = 256;
+static_assert(gObjectChunkSize*sizeof(ObjectData) % 4096 == 0, "object chunks must be whole pages");
+
+// Dirty objects below which the update stays on the calling thread.
+const size_t gParallelObjectThreshold = 4096;
+
+// Smallest upload ring created.  It is sized for the scene at startup and grows when
+// a single frame fills it.
+const UINT64 gMinUploadRingByteSize = 64*1024;
+
+// Visible items sharing draw arguments are drawn as one instanced draw once there are
+// at least this many of them.
+const size_t gMinInstanceCount = 2;
+
+// One level of a submesh's LOD chain: the DrawArgs name and draw arguments of the level
+// and the object space error it was simplified to.
+struct LodLevel
+{
+	std::string DrawArg;
+	SubmeshGeometry Submesh;
+	float Error = 0.0f;
+};
+
+// Simplified versions of a submesh, full detail first.
+struct LodChain
+{
+	// Object space bounds of the full detail mesh.
+	BoundingSphere Bounds;
+
+	std::vector<LodLevel> Levels;
+};
+
+// Per frame counters, written to the debug output once a second.
+struct FrameStats
+{
+	UINT LodTrianglesFull = 0;
+	UINT LodTrianglesDrawn = 0;
+	UINT LodSwitches = 0;
+	UINT MeshletsDrawn = 0;
+	UINT MeshletsCulled = 0;
+	UINT ItemsVisible = 0;
+	UINT ItemsCulled = 0;
+	double CullMs = 0.0;
+	bool CullUsedBvh = false;
+	double BvhRefitMs = 0.0;
+	UINT OccluderTriangles = 0;
+	UINT ItemsOccluded = 0;
+	double OcclusionRasterMs = 0.0;
+	double OcclusionMs = 0.0;
+	UINT DrawPackets = 0;
+	UINT Draws = 0;
+	UINT PsoBinds = 0;
+	UINT GeometryBinds = 0;
+	UINT TopologyBinds = 0;
+	double SortMs = 0.0;
+	double SubmitMs = 0.0;
+	UINT ObjectsUpdated = 0;
+	UINT ObjectCopies = 0;
+	UINT ObjectChunks = 0;
+	UINT InstancedDraws = 0;
+	UINT InstancedItems = 0;
+};
+
 // Lightweight structure stores parameters to draw a shape.  This will
 // vary from app-to-app.
 struct RenderItem
@@ -26,20 +141,27 @@ struct RenderItem
 
     // World matrix of the shape that describes the object's local space
     // relative to the world space, which defines the position, orientation,
-    // and scale of the object in the world.
-    XMFLOAT4X4 World = MathHelper::Identity4x4();
-
-	// Dirty flag indicating the object data has changed and we need to update the constant buffer.
-	// Because we have an object cbuffer for each FrameResource, we have to apply the
-	// update to each FrameResource.  Thus, when we modify obect data we should set 
-	// NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-	int NumFramesDirty = gNumFrameResources;
+    // and scale of the object in the world.  Kept in the 3x4 form it is uploaded in.
+    // After changing it or Color, call MarkObjectDirty so the object buffers and the
+    // culling bounds see it.
+    AffineTransform World;
 
-	// Index into GPU constant buffer corresponding to the ObjectCB for this render item.
+	// Index into the object buffer of the ObjectData for this render item.
 	UINT ObjCBIndex = -1;
 
+	// Index of the item in mOpaqueRitems, and so of its world bounds and culler box.
+	UINT CullIndex = -1;
+
 	MeshGeometry* Geo = nullptr;
 
+	// Name of the submesh in Geo->DrawArgs the item was created to draw.  Its bounds,
+	// color, LOD chain, meshlets and occluder flag are looked up by this name, since
+	// several names can share one deduplicated range.
+	std::string DrawArg;
+
+	// Small id of Geo for draw sort keys.
+	UINT GeoSortId = 0;
+
     // Primitive topology.
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
@@ -47,6 +169,44 @@ struct RenderItem
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+	// Object space bounds of the submesh drawn, or of its full detail level.
+	BoundingBox Bounds;
+
+	// LOD chain of the submesh drawn, if it has one.  The draw arguments above are then
+	// rewritten from the selected level every frame.
+	const LodChain* Lods = nullptr;
+	UINT LodIndex = 0;
+
+	// Meshlets of the full detail submesh, if it was split into any.  Their index
+	// ranges are relative to StartIndexLocation.
+	const std::vector<Meshlet>* Meshlets = nullptr;
+
+	// 16-bit pages of a mesh too big for one 16-bit draw, drawn one after another.
+	// The draw arguments above are then those of the first page.
+	std::vector<SubmeshGeometry> Pages;
+
+	// Drawn into the occlusion buffer to hide the items behind it.
+	bool IsOccluder = false;
+
+	// Flat color of the whole item, from the mesh it draws.
+	XMFLOAT4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+// One draw of the frame.  Either a single render item drawn with the object constants
+// at ObjectCBAddress, or, when InstanceCount > 0, a group of items with the same draw
+// arguments as Item whose world matrices start at InstanceStart in the frame's
+// instance buffer.  With the object buffer, single items have an InstanceStart too:
+// the instance stream then holds object indices for every draw.
+struct DrawItem
+{
+	RenderItem* Item = nullptr;
+	UINT InstanceStart = 0;
+	UINT InstanceCount = 0;
+	D3D12_GPU_VIRTUAL_ADDRESS ObjectCBAddress = 0;
+
+	// View depth of the nearest item, for sorting.
+	float Depth = 0.0f;
 };
 
 class ShapesApp : public D3DApp
@@ -70,18 +230,31 @@ private:
 
     void OnKeyboardInput(const GameTimer& gt);
 	void UpdateCamera(const GameTimer& gt);
+	void UpdateLods(const GameTimer& gt);
+	void CullRenderItems();
+	void OcclusionCullRenderItems(FXMMATRIX viewProj);
+	void ReportFrameStats(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
+	void UpdateObjectBuffer(const GameTimer& gt);
+	void MarkObjectDirty(const RenderItem* ri);
+	void UpdateInstanceBuffer(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void WaitForFence(UINT64 fence);
+	UploadRing::Allocation AllocateUpload(UINT64 size, UINT64 alignment);
 
-    void BuildDescriptorHeaps();
-    void BuildConstantBufferViews();
     void BuildRootSignature();
     void BuildShadersAndInputLayout();
     void BuildShapeGeometry();
+    template<typename Index>
+    void BuildPackedGeometry(const std::string& name, std::vector<Vertex>& vertices, std::vector<Index>& indices,
+        const std::unordered_map<std::string, SubmeshGeometry>& drawArgs);
+    template<typename Index>
+    void DeduplicateSubmeshes(std::vector<Vertex>& vertices, std::vector<Index>& indices,
+        std::unordered_map<std::string, SubmeshGeometry>& drawArgs);
     void BuildPSOs();
     void BuildFrameResources();
     void BuildRenderItems();
-    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+    void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<DrawItem>& drawItems);
  
 private:
 
@@ -89,8 +262,18 @@ private:
     FrameResource* mCurrFrameResource = nullptr;
     int mCurrFrameResourceIndex = 0;
 
+	// Pass constants, object constants and instance data of every frame in flight.
+	std::unique_ptr<UploadRingBuffer> mUploadRing;
+
+	// Rings replaced by a larger one, with the fence of the last frame that used them.
+	std::vector<std::pair<UINT64, std::unique_ptr<UploadRingBuffer>>> mRetiredUploadRings;
+	UINT mUploadRingGrowths = 0;
+
+	// Where this frame's pass constants and instance data were written in the ring.
+	D3D12_GPU_VIRTUAL_ADDRESS mPassCBAddress = 0;
+	D3D12_VERTEX_BUFFER_VIEW mInstanceBufferView = {};
+
     ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
-    ComPtr<ID3D12DescriptorHeap> mCbvHeap = nullptr;
 
 	ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
 
@@ -98,7 +281,22 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
     std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
+	// LOD chains keyed by the DrawArgs name of the full detail submesh.
+	std::unordered_map<std::string, LodChain> mLodChains;
+
+	// Meshlets keyed by the DrawArgs name of the submesh they split.
+	std::unordered_map<std::string, std::vector<Meshlet>> mMeshlets;
+
+	// Color each DrawArgs name was packed with, copied into the items that draw it.
+	std::unordered_map<std::string, XMFLOAT4> mDrawArgColors;
+
+	// Page counts of the names packed as 16-bit pages "<name>_page<i>" rather than
+	// as one DrawArgs entry.
+	std::unordered_map<std::string, UINT> mDrawArgPageCounts;
+
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+    std::vector<D3D12_INPUT_ELEMENT_DESC> mInstancedInputLayout;
+    std::vector<D3D12_INPUT_ELEMENT_DESC> mObjectBufferInputLayout;
 
 	// List of all the render items.
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
@@ -106,12 +304,54 @@ private:
 	// Render items divided by PSO.
 	std::vector<RenderItem*> mOpaqueRitems;
 
+	// ObjectData of every render item by ObjCBIndex, as the object buffers should hold
+	// it, and a bit per frame resource whose DirtyObjects already lists the item.
+	std::vector<ObjectData> mObjectData;
+	std::vector<std::uint8_t> mObjectDirtyFrames;
+
+	// Where each chunk's objects start in the sorted dirty list, plus the end, and the
+	// copies each chunk issued.
+	std::vector<size_t> mObjectChunkStarts;
+	std::vector<UINT> mObjectChunkCopies;
+
+	// World bounds of mOpaqueRitems, in the same order, and the ones that passed
+	// frustum culling this frame.
+	std::vector<BoundingBox> mWorldBounds;
+	FrustumCuller mFrustumCuller;
+	SceneBvh mSceneBvh;
+	std::vector<FrustumCuller::uint32> mVisibleIndices;
+	std::vector<RenderItem*> mVisibleRitems;
+
+	// Set when MarkObjectDirty changed some world bounds; the BVH is refit before the
+	// next cull.
+	bool mSceneBvhStale = false;
+
+	// Workers for the per frame CPU stages.
+	ThreadPool mThreadPool;
+	OcclusionCuller mOcclusionCuller;
+
+	// Draws of the frame after grouping the visible items into instances.
+	std::vector<DrawItem> mDrawItems;
+	std::vector<RenderItem*> mInstanceCandidates;
+	std::vector<const RenderItem*> mInstancedRitems;
+
+	RenderQueue mRenderQueue;
+
     PassConstants mMainPassCB;
 
-    UINT mPassCbvOffset = 0;
+	FrameStats mFrameStats;
+	float mFrameStatsTime = 0.0f;
+	UINT mLodSwitchesSinceReport = 0;
 
     bool mIsWireframe = false;
 
+	// Draw every item through the object buffer and the instance stream instead of
+	// binding object constants per draw.
+	bool mUseObjectBuffer = true;
+
+	// Cull through the BVH even below gBvhCullThreshold.
+	bool mForceBvhCull = false;
+
 	XMFLOAT3 mEyePos = { 0.0f, 0.0f, 0.0f };
 	XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	XMFLOAT4X4 mProj = MathHelper::Identity4x4();
@@ -144,6 +384,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
         MessageBox(nullptr, e.ToString().c_str(), L"HR Failed", MB_OK);
         return 0;
     }
+    catch(std::exception& e)
+    {
+        MessageBoxA(nullptr, e.what(), "Failed", MB_OK);
+        return 0;
+    }
 }
 
 ShapesApp::ShapesApp(HINSTANCE hInstance)
@@ -170,8 +415,6 @@ bool ShapesApp::Initialize()
     BuildShapeGeometry();
     BuildRenderItems();
     BuildFrameResources();
-    BuildDescriptorHeaps();
-    BuildConstantBufferViews();
     BuildPSOs();
 
     // Execute the initialization commands.
@@ -182,6 +425,10 @@ bool ShapesApp::Initialize()
     // Wait until initialization is complete.
     FlushCommandQueue();
 
+#if defined(SHAPES_RUN_BENCHMARKS)
+    RunBenchmarks(md3dDevice.Get(), mRootSignature.Get(), mPSOs["opaque"].Get(), mPSOs["opaque_objects"].Get());
+#endif
+
     return true;
 }
  
@@ -199,20 +446,32 @@ void ShapesApp::Update(const GameTimer& gt)
     OnKeyboardInput(gt);
 	UpdateCamera(gt);
 
+	ReportFrameStats(gt);
+	mFrameStats = FrameStats();
+
+	UpdateLods(gt);
+	CullRenderItems();
+
     // Cycle through the circular frame resource array.
     mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
     mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
 
     // Has the GPU finished processing the commands of the current frame resource?
     // If not, wait until the GPU has completed commands up to this fence point.
-    if(mCurrFrameResource->Fence != 0 && mFence->GetCompletedValue() < mCurrFrameResource->Fence)
-    {
-        HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-        ThrowIfFailed(mFence->SetEventOnCompletion(mCurrFrameResource->Fence, eventHandle));
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
-    }
+    WaitForFence(mCurrFrameResource->Fence);
 
+	// Free the upload memory of the frames the GPU has finished.
+	UINT64 completedFence = mFence->GetCompletedValue();
+	mUploadRing->Ring().Retire(completedFence);
+	mRetiredUploadRings.erase(std::remove_if(mRetiredUploadRings.begin(), mRetiredUploadRings.end(),
+		[&](const std::pair<UINT64, std::unique_ptr<UploadRingBuffer>>& e) { return e.first <= completedFence; }),
+		mRetiredUploadRings.end());
+
+	UpdateObjectBuffer(gt);
+
+	// The object constants are only written for the draws UpdateInstanceBuffer did not
+	// instance, so it goes first.
+	UpdateInstanceBuffer(gt);
 	UpdateObjectCBs(gt);
 	UpdateMainPassCB(gt);
 }
@@ -250,17 +509,12 @@ void ShapesApp::Draw(const GameTimer& gt)
     // Specify the buffers we are going to render to.
     mCommandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
 
-    ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvHeap.Get() };
-    mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
-    int passCbvIndex = mPassCbvOffset + mCurrFrameResourceIndex;
-    auto passCbvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(mCbvHeap->GetGPUDescriptorHandleForHeapStart());
-    passCbvHandle.Offset(passCbvIndex, mCbvSrvUavDescriptorSize);
-    mCommandList->SetGraphicsRootDescriptorTable(1, passCbvHandle);
+    mCommandList->SetGraphicsRootConstantBufferView(1, mPassCBAddress);
+    mCommandList->SetGraphicsRootShaderResourceView(2, mCurrFrameResource->ObjectBuffer->Resource()->GetGPUVirtualAddress());
 
-    DrawRenderItems(mCommandList.Get(), mOpaqueRitems);
+    DrawRenderItems(mCommandList.Get(), mDrawItems);
 
     // Indicate a state transition on the resource usage.
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
@@ -279,6 +533,9 @@ void ShapesApp::Draw(const GameTimer& gt)
 
     // Advance the fence value to mark commands up to this fence point.
     mCurrFrameResource->Fence = ++mCurrentFence;
+
+	// The frame's upload allocations are freed once the GPU passes the same fence.
+	mUploadRing->Ring().EndFrame(mCurrentFence);
     
     // Add an instruction to the command queue to set a new fence point. 
     // Because we are on the GPU timeline, the new fence point won't be 
@@ -337,6 +594,9 @@ void ShapesApp::OnKeyboardInput(const GameTimer& gt)
         mIsWireframe = false;
     else
         mIsWireframe = true;
+
+    mUseObjectBuffer = (GetAsyncKeyState('2') & 0x8000) == 0;
+    mForceBvhCull = (GetAsyncKeyState('3') & 0x8000) != 0;
 }
  
 void ShapesApp::UpdateCamera(const GameTimer& gt)
@@ -355,26 +615,472 @@ void ShapesApp::UpdateCamera(const GameTimer& gt)
 	XMStoreFloat4x4(&mView, view);
 }
 
-void ShapesApp::UpdateObjectCBs(const GameTimer& gt)
+void ShapesApp::UpdateLods(const GameTimer& gt)
 {
-	auto currObjectCB = mCurrFrameResource->ObjectCB.get();
+	// Pixels covered by one world unit at distance 1.
+	const float pixelsPerUnit = 0.5f*mClientHeight*mProj(1, 1);
+
+	XMVECTOR eyePos = XMLoadFloat3(&mEyePos);
+
 	for(auto& e : mAllRitems)
 	{
-		// Only update the cbuffer data if the constants have changed.  
-		// This needs to be tracked per frame resource.
-		if(e->NumFramesDirty > 0)
+		if(e->Lods == nullptr)
+			continue;
+
+		const LodChain& chain = *e->Lods;
+
+		BoundingSphere bounds;
+		chain.Bounds.Transform(bounds, e->World.Load());
+
+		float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Center) - eyePos)) - bounds.Radius;
+
+		UINT level = 0;
+		if(distance > 0.0f && chain.Bounds.Radius > 0.0f)
 		{
-			XMMATRIX world = XMLoadFloat4x4(&e->World);
+			// Projected size of the bounds on screen.  A level's error is scaled the
+			// same way, relative to the radius of the mesh it was measured on.
+			float screenRadius = bounds.Radius*pixelsPerUnit / distance;
+			float pixelsPerError = screenRadius / chain.Bounds.Radius;
+
+			auto pixelError = [&](UINT i) { return chain.Levels[i].Error*pixelsPerError; };
+
+			level = e->LodIndex;
+			while(level > 0 && pixelError(level) > gLodPixelError*(1.0f + gLodHysteresis))
+				--level;
+			while(level + 1 < chain.Levels.size() && pixelError(level + 1) < gLodPixelError*(1.0f - gLodHysteresis))
+				++level;
+		}
+
+		if(level != e->LodIndex)
+		{
+			const SubmeshGeometry& submesh = chain.Levels[level].Submesh;
+			e->IndexCount = submesh.IndexCount;
+			e->StartIndexLocation = submesh.StartIndexLocation;
+			e->BaseVertexLocation = submesh.BaseVertexLocation;
+			e->LodIndex = level;
+
+			mFrameStats.LodSwitches++;
+		}
 
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+		mFrameStats.LodTrianglesFull += chain.Levels[0].Submesh.IndexCount / 3;
+		mFrameStats.LodTrianglesDrawn += e->IndexCount / 3;
+	}
+
+	mLodSwitchesSinceReport += mFrameStats.LodSwitches;
+}
+
+void ShapesApp::CullRenderItems()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&mView), XMLoadFloat4x4(&mProj));
+
+	// Items moved since the last cull; the tree structure is kept.
+	if(mSceneBvhStale)
+	{
+		mSceneBvh.Refit(mWorldBounds);
+		mSceneBvhStale = false;
+		mFrameStats.BvhRefitMs = mSceneBvh.GetRefitMs();
+	}
+
+	bool useBvh = mForceBvhCull || mOpaqueRitems.size() >= gBvhCullThreshold;
+	if(useBvh)
+	{
+		// The BVH returns items in tree order; sort them back to submission order.
+		mVisibleIndices.clear();
+		mSceneBvh.QueryFrustum(viewProj, mVisibleIndices);
+		std::sort(mVisibleIndices.begin(), mVisibleIndices.end());
+	}
+	else
+	{
+		mFrustumCuller.Cull(viewProj, mVisibleIndices);
+	}
 
-			currObjectCB->CopyData(e->ObjCBIndex, objConstants);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	mFrameStats.ItemsVisible = (UINT)mVisibleIndices.size();
+	mFrameStats.ItemsCulled = (UINT)(mOpaqueRitems.size() - mVisibleIndices.size());
+	mFrameStats.CullMs = std::chrono::duration<double, std::milli>(end - start).count();
+	mFrameStats.CullUsedBvh = useBvh;
+
+	OcclusionCullRenderItems(viewProj);
+}
+
+void ShapesApp::OcclusionCullRenderItems(FXMMATRIX viewProj)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Rasterize the occluders that survived frustum culling.
+	mOcclusionCuller.BeginFrame(viewProj);
+	for(FrustumCuller::uint32 i : mVisibleIndices)
+	{
+		const RenderItem* ri = mOpaqueRitems[i];
+		if(!ri->IsOccluder)
+			continue;
+
+		auto vertices = reinterpret_cast<const Vertex*>(ri->Geo->VertexBufferCPU->GetBufferPointer());
+		const void* indices = ri->Geo->IndexBufferCPU->GetBufferPointer();
+
+		auto addOccluder = [&](UINT indexCount, UINT startIndex, INT baseVertex)
+		{
+			if(ri->Geo->IndexFormat == DXGI_FORMAT_R16_UINT)
+			{
+				mOcclusionCuller.AddOccluder(&vertices[baseVertex].Pos, sizeof(Vertex),
+					static_cast<const std::uint16_t*>(indices) + startIndex, indexCount, ri->World.Load());
+			}
+			else
+			{
+				mOcclusionCuller.AddOccluder(&vertices[baseVertex].Pos, sizeof(Vertex),
+					static_cast<const std::uint32_t*>(indices) + startIndex, indexCount, ri->World.Load());
+			}
+		};
+
+		if(ri->Pages.empty())
+			addOccluder(ri->IndexCount, ri->StartIndexLocation, ri->BaseVertexLocation);
+
+		for(const SubmeshGeometry& page : ri->Pages)
+			addOccluder(page.IndexCount, page.StartIndexLocation, page.BaseVertexLocation);
+	}
+
+	bool haveOccluders = mOcclusionCuller.GetTriangleCount() > 0;
+	if(haveOccluders)
+		mOcclusionCuller.Rasterize(&mThreadPool);
+
+	// Occluders are never tested, they would hide themselves.
+	mVisibleRitems.clear();
+	for(FrustumCuller::uint32 i : mVisibleIndices)
+	{
+		RenderItem* ri = mOpaqueRitems[i];
+		if(!haveOccluders || ri->IsOccluder || mOcclusionCuller.IsVisible(mWorldBounds[i]))
+			mVisibleRitems.push_back(ri);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	mFrameStats.OccluderTriangles = (UINT)mOcclusionCuller.GetTriangleCount();
+	mFrameStats.ItemsOccluded = (UINT)(mVisibleIndices.size() - mVisibleRitems.size());
+	mFrameStats.OcclusionRasterMs = haveOccluders ? mOcclusionCuller.GetRasterizeMs() : 0.0;
+	mFrameStats.OcclusionMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void ShapesApp::ReportFrameStats(const GameTimer& gt)
+{
+	if(gt.TotalTime() - mFrameStatsTime < 1.0f)
+		return;
+
+	mFrameStatsTime = gt.TotalTime();
+
+	std::ostringstream ss;
+	ss << "LOD: " << mFrameStats.LodTrianglesDrawn << " of " << mFrameStats.LodTrianglesFull
+	   << " triangles drawn, " << mFrameStats.LodTrianglesFull - mFrameStats.LodTrianglesDrawn
+	   << " saved, " << mLodSwitchesSinceReport << " switches in the last second\n";
+	ss << "Meshlets: " << mFrameStats.MeshletsDrawn << " drawn, "
+	   << mFrameStats.MeshletsCulled << " culled as backfacing\n";
+	ss << "Frustum: " << mFrameStats.ItemsVisible << " items visible, " << mFrameStats.ItemsCulled
+	   << " culled in " << mFrameStats.CullMs << " ms"
+	   << (mFrameStats.CullUsedBvh ? " (BVH)" : "") << ", BVH refit in " << mFrameStats.BvhRefitMs << " ms\n";
+	ss << "Occlusion: " << mFrameStats.ItemsOccluded << " items occluded by " << mFrameStats.OccluderTriangles
+	   << " triangles in " << mFrameStats.OcclusionMs << " ms (" << mFrameStats.OcclusionRasterMs
+	   << " ms rasterizing on " << mThreadPool.GetThreadCount() << " threads)\n";
+	ss << "Submission: " << mFrameStats.DrawPackets << " packets sorted in " << mFrameStats.SortMs << " ms, "
+	   << mFrameStats.Draws << " draws, " << mFrameStats.PsoBinds << " PSO, " << mFrameStats.GeometryBinds
+	   << " vertex/index buffer and " << mFrameStats.TopologyBinds << " topology binds (unsorted: "
+	   << mFrameStats.DrawPackets << " of each), recorded in " << mFrameStats.SubmitMs << " ms with "
+	   << (mUseObjectBuffer ? "the object buffer\n" : "per object constant buffers\n");
+	ss << "Object buffer: " << mFrameStats.ObjectsUpdated << " objects updated in "
+	   << mFrameStats.ObjectCopies << " copies over " << mFrameStats.ObjectChunks << " chunks\n";
+	ss << "Instancing: " << mFrameStats.InstancedItems << " items in " << mFrameStats.InstancedDraws
+	   << " instanced draws\n";
+	const UploadRing& ring = mUploadRing->Ring();
+	ss << "Upload ring: " << ring.GetFrameBytes()/1024 << " KB this frame, high water "
+	   << ring.GetFrameHighWater()/1024 << " KB per frame and " << ring.GetUsedHighWater()/1024
+	   << " KB in flight of " << ring.GetCapacity()/1024 << " KB, " << mUploadRingGrowths << " growths\n";
+	::OutputDebugStringA(ss.str().c_str());
+
+	mLodSwitchesSinceReport = 0;
+}
+
+void ShapesApp::UpdateObjectCBs(const GameTimer& gt)
+{
+	// Draws through the object buffer have no per draw constants.
+	if(mUseObjectBuffer)
+		return;
+
+	// Only the items drawn on their own read object constants; instanced draws take
+	// theirs from the instance buffer.  The constants are allocated fresh every frame,
+	// so every drawn item is written whether it changed or not.
+	const UINT64 objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+
+	for(DrawItem& drawItem : mDrawItems)
+	{
+		if(drawItem.InstanceCount > 0)
+			continue;
 
-			// Next FrameResource need to be updated too.
-			e->NumFramesDirty--;
+		const RenderItem* ri = drawItem.Item;
+
+		ObjectConstants objConstants;
+		objConstants.World = ri->World;
+		objConstants.Color = ri->Color;
+
+		UploadRing::Allocation allocation = AllocateUpload(objCBByteSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		memcpy(allocation.CpuAddress, &objConstants, sizeof(ObjectConstants));
+		drawItem.ObjectCBAddress = allocation.GpuAddress;
+	}
+}
+
+void ShapesApp::UpdateObjectBuffer(const GameTimer& gt)
+{
+	// Kept current in both modes so switching between them needs no full rewrite.
+	// Only the objects queued since this frame resource was last used are touched, and
+	// after sorting them each run of consecutive indices goes in one copy.  Large
+	// updates are split into page aligned chunks of the buffer, one worker each.
+	// mObjectData already holds the 3x4 transforms, so a run is a plain memcpy.
+	auto currObjectBuffer = mCurrFrameResource->ObjectBuffer.get();
+	auto& dirtyObjects = mCurrFrameResource->DirtyObjects;
+
+	const std::uint8_t frameBit = (std::uint8_t)(1 << mCurrFrameResourceIndex);
+
+	if(dirtyObjects.size()*gDirtySortRatio > mObjectDirtyFrames.size())
+	{
+		dirtyObjects.clear();
+		for(size_t i = 0; i < mObjectDirtyFrames.size(); ++i)
+		{
+			if(mObjectDirtyFrames[i] & frameBit)
+				dirtyObjects.push_back((UINT)i);
+		}
+	}
+	else
+	{
+		std::sort(dirtyObjects.begin(), dirtyObjects.end());
+	}
+
+	// Cut the sorted list wherever it crosses into another chunk.  Every object then
+	// belongs to exactly one chunk and is written by one worker, so the buffer ends up
+	// the same however the chunks are scheduled.
+	mObjectChunkStarts.clear();
+	if(dirtyObjects.size() >= gParallelObjectThreshold)
+	{
+		for(size_t k = 0; k < dirtyObjects.size(); ++k)
+		{
+			if(k == 0 || dirtyObjects[k]/gObjectChunkSize != dirtyObjects[k - 1]/gObjectChunkSize)
+				mObjectChunkStarts.push_back(k);
 		}
 	}
+	else if(!dirtyObjects.empty())
+	{
+		mObjectChunkStarts.push_back(0);
+	}
+
+	size_t chunkCount = mObjectChunkStarts.size();
+	mObjectChunkStarts.push_back(dirtyObjects.size());
+	mObjectChunkCopies.assign(chunkCount, 0);
+
+	auto updateChunk = [&](size_t chunk)
+	{
+		size_t end = mObjectChunkStarts[chunk + 1];
+		for(size_t first = mObjectChunkStarts[chunk]; first < end; )
+		{
+			size_t last = first + 1;
+			while(last < end && dirtyObjects[last] == dirtyObjects[last - 1] + 1)
+				++last;
+
+			UINT start = dirtyObjects[first];
+			currObjectBuffer->CopyData(start, &mObjectData[start], (int)(last - first));
+			mObjectChunkCopies[chunk]++;
+
+			// Each flag byte belongs to one object, so chunks never write the same one.
+			for(size_t k = first; k < last; ++k)
+				mObjectDirtyFrames[dirtyObjects[k]] &= ~frameBit;
+
+			first = last;
+		}
+	};
+
+	if(chunkCount > 1)
+	{
+		mThreadPool.ParallelFor(chunkCount, updateChunk);
+	}
+	else if(chunkCount == 1)
+	{
+		updateChunk(0);
+	}
+
+	for(UINT copies : mObjectChunkCopies)
+		mFrameStats.ObjectCopies += copies;
+
+	mFrameStats.ObjectChunks = (UINT)chunkCount;
+	mFrameStats.ObjectsUpdated = (UINT)dirtyObjects.size();
+	dirtyObjects.clear();
+}
+
+void ShapesApp::MarkObjectDirty(const RenderItem* ri)
+{
+	static_assert(gNumFrameResources <= 8, "mObjectDirtyFrames has a bit per frame resource");
+
+	ObjectData& objectData = mObjectData[ri->ObjCBIndex];
+	objectData.World = ri->World;
+	objectData.Color = ri->Color;
+
+	// Keep the culling bounds in step with the object.  The BVH is refit once before
+	// the next cull however many items moved.
+	if(ri->CullIndex < mWorldBounds.size())
+	{
+		BoundingBox bounds;
+		ri->Bounds.Transform(bounds, ri->World.Load());
+
+		BoundingBox& worldBounds = mWorldBounds[ri->CullIndex];
+		if(!XMVector3Equal(XMLoadFloat3(&bounds.Center), XMLoadFloat3(&worldBounds.Center)) ||
+			!XMVector3Equal(XMLoadFloat3(&bounds.Extents), XMLoadFloat3(&worldBounds.Extents)))
+		{
+			worldBounds = bounds;
+			mFrustumCuller.SetBox(ri->CullIndex, bounds);
+			mSceneBvhStale = true;
+		}
+	}
+
+	// Every frame resource has its own object buffer, so each gets the update when it
+	// next comes around.
+	std::uint8_t& dirtyFrames = mObjectDirtyFrames[ri->ObjCBIndex];
+	for(int i = 0; i < gNumFrameResources; ++i)
+	{
+		if((dirtyFrames & (1 << i)) == 0)
+		{
+			dirtyFrames |= (std::uint8_t)(1 << i);
+			mFrameResources[i]->DirtyObjects.push_back(ri->ObjCBIndex);
+		}
+	}
+}
+
+void ShapesApp::UpdateInstanceBuffer(const GameTimer& gt)
+{
+	XMMATRIX view = XMLoadFloat4x4(&mView);
+	auto viewDepth = [&](const RenderItem* ri)
+	{
+		XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&ri->Bounds.Center), ri->World.Load());
+		return XMVectorGetZ(XMVector3TransformCoord(center, view));
+	};
+
+	mDrawItems.clear();
+	mInstanceCandidates.clear();
+
+	// Items drawn a meshlet at a time cull per object, so they keep their own draws.
+	for(RenderItem* ri : mVisibleRitems)
+	{
+		if(ri->Meshlets != nullptr && ri->LodIndex == 0)
+		{
+			DrawItem drawItem;
+			drawItem.Item = ri;
+			drawItem.Depth = viewDepth(ri);
+			mDrawItems.push_back(drawItem);
+		}
+		else
+		{
+			mInstanceCandidates.push_back(ri);
+		}
+	}
+
+	// Group the rest by the draw arguments they use this frame, which after LOD
+	// selection is the DrawArgs entry of their level.
+	auto drawArgs = [](const RenderItem* ri)
+	{
+		return std::make_tuple(ri->GeoSortId, ri->StartIndexLocation, ri->BaseVertexLocation,
+			ri->IndexCount, (int)ri->PrimitiveType);
+	};
+
+	std::sort(mInstanceCandidates.begin(), mInstanceCandidates.end(),
+		[&](const RenderItem* a, const RenderItem* b) { return drawArgs(a) < drawArgs(b); });
+
+	mInstancedRitems.clear();
+
+	for(size_t first = 0; first < mInstanceCandidates.size(); )
+	{
+		size_t last = first + 1;
+		while(last < mInstanceCandidates.size() && drawArgs(mInstanceCandidates[last]) == drawArgs(mInstanceCandidates[first]))
+			++last;
+
+		if(last - first < gMinInstanceCount)
+		{
+			for(size_t k = first; k < last; ++k)
+			{
+				DrawItem drawItem;
+				drawItem.Item = mInstanceCandidates[k];
+				drawItem.Depth = viewDepth(mInstanceCandidates[k]);
+				mDrawItems.push_back(drawItem);
+			}
+
+			first = last;
+			continue;
+		}
+
+		DrawItem drawItem;
+		drawItem.Item = mInstanceCandidates[first];
+		drawItem.InstanceStart = (UINT)mInstancedRitems.size();
+		drawItem.InstanceCount = (UINT)(last - first);
+		drawItem.Depth = FLT_MAX;
+
+		for(size_t k = first; k < last; ++k)
+		{
+			mInstancedRitems.push_back(mInstanceCandidates[k]);
+			drawItem.Depth = std::min(drawItem.Depth, viewDepth(mInstanceCandidates[k]));
+		}
+
+		mDrawItems.push_back(drawItem);
+
+		mFrameStats.InstancedDraws++;
+		mFrameStats.InstancedItems += drawItem.InstanceCount;
+
+		first = last;
+	}
+
+	// With the object buffer every draw reads its objects through the instance stream,
+	// so the single items get an entry after the groups.
+	if(mUseObjectBuffer)
+	{
+		for(DrawItem& drawItem : mDrawItems)
+		{
+			if(drawItem.InstanceCount == 0)
+			{
+				drawItem.InstanceStart = (UINT)mInstancedRitems.size();
+				mInstancedRitems.push_back(drawItem.Item);
+			}
+		}
+	}
+
+	// Now that the instance count is known, write them all in one allocation.
+	mInstanceBufferView = {};
+	if(mInstancedRitems.empty())
+		return;
+
+	if(mUseObjectBuffer)
+	{
+		UINT64 byteSize = mInstancedRitems.size()*sizeof(UINT);
+		UploadRing::Allocation allocation = AllocateUpload(byteSize, 16);
+
+		UINT* objectIndices = reinterpret_cast<UINT*>(allocation.CpuAddress);
+		for(size_t i = 0; i < mInstancedRitems.size(); ++i)
+			objectIndices[i] = mInstancedRitems[i]->ObjCBIndex;
+
+		mInstanceBufferView.BufferLocation = allocation.GpuAddress;
+		mInstanceBufferView.StrideInBytes = sizeof(UINT);
+		mInstanceBufferView.SizeInBytes = (UINT)byteSize;
+		return;
+	}
+
+	UINT64 byteSize = mInstancedRitems.size()*sizeof(InstanceData);
+	UploadRing::Allocation allocation = AllocateUpload(byteSize, 16);
+
+	InstanceData* instances = reinterpret_cast<InstanceData*>(allocation.CpuAddress);
+	for(size_t i = 0; i < mInstancedRitems.size(); ++i)
+	{
+		InstanceData instance;
+		instance.World = mInstancedRitems[i]->World;
+		instance.Color = mInstancedRitems[i]->Color;
+		instances[i] = instance;
+	}
+
+	mInstanceBufferView.BufferLocation = allocation.GpuAddress;
+	mInstanceBufferView.StrideInBytes = sizeof(InstanceData);
+	mInstanceBufferView.SizeInBytes = (UINT)byteSize;
 }
 
 void ShapesApp::UpdateMainPassCB(const GameTimer& gt)
@@ -401,98 +1107,63 @@ void ShapesApp::UpdateMainPassCB(const GameTimer& gt)
 	mMainPassCB.TotalTime = gt.TotalTime();
 	mMainPassCB.DeltaTime = gt.DeltaTime();
 
-	auto currPassCB = mCurrFrameResource->PassCB.get();
-	currPassCB->CopyData(0, mMainPassCB);
+	UploadRing::Allocation allocation = AllocateUpload(d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants)),
+		D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	memcpy(allocation.CpuAddress, &mMainPassCB, sizeof(PassConstants));
+	mPassCBAddress = allocation.GpuAddress;
 }
 
-void ShapesApp::BuildDescriptorHeaps()
+void ShapesApp::WaitForFence(UINT64 fence)
 {
-    UINT objCount = (UINT)mOpaqueRitems.size();
-
-    // Need a CBV descriptor for each object for each frame resource,
-    // +1 for the perPass CBV for each frame resource.
-    UINT numDescriptors = (objCount+1) * gNumFrameResources;
-
-    // Save an offset to the start of the pass CBVs.  These are the last 3 descriptors.
-    mPassCbvOffset = objCount * gNumFrameResources;
-
-    D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc;
-    cbvHeapDesc.NumDescriptors = numDescriptors;
-    cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    cbvHeapDesc.NodeMask = 0;
-    ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&cbvHeapDesc,
-        IID_PPV_ARGS(&mCbvHeap)));
+    if(fence != 0 && mFence->GetCompletedValue() < fence)
+    {
+        HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+        ThrowIfFailed(mFence->SetEventOnCompletion(fence, eventHandle));
+        WaitForSingleObject(eventHandle, INFINITE);
+        CloseHandle(eventHandle);
+    }
 }
 
-void ShapesApp::BuildConstantBufferViews()
+UploadRing::Allocation ShapesApp::AllocateUpload(UINT64 size, UINT64 alignment)
 {
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+	UploadRing::Allocation allocation = mUploadRing->Ring().Allocate(size, alignment);
 
-    UINT objCount = (UINT)mOpaqueRitems.size();
-
-    // Need a CBV descriptor for each object for each frame resource.
-    for(int frameIndex = 0; frameIndex < gNumFrameResources; ++frameIndex)
-    {
-        auto objectCB = mFrameResources[frameIndex]->ObjectCB->Resource();
-        for(UINT i = 0; i < objCount; ++i)
-        {
-            D3D12_GPU_VIRTUAL_ADDRESS cbAddress = objectCB->GetGPUVirtualAddress();
-
-            // Offset to the ith object constant buffer in the buffer.
-            cbAddress += i*objCBByteSize;
-
-            // Offset to the object cbv in the descriptor heap.
-            int heapIndex = frameIndex*objCount + i;
-            auto handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(mCbvHeap->GetCPUDescriptorHandleForHeapStart());
-            handle.Offset(heapIndex, mCbvSrvUavDescriptorSize);
-
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-            cbvDesc.BufferLocation = cbAddress;
-            cbvDesc.SizeInBytes = objCBByteSize;
+	// Out of room: wait for the oldest frame still holding ring memory to finish.
+	while(allocation.CpuAddress == nullptr && mUploadRing->Ring().GetOldestFence() != 0)
+	{
+		WaitForFence(mUploadRing->Ring().GetOldestFence());
+		mUploadRing->Ring().Retire(mFence->GetCompletedValue());
+		allocation = mUploadRing->Ring().Allocate(size, alignment);
+	}
 
-            md3dDevice->CreateConstantBufferView(&cbvDesc, handle);
-        }
-    }
+	if(allocation.CpuAddress != nullptr)
+		return allocation;
 
-    UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
+	// This frame alone fills the ring.  Its earlier allocations live in the current
+	// buffer, so that is kept until the GPU has passed the fence this frame will signal.
+	UINT64 byteSize = std::max(2*mUploadRing->Ring().GetCapacity(), 2*(size + alignment));
+	mRetiredUploadRings.push_back(std::make_pair(mCurrentFence + 1, std::move(mUploadRing)));
+	mUploadRing = std::make_unique<UploadRingBuffer>(md3dDevice.Get(), byteSize);
+	mUploadRingGrowths++;
 
-    // Last three descriptors are the pass CBVs for each frame resource.
-    for(int frameIndex = 0; frameIndex < gNumFrameResources; ++frameIndex)
-    {
-        auto passCB = mFrameResources[frameIndex]->PassCB->Resource();
-        D3D12_GPU_VIRTUAL_ADDRESS cbAddress = passCB->GetGPUVirtualAddress();
-
-        // Offset to the pass cbv in the descriptor heap.
-        int heapIndex = mPassCbvOffset + frameIndex;
-        auto handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(mCbvHeap->GetCPUDescriptorHandleForHeapStart());
-        handle.Offset(heapIndex, mCbvSrvUavDescriptorSize);
-
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-        cbvDesc.BufferLocation = cbAddress;
-        cbvDesc.SizeInBytes = passCBByteSize;
-        
-        md3dDevice->CreateConstantBufferView(&cbvDesc, handle);
-    }
+	return mUploadRing->Ring().Allocate(size, alignment);
 }
 
 void ShapesApp::BuildRootSignature()
 {
-    CD3DX12_DESCRIPTOR_RANGE cbvTable0;
-    cbvTable0.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-
-    CD3DX12_DESCRIPTOR_RANGE cbvTable1;
-    cbvTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1);
-
 	// Root parameter can be a table, root descriptor or root constants.
-	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
+	CD3DX12_ROOT_PARAMETER slotRootParameter[3];
+
+	// Create root CBVs.  The constants are suballocated from the upload ring each
+	// frame, so they are bound by address and need no descriptors.
+    slotRootParameter[0].InitAsConstantBufferView(0);
+    slotRootParameter[1].InitAsConstantBufferView(1);
 
-	// Create root CBVs.
-    slotRootParameter[0].InitAsDescriptorTable(1, &cbvTable0);
-    slotRootParameter[1].InitAsDescriptorTable(1, &cbvTable1);
+	// The object buffer, bound once per frame as a root SRV.
+    slotRootParameter[2].InitAsShaderResourceView(0);
 
 	// A root signature is an array of root parameters.
-	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(2, slotRootParameter, 0, nullptr, 
+	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(3, slotRootParameter, 0, nullptr, 
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
 	// create a root signature with a single slot which points to a descriptor range consisting of a single constant buffer
@@ -517,13 +1188,30 @@ void ShapesApp::BuildRootSignature()
 void ShapesApp::BuildShadersAndInputLayout()
 {
 	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders\\color.hlsl", nullptr, "VS", "vs_5_1");
+	mShaders["instancedVS"] = d3dUtil::CompileShader(L"Shaders\\color.hlsl", nullptr, "VSInstanced", "vs_5_1");
+	mShaders["objectBufferVS"] = d3dUtil::CompileShader(L"Shaders\\color.hlsl", nullptr, "VSObjectBuffer", "vs_5_1");
 	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders\\color.hlsl", nullptr, "PS", "ps_5_1");
 	
     mInputLayout =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
+
+	// Same vertex, plus the three rows of the world transform and the color stepping
+	// once per instance from the instance buffer in slot 1.
+	mInstancedInputLayout = mInputLayout;
+	for(UINT row = 0; row < 3; ++row)
+	{
+		mInstancedInputLayout.push_back({ "WORLD", row, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, row*16,
+			D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 });
+	}
+	mInstancedInputLayout.push_back({ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48,
+		D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 });
+
+	// Same vertex, plus an index into the object buffer per instance.
+	mObjectBufferInputLayout = mInputLayout;
+	mObjectBufferInputLayout.push_back({ "OBJECTINDEX", 0, DXGI_FORMAT_R32_UINT, 1, 0,
+		D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 });
 }
 
 void ShapesApp::BuildShapeGeometry()////////////////////////////////////////////////////////////////////////////
@@ -541,463 +1229,237 @@ void ShapesApp::BuildShapeGeometry()////////////////////////////////////////////
 	GeometryGenerator::MeshData wedge = geoGen.CreateWedge(1.0f, 1.0f, 1.0f, 3);
 	GeometryGenerator::MeshData quad = geoGen.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 3);
 	GeometryGenerator::MeshData bar = geoGen.CreateChocolate(1.0f, 1.0f, 1.0f, 3);
-	GeometryGenerator::MeshData boxthree = box;
-	GeometryGenerator::MeshData boxfour = box;
-	GeometryGenerator::MeshData boxfive = box;
-	GeometryGenerator::MeshData boxsix = box;
-	GeometryGenerator::MeshData cylinder2 = cylinder;
-	GeometryGenerator::MeshData cylinder3 = cylinder;
-	GeometryGenerator::MeshData cylinder4 = cylinder;
-	GeometryGenerator::MeshData cylinder5 = cylinder;
-	GeometryGenerator::MeshData wedge2 = wedge;
-	GeometryGenerator::MeshData wedge3 = wedge;
-	GeometryGenerator::MeshData wedge4 = wedge;
-	GeometryGenerator::MeshData cone2 = cone;
-	GeometryGenerator::MeshData cone3 = cone;
-	GeometryGenerator::MeshData cone4 = cone;
-	GeometryGenerator::MeshData cone5 = cone;
 	GeometryGenerator::MeshData geosphere = geoGen.CreateGeosphere(0.5, 3);
+	GeometryGenerator::MeshData terrain = geoGen.CreateGrid(200.0f, 200.0f, 300, 300);
 
 	//
-	// We are concatenating all the geometry into one big vertex/index buffer.  So
-	// define the regions in the buffer each submesh covers.
-	//
-
-	// Cache the vertex offsets to each object in the concatenated vertex buffer.///////////////////////////////
-	UINT boxVertexOffset = 0;
-	UINT gridVertexOffset = (UINT)box.Vertices.size();
-	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
-	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere.Vertices.size();
-	UINT hexagonVertexOffset = cylinderVertexOffset + (UINT)cylinder.Vertices.size();
-	UINT tetrahedronVertexOffset = hexagonVertexOffset + (UINT)hexagon.Vertices.size();
-	UINT pyramidVertexOffset = tetrahedronVertexOffset + (UINT)tetrahedron.Vertices.size();
-	UINT diamondVertexOffset = pyramidVertexOffset + (UINT)pyramid.Vertices.size();	
-	UINT coneVertexOffset = diamondVertexOffset + (UINT)diamond.Vertices.size();
-	UINT wedgeVertexOffset = coneVertexOffset + (UINT)cone.Vertices.size();
-	UINT quadVertexOffset = wedgeVertexOffset + (UINT)wedge.Vertices.size();
-	UINT barVertexOffset = quadVertexOffset + (UINT)quad.Vertices.size();
-	UINT boxthreeVertexOffset = barVertexOffset + (UINT)bar.Vertices.size();
-	UINT boxfourVertexOffset = boxthreeVertexOffset + (UINT)boxthree.Vertices.size();
-	UINT boxfiveVertexOffset = boxfourVertexOffset + (UINT)boxfour.Vertices.size();
-	UINT boxsixVertexOffset = boxfiveVertexOffset + (UINT)boxfive.Vertices.size();
-	UINT cylinder2VertexOffset = boxsixVertexOffset + (UINT)box.Vertices.size();
-	UINT cylinder3VertexOffset = cylinder2VertexOffset + (UINT)cylinder.Vertices.size();
-	UINT cylinder4VertexOffset = cylinder3VertexOffset + (UINT)cylinder.Vertices.size();
-	UINT cylinder5VertexOffset = cylinder4VertexOffset + (UINT)cylinder.Vertices.size();
-	UINT wedge2VertexOffset = cylinder5VertexOffset + (UINT)cylinder.Vertices.size();
-	UINT wedge3VertexOffset = wedge2VertexOffset + (UINT)wedge.Vertices.size();
-	UINT wedge4VertexOffset = wedge3VertexOffset + (UINT)wedge.Vertices.size();
-	UINT cone2VertexOffset = wedge4VertexOffset + (UINT)wedge.Vertices.size();
-	UINT cone3VertexOffset = cone2VertexOffset + (UINT)cone.Vertices.size();
-	UINT cone4VertexOffset = cone3VertexOffset + (UINT)cone.Vertices.size();
-	UINT cone5VertexOffset = cone4VertexOffset + (UINT)cone.Vertices.size();
-	UINT geosphereVertexOffset = cone5VertexOffset + (UINT)cone.Vertices.size();
-
-	// Cache the starting index for each object in the concatenated index buffer./////////////////////////////////
-	UINT boxIndexOffset = 0;
-	UINT gridIndexOffset = (UINT)box.Indices32.size();
-	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid.Indices32.size();
-	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere.Indices32.size();
-	UINT hexagonIndexOffset = cylinderIndexOffset + (UINT)cylinder.Indices32.size();
-	UINT tetrahedronIndexOffset = hexagonIndexOffset + (UINT)hexagon.Indices32.size();
-	UINT pyramidIndexOffset = tetrahedronIndexOffset + (UINT)tetrahedron.Indices32.size();
-	UINT diamondIndexOffset = pyramidIndexOffset + (UINT)pyramid.Indices32.size();
-	UINT coneIndexOffset = diamondIndexOffset + (UINT)diamond.Indices32.size();
-	UINT wedgeIndexOffset = coneIndexOffset + (UINT)cone.Indices32.size();
-	UINT quadIndexOffset = wedgeIndexOffset + (UINT)wedge.Indices32.size();
-	UINT barIndexOffset = quadIndexOffset + (UINT)quad.Indices32.size();
-	UINT boxthreeIndexOffset = barIndexOffset + (UINT)bar.Indices32.size();
-	UINT boxfourIndexOffset = boxthreeIndexOffset + (UINT)boxthree.Indices32.size();
-	UINT boxfiveIndexOffset = boxfourIndexOffset + (UINT)boxfour.Indices32.size();
-	UINT boxsixIndexOffset = boxfiveIndexOffset + (UINT)boxfive.Indices32.size();
-	UINT cylinder2IndexOffset = boxsixIndexOffset + (UINT)box.Indices32.size();
-	UINT cylinder3IndexOffset = cylinder2IndexOffset + (UINT)cylinder.Indices32.size();
-	UINT cylinder4IndexOffset = cylinder3IndexOffset + (UINT)cylinder.Indices32.size();
-	UINT cylinder5IndexOffset = cylinder4IndexOffset + (UINT)cylinder.Indices32.size();
-	UINT wedge2IndexOffset = cylinder5IndexOffset + (UINT)cylinder.Indices32.size();
-	UINT wedge3IndexOffset = wedge2IndexOffset + (UINT)wedge.Indices32.size();
-	UINT wedge4IndexOffset = wedge3IndexOffset + (UINT)wedge.Indices32.size();
-	UINT cone2IndexOffset = wedge4IndexOffset + (UINT)wedge.Indices32.size();
-	UINT cone3IndexOffset = cone2IndexOffset + (UINT)cone.Indices32.size();
-	UINT cone4IndexOffset = cone3IndexOffset + (UINT)cone.Indices32.size();
-	UINT cone5IndexOffset = cone4IndexOffset + (UINT)cone.Indices32.size();
-	UINT geosphereIndexOffset = cone5IndexOffset + (UINT)cone.Indices32.size();
-
-    // Define the SubmeshGeometry that cover different 
-    // regions of the vertex/index buffers.
-
-	////////////////////////////////////////////////////////////////////////////////submesh
-	SubmeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
-	boxSubmesh.StartIndexLocation = boxIndexOffset;
-	boxSubmesh.BaseVertexLocation = boxVertexOffset;
-
-	SubmeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
-	gridSubmesh.StartIndexLocation = gridIndexOffset;
-	gridSubmesh.BaseVertexLocation = gridVertexOffset;
-
-	SubmeshGeometry sphereSubmesh;
-	sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-	sphereSubmesh.StartIndexLocation = sphereIndexOffset;
-	sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
-
-	SubmeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
-	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
-
-	SubmeshGeometry hexagonSubmesh;
-	hexagonSubmesh.IndexCount = (UINT)hexagon.Indices32.size();
-	hexagonSubmesh.StartIndexLocation = hexagonIndexOffset;
-	hexagonSubmesh.BaseVertexLocation = hexagonVertexOffset;
-
-	SubmeshGeometry tetrahedronSubmesh;
-	tetrahedronSubmesh.IndexCount = (UINT)tetrahedron.Indices32.size();
-	tetrahedronSubmesh.StartIndexLocation = tetrahedronIndexOffset;
-	tetrahedronSubmesh.BaseVertexLocation = tetrahedronVertexOffset;
-
-	SubmeshGeometry pyramidSubmesh;
-	pyramidSubmesh.IndexCount = (UINT)pyramid.Indices32.size();
-	pyramidSubmesh.StartIndexLocation = pyramidIndexOffset;
-	pyramidSubmesh.BaseVertexLocation = pyramidVertexOffset;
-
-	SubmeshGeometry diamondSubmesh;
-	diamondSubmesh.IndexCount = (UINT)diamond.Indices32.size();
-	diamondSubmesh.StartIndexLocation = diamondIndexOffset;
-	diamondSubmesh.BaseVertexLocation = diamondVertexOffset;
-
-	SubmeshGeometry coneSubmesh;
-	coneSubmesh.IndexCount = (UINT)cone.Indices32.size();
-	coneSubmesh.StartIndexLocation = coneIndexOffset;
-	coneSubmesh.BaseVertexLocation = coneVertexOffset;
-
-	SubmeshGeometry wedgeSubmesh;
-	wedgeSubmesh.IndexCount = (UINT)wedge.Indices32.size();
-	wedgeSubmesh.StartIndexLocation = wedgeIndexOffset;
-	wedgeSubmesh.BaseVertexLocation = wedgeVertexOffset;
-	
-	SubmeshGeometry quadSubmesh;
-	quadSubmesh.IndexCount = (UINT)quad.Indices32.size();
-	quadSubmesh.StartIndexLocation = quadIndexOffset;
-	quadSubmesh.BaseVertexLocation = quadVertexOffset;
-
-	SubmeshGeometry barSubmesh;
-	barSubmesh.IndexCount = (UINT)bar.Indices32.size();
-	barSubmesh.StartIndexLocation = barIndexOffset;
-	barSubmesh.BaseVertexLocation = barVertexOffset;
-
-	SubmeshGeometry boxthreeSubmesh;
-	boxthreeSubmesh.IndexCount = (UINT)boxthree.Indices32.size();
-	boxthreeSubmesh.StartIndexLocation = boxthreeIndexOffset;
-	boxthreeSubmesh.BaseVertexLocation = boxthreeVertexOffset;
-
-	SubmeshGeometry boxfourSubmesh;
-	boxfourSubmesh.IndexCount = (UINT)boxfour.Indices32.size();
-	boxfourSubmesh.StartIndexLocation = boxfourIndexOffset;
-	boxfourSubmesh.BaseVertexLocation = boxfourVertexOffset;
-
-	SubmeshGeometry boxfiveSubmesh;
-	boxfiveSubmesh.IndexCount = (UINT)boxfive.Indices32.size();
-	boxfiveSubmesh.StartIndexLocation = boxfiveIndexOffset;
-	boxfiveSubmesh.BaseVertexLocation = boxfiveVertexOffset;
-
-	SubmeshGeometry boxsixSubmesh;
-	boxsixSubmesh.IndexCount = (UINT)boxsix.Indices32.size();
-	boxsixSubmesh.StartIndexLocation = boxsixIndexOffset;
-	boxsixSubmesh.BaseVertexLocation = boxsixVertexOffset;
-
-	SubmeshGeometry cylinder2Submesh;
-	cylinder2Submesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinder2Submesh.StartIndexLocation = cylinder2IndexOffset;
-	cylinder2Submesh.BaseVertexLocation = cylinder2VertexOffset;
-
-	SubmeshGeometry cylinder3Submesh;
-	cylinder3Submesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinder3Submesh.StartIndexLocation = cylinder3IndexOffset;
-	cylinder3Submesh.BaseVertexLocation = cylinder3VertexOffset;
-
-	SubmeshGeometry cylinder4Submesh;
-	cylinder4Submesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinder4Submesh.StartIndexLocation = cylinder4IndexOffset;
-	cylinder4Submesh.BaseVertexLocation = cylinder4VertexOffset;
-
-	SubmeshGeometry cylinder5Submesh;
-	cylinder5Submesh.IndexCount = (UINT)cylinder.Indices32.size();
-	cylinder5Submesh.StartIndexLocation = cylinder5IndexOffset;
-	cylinder5Submesh.BaseVertexLocation = cylinder5VertexOffset;
-
-	SubmeshGeometry wedge2Submesh;
-	wedge2Submesh.IndexCount = (UINT)wedge.Indices32.size();
-	wedge2Submesh.StartIndexLocation = wedge2IndexOffset;
-	wedge2Submesh.BaseVertexLocation = wedge2VertexOffset;
-
-	SubmeshGeometry wedge3Submesh;
-	wedge3Submesh.IndexCount = (UINT)wedge.Indices32.size();
-	wedge3Submesh.StartIndexLocation = wedge3IndexOffset;
-	wedge3Submesh.BaseVertexLocation = wedge3VertexOffset;
-
-	SubmeshGeometry wedge4Submesh;
-	wedge4Submesh.IndexCount = (UINT)wedge.Indices32.size();
-	wedge4Submesh.StartIndexLocation = wedge4IndexOffset;
-	wedge4Submesh.BaseVertexLocation = wedge4VertexOffset;
-
-	SubmeshGeometry cone2Submesh;
-	cone2Submesh.IndexCount = (UINT)cone.Indices32.size();
-	cone2Submesh.StartIndexLocation = cone2IndexOffset;
-	cone2Submesh.BaseVertexLocation = cone2VertexOffset;
-
-	SubmeshGeometry cone3Submesh;
-	cone3Submesh.IndexCount = (UINT)cone.Indices32.size();
-	cone3Submesh.StartIndexLocation = cone3IndexOffset;
-	cone3Submesh.BaseVertexLocation = cone3VertexOffset;
-
-	SubmeshGeometry cone4Submesh;
-	cone4Submesh.IndexCount = (UINT)cone.Indices32.size();
-	cone4Submesh.StartIndexLocation = cone4IndexOffset;
-	cone4Submesh.BaseVertexLocation = cone4VertexOffset;
-
-	SubmeshGeometry cone5Submesh;
-	cone5Submesh.IndexCount = (UINT)cone.Indices32.size();
-	cone5Submesh.StartIndexLocation = cone5IndexOffset;
-	cone5Submesh.BaseVertexLocation = cone5VertexOffset;
-
-	SubmeshGeometry geosphereSubmesh;
-	geosphereSubmesh.IndexCount = (UINT)geosphere.Indices32.size();
-	geosphereSubmesh.StartIndexLocation = geosphereIndexOffset;
-	geosphereSubmesh.BaseVertexLocation = geosphereVertexOffset;
-	//
-	// Extract the vertex elements we are interested in and pack the
-	// vertices of all the meshes into one vertex buffer.
+	// Reorder the triangles of every mesh for post-transform vertex cache reuse, then
+	// the vertices for fetch locality, before the meshes are copied and concatenated.
+	// Only positions are uploaded, so vertices that share a position are welded first;
+	// the per face normals and texture coordinates they differ in are never read.
 	//
-	/////////////////////////////////////////////////////////////total vertex count
-	auto totalVertexCount =
-		box.Vertices.size() +
-		grid.Vertices.size() +
-		sphere.Vertices.size() +
-		cylinder.Vertices.size() * 5 +
-		hexagon.Vertices.size() +
-		tetrahedron.Vertices.size() +
-		pyramid.Vertices.size() +
-		diamond.Vertices.size() +
-		cone.Vertices.size() * 5 +
-		wedge.Vertices.size() * 4 +
-		quad.Vertices.size() +
-		bar.Vertices.size() +
-		boxthree.Vertices.size() +
-		boxfour.Vertices.size() +
-		boxfive.Vertices.size() +
-		boxsix.Vertices.size() +
-		geosphere.Vertices.size();
-
-	std::vector<Vertex> vertices(totalVertexCount);
-
-	////////////////////////////////////////////////////////////////////////vertices loop
-	UINT k = 0;
-	for(size_t i = 0; i < box.Vertices.size(); ++i, ++k)
+	auto optimizeMesh = [](const char* name, GeometryGenerator::MeshData& mesh)
 	{
-		vertices[k].Pos = box.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
-	}
+		size_t vertexCountBefore = mesh.Vertices.size();
+		VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh);
 
-	for(size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = grid.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::RosyBrown);
-	}
+		MeshOptimizer::WeldVertices(mesh, MeshOptimizer::WeldMode::Position);
+		MeshOptimizer::OptimizeVertexCache(mesh);
+		MeshOptimizer::OptimizeVertexFetch(mesh);
 
-	for(size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::Crimson);
-	}
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh);
 
-	for(size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gold);
-	}
+		std::ostringstream ss;
+		ss << name << ": vertices " << vertexCountBefore << " -> " << mesh.Vertices.size()
+		   << ", ACMR " << before.Acmr << " -> " << after.Acmr
+		   << ", ATVR " << before.Atvr << " -> " << after.Atvr << "\n";
+		::OutputDebugStringA(ss.str().c_str());
+	};
 
-	for (size_t i = 0; i < hexagon.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = hexagon.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Aqua);
-	}
+	optimizeMesh("box", box);
+	optimizeMesh("grid", grid);
+	optimizeMesh("sphere", sphere);
+	optimizeMesh("cylinder", cylinder);
+	optimizeMesh("hexagon", hexagon);
+	optimizeMesh("tetrahedron", tetrahedron);
+	optimizeMesh("pyramid", pyramid);
+	optimizeMesh("diamond", diamond);
+	optimizeMesh("cone", cone);
+	optimizeMesh("wedge", wedge);
+	optimizeMesh("quad", quad);
+	optimizeMesh("chocolate", bar);
+	optimizeMesh("geosphere", geosphere);
+	optimizeMesh("terrain", terrain);
 
-	for (size_t i = 0; i < tetrahedron.Vertices.size(); ++i, ++k)
+	//
+	// Split the big meshes into meshlets so they can be culled a cluster at a time.
+	// This reorders their triangles, so their vertices are put back in fetch order.
+	//
+	auto buildMeshlets = [this](const char* name, GeometryGenerator::MeshData& mesh)
 	{
-		vertices[k].Pos = tetrahedron.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gray);
-	}
+		mMeshlets[name] = MeshletBuilder::Build(mesh);
+		MeshOptimizer::OptimizeVertexFetch(mesh);
+	};
 
-	for (size_t i = 0; i < pyramid.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = pyramid.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Pink);
-	}
+	buildMeshlets("grid", grid);
+	buildMeshlets("geosphere", geosphere);
 
-	for (size_t i = 0; i < diamond.Vertices.size(); ++i, ++k)
+	//
+	// We are concatenating all the geometry into one big vertex/index buffer.  The
+	// copies of the box, cylinder, wedge and cone are the same mesh under more names,
+	// each with its own color.
+	//
+	MeshBatchBuilder batch;
+	batch.Add("box", box, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("grid", grid, XMFLOAT4(DirectX::Colors::RosyBrown));
+	batch.Add("sphere", sphere, XMFLOAT4(DirectX::Colors::Crimson));
+	batch.Add("cylinder", cylinder, XMFLOAT4(DirectX::Colors::Gold));
+	batch.Add("hexagon", hexagon, XMFLOAT4(DirectX::Colors::Aqua));
+	batch.Add("tetrahedron", tetrahedron, XMFLOAT4(DirectX::Colors::Gray));
+	batch.Add("pyramid", pyramid, XMFLOAT4(DirectX::Colors::Pink));
+	batch.Add("diamond", diamond, XMFLOAT4(DirectX::Colors::Magenta));
+	batch.Add("cone", cone, XMFLOAT4(DirectX::Colors::Green));
+	batch.Add("wedge", wedge, XMFLOAT4(DirectX::Colors::Red));
+	batch.Add("quad", quad, XMFLOAT4(DirectX::Colors::Silver));
+	batch.Add("bar", bar, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("boxthree", box, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("boxfour", box, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("boxfive", box, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("boxsix", box, XMFLOAT4(DirectX::Colors::Black));
+	batch.Add("cylinder2", cylinder, XMFLOAT4(DirectX::Colors::Gold));
+	batch.Add("cylinder3", cylinder, XMFLOAT4(DirectX::Colors::Gold));
+	batch.Add("cylinder4", cylinder, XMFLOAT4(DirectX::Colors::Gold));
+	batch.Add("cylinder5", cylinder, XMFLOAT4(DirectX::Colors::Gold));
+	batch.Add("wedge2", wedge, XMFLOAT4(DirectX::Colors::Red));
+	batch.Add("wedge3", wedge, XMFLOAT4(DirectX::Colors::Red));
+	batch.Add("wedge4", wedge, XMFLOAT4(DirectX::Colors::Red));
+	batch.Add("cone2", cone, XMFLOAT4(DirectX::Colors::Green));
+	batch.Add("cone3", cone, XMFLOAT4(DirectX::Colors::Green));
+	batch.Add("cone4", cone, XMFLOAT4(DirectX::Colors::Green));
+	batch.Add("cone5", cone, XMFLOAT4(DirectX::Colors::Green));
+	batch.Add("geosphere", geosphere, XMFLOAT4(DirectX::Colors::Crimson));
+
+	// The terrain has more vertices than 16-bit indices can reach, so it is split into
+	// 16-bit pages instead of going to the 32-bit batch.
+	UINT terrainPages = batch.AddPaged("terrain", terrain, XMFLOAT4(DirectX::Colors::DarkOliveGreen));
 	{
-		vertices[k].Pos = diamond.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Magenta);
+		std::ostringstream ss;
+		ss << "terrain: " << terrain.Vertices.size() << " vertices in " << terrainPages << " 16-bit pages\n";
+		::OutputDebugStringA(ss.str().c_str());
 	}
 
-	for (size_t i = 0; i < cone.Vertices.size(); ++i, ++k)
+	//
+	// Simplified versions of the curved shapes for drawing at a distance.  They are
+	// packed after the meshes above as "<shape>_lod1", "<shape>_lod2", ...
+	//
+	struct LodSource
 	{
-		vertices[k].Pos = cone.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Green);
-	}
+		const char* Name;
+		const GeometryGenerator::MeshData* Mesh;
+		XMFLOAT4 Color;
+	};
 
-	for (size_t i = 0; i < wedge.Vertices.size(); ++i, ++k)
+	const LodSource lodSources[] =
 	{
-		vertices[k].Pos = wedge.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Red);
-	}
+		{ "sphere", &sphere, XMFLOAT4(DirectX::Colors::Crimson) },
+		{ "cylinder", &cylinder, XMFLOAT4(DirectX::Colors::Gold) },
+		{ "cone", &cone, XMFLOAT4(DirectX::Colors::Green) },
+		{ "geosphere", &geosphere, XMFLOAT4(DirectX::Colors::Crimson) },
+	};
 
-	for (size_t i = 0; i < quad.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = quad.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Silver);
-	}
+	const UINT lodCount = 3;
+	const float lodMaxError = 0.1f;
 
-	for (size_t i = 0; i < bar.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = bar.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
-	}
+	// The batch reads the simplified meshes when it is built, so they are kept here.
+	std::vector<std::vector<MeshLod>> lodsPerSource;
+	lodsPerSource.reserve(_countof(lodSources));
 
-	for (size_t i = 0; i < boxthree.Vertices.size(); ++i, ++k)
+	for(const LodSource& source : lodSources)
 	{
-		vertices[k].Pos = boxthree.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
-	}
+		lodsPerSource.push_back(MeshSimplifier::BuildLodChain(*source.Mesh, lodCount, lodMaxError));
+		const std::vector<MeshLod>& lods = lodsPerSource.back();
 
-	for (size_t i = 0; i < boxfour.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = boxfour.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
+		// A chain is drawn from one geometry, so its levels use the source's index width.
+		MeshBatchBuilder::IndexWidth width = MeshBatchBuilder::GetRequiredWidth(*source.Mesh);
+		for(size_t level = 0; level < lods.size(); ++level)
+			batch.Add(std::string(source.Name) + "_lod" + std::to_string(level + 1), lods[level].Mesh, source.Color, width);
 	}
 
-	for (size_t i = 0; i < boxfive.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = boxfive.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
-	}
+	batch.Build(&mThreadPool);
+	mDrawArgColors = batch.GetColors();
+	mDrawArgPageCounts = batch.GetPageCounts();
 
-	for (size_t i = 0; i < boxsix.Vertices.size(); ++i, ++k)
+	for(size_t i = 0; i < _countof(lodSources); ++i)
 	{
-		vertices[k].Pos = boxsix.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Black);
-	}
+		const LodSource& source = lodSources[i];
+		const std::vector<MeshLod>& lods = lodsPerSource[i];
 
-	for (size_t i = 0; i < cylinder2.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder2.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gold);
-	}
+		LodChain& chain = mLodChains[source.Name];
+		chain.Levels.push_back({ source.Name, batch.GetSubmesh(source.Name), 0.0f });
 
-	for (size_t i = 0; i < cylinder3.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder3.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gold);
-	}
+		std::ostringstream ss;
+		ss << source.Name << " LODs: " << source.Mesh->Indices32.size() / 3;
 
-	for (size_t i = 0; i < cylinder4.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder4.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gold);
-	}
+		for(size_t level = 0; level < lods.size(); ++level)
+		{
+			std::string name = std::string(source.Name) + "_lod" + std::to_string(level + 1);
+			const SubmeshGeometry& submesh = batch.GetSubmesh(name);
+			chain.Levels.push_back({ name, submesh, lods[level].Error });
 
-	for (size_t i = 0; i < cylinder5.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cylinder5.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Gold);
-	}
+			ss << " -> " << submesh.IndexCount / 3 << " (error " << lods[level].Error << ")";
+		}
 
-	for (size_t i = 0; i < wedge2.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = wedge2.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Red);
+		ss << " triangles\n";
+		::OutputDebugStringA(ss.str().c_str());
 	}
 
-	for (size_t i = 0; i < wedge3.Vertices.size(); ++i, ++k)
+	// The copies of the cylinder and cone draw the same mesh, so they share its levels.
+	struct LodCopy
 	{
-		vertices[k].Pos = wedge3.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Red);
-	}
+		const char* Name;
+		const char* Source;
+	};
 
-	for (size_t i = 0; i < wedge4.Vertices.size(); ++i, ++k)
+	const LodCopy lodCopies[] =
 	{
-		vertices[k].Pos = wedge4.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Red);
-	}
+		{ "cylinder2", "cylinder" },
+		{ "cylinder3", "cylinder" },
+		{ "cylinder4", "cylinder" },
+		{ "cylinder5", "cylinder" },
+		{ "cone2", "cone" },
+		{ "cone3", "cone" },
+		{ "cone4", "cone" },
+		{ "cone5", "cone" },
+	};
 
-	for (size_t i = 0; i < cone2.Vertices.size(); ++i, ++k)
+	for(const LodCopy& copy : lodCopies)
 	{
-		vertices[k].Pos = cone2.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Green);
+		LodChain chain = mLodChains[copy.Source];
+		chain.Levels[0].DrawArg = copy.Name;
+		chain.Levels[0].Submesh = batch.GetSubmesh(copy.Name);
+		mLodChains[copy.Name] = chain;
 	}
 
-	for (size_t i = 0; i < cone3.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = cone3.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Green);
-	}
+	// Meshes of up to 64K vertices, and the pages of bigger ones, use 16-bit indices.
+	// A bigger mesh that has to stay one range gets a second geometry with 32-bit
+	// indices, which only exists if something needs it.
+	BuildPackedGeometry("shapeGeo", batch.GetVertices(MeshBatchBuilder::IndexWidth::Bits16),
+		batch.GetIndices16(), batch.GetDrawArgs(MeshBatchBuilder::IndexWidth::Bits16));
 
-	for (size_t i = 0; i < cone4.Vertices.size(); ++i, ++k)
+	if(!batch.GetDrawArgs(MeshBatchBuilder::IndexWidth::Bits32).empty())
 	{
-		vertices[k].Pos = cone4.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Green);
+		BuildPackedGeometry("shapeGeo32", batch.GetVertices(MeshBatchBuilder::IndexWidth::Bits32),
+			batch.GetIndices32(), batch.GetDrawArgs(MeshBatchBuilder::IndexWidth::Bits32));
 	}
 
-	for (size_t i = 0; i < cone5.Vertices.size(); ++i, ++k)
+	for(auto& e : mLodChains)
 	{
-		vertices[k].Pos = cone5.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Green);
-	}
+		LodChain& chain = e.second;
+		MeshGeometry* geo = mGeometries[batch.GetIndexWidth(chain.Levels[0].DrawArg) == MeshBatchBuilder::IndexWidth::Bits16 ?
+			"shapeGeo" : "shapeGeo32"].get();
 
-	for (size_t i = 0; i < geosphere.Vertices.size(); ++i, ++k)
-	{
-		vertices[k].Pos = geosphere.Vertices[i].Position;
-		vertices[k].Color = XMFLOAT4(DirectX::Colors::Crimson);
-	}
+		for(LodLevel& level : chain.Levels)
+			level.Submesh = geo->DrawArgs[level.DrawArg];
 
-	/////////////////////////////////////////////////////////////////////insert indices
-	std::vector<std::uint16_t> indices;
-	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
-	indices.insert(indices.end(), std::begin(hexagon.GetIndices16()), std::end(hexagon.GetIndices16()));
-	indices.insert(indices.end(), std::begin(tetrahedron.GetIndices16()), std::end(tetrahedron.GetIndices16()));
-	indices.insert(indices.end(), std::begin(pyramid.GetIndices16()), std::end(pyramid.GetIndices16()));
-	indices.insert(indices.end(), std::begin(diamond.GetIndices16()), std::end(diamond.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone.GetIndices16()), std::end(cone.GetIndices16()));
-	indices.insert(indices.end(), std::begin(wedge.GetIndices16()), std::end(wedge.GetIndices16()));
-	indices.insert(indices.end(), std::begin(quad.GetIndices16()), std::end(quad.GetIndices16()));
-	indices.insert(indices.end(), std::begin(bar.GetIndices16()), std::end(bar.GetIndices16()));
-	indices.insert(indices.end(), std::begin(boxthree.GetIndices16()), std::end(boxthree.GetIndices16()));
-	indices.insert(indices.end(), std::begin(boxfour.GetIndices16()), std::end(boxfour.GetIndices16()));
-	indices.insert(indices.end(), std::begin(boxfive.GetIndices16()), std::end(boxfive.GetIndices16()));
-	indices.insert(indices.end(), std::begin(boxsix.GetIndices16()), std::end(boxsix.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder2.GetIndices16()), std::end(cylinder2.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder3.GetIndices16()), std::end(cylinder3.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder4.GetIndices16()), std::end(cylinder4.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cylinder5.GetIndices16()), std::end(cylinder5.GetIndices16()));
-	indices.insert(indices.end(), std::begin(wedge2.GetIndices16()), std::end(wedge2.GetIndices16()));
-	indices.insert(indices.end(), std::begin(wedge3.GetIndices16()), std::end(wedge3.GetIndices16()));
-	indices.insert(indices.end(), std::begin(wedge4.GetIndices16()), std::end(wedge4.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone2.GetIndices16()), std::end(cone2.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone3.GetIndices16()), std::end(cone3.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone4.GetIndices16()), std::end(cone4.GetIndices16()));
-	indices.insert(indices.end(), std::begin(cone5.GetIndices16()), std::end(cone5.GetIndices16()));
-	indices.insert(indices.end(), std::begin(geosphere.GetIndices16()), std::end(geosphere.GetIndices16()));
+		chain.Bounds = chain.Levels[0].Submesh.SphereBounds;
+	}
+}
 
-    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-    const UINT ibByteSize = (UINT)indices.size()  * sizeof(std::uint16_t);
+template<typename Index>
+void ShapesApp::BuildPackedGeometry(const std::string& name, std::vector<Vertex>& vertices, std::vector<Index>& indices,
+	const std::unordered_map<std::string, SubmeshGeometry>& drawArgs)
+{
+	static_assert(sizeof(Index) == 2 || sizeof(Index) == 4, "Index buffers are 16 or 32 bits.");
 
 	auto geo = std::make_unique<MeshGeometry>();
-	geo->Name = "shapeGeo";
+	geo->Name = name;
+	geo->DrawArgs = drawArgs;
+
+	// Meshes packed under several names are byte for byte the same; upload them once.
+	DeduplicateSubmeshes(vertices, indices, geo->DrawArgs);
+
+    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+    const UINT ibByteSize = (UINT)indices.size()  * sizeof(Index);
 
 	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
 	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
@@ -1013,42 +1475,208 @@ void ShapesApp::BuildShapeGeometry()////////////////////////////////////////////
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geo->IndexFormat = sizeof(Index) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
-	/////////////////////////////////////////////////////////////draw 
-	geo->DrawArgs["box"] = boxSubmesh;
-	geo->DrawArgs["grid"] = gridSubmesh;
-	geo->DrawArgs["sphere"] = sphereSubmesh;
-	geo->DrawArgs["cylinder"] = cylinderSubmesh;
-	geo->DrawArgs["hexagon"] = hexagonSubmesh;
-	geo->DrawArgs["tetrahedron"] = tetrahedronSubmesh;
-	geo->DrawArgs["pyramid"] = pyramidSubmesh;
-	geo->DrawArgs["diamond"] = diamondSubmesh;
-	geo->DrawArgs["cone"] = coneSubmesh;
-	geo->DrawArgs["wedge"] = wedgeSubmesh;
-	geo->DrawArgs["quad"] = quadSubmesh;
-	geo->DrawArgs["bar"] = barSubmesh;
-	geo->DrawArgs["boxthree"] = boxthreeSubmesh;
-	geo->DrawArgs["boxfour"] = boxfourSubmesh;
-	geo->DrawArgs["boxfive"] = boxfiveSubmesh;
-	geo->DrawArgs["boxsix"] = boxsixSubmesh;
-	geo->DrawArgs["cylinder2"] = cylinder2Submesh;
-	geo->DrawArgs["cylinder3"] = cylinder3Submesh;
-	geo->DrawArgs["cylinder4"] = cylinder4Submesh;
-	geo->DrawArgs["cylinder5"] = cylinder5Submesh;
-	geo->DrawArgs["wedge2"] = wedge2Submesh;
-	geo->DrawArgs["wedge3"] = wedge3Submesh;
-	geo->DrawArgs["wedge4"] = wedge4Submesh;
-	geo->DrawArgs["cone2"] = cone2Submesh;
-	geo->DrawArgs["cone3"] = cone3Submesh;
-	geo->DrawArgs["cone4"] = cone4Submesh;
-	geo->DrawArgs["cone5"] = cone5Submesh;
-	geo->DrawArgs["geosphere"] = geosphereSubmesh;
+	//
+	// Bounds of every submesh.  Each one owns the vertices from its BaseVertexLocation
+	// up to the next submesh's, so they are read straight out of the packed buffer.
+	//
+	std::vector<SubmeshGeometry*> submeshesByVertex;
+	for(auto& e : geo->DrawArgs)
+		submeshesByVertex.push_back(&e.second);
+
+	std::sort(submeshesByVertex.begin(), submeshesByVertex.end(),
+		[](const SubmeshGeometry* a, const SubmeshGeometry* b) { return a->BaseVertexLocation < b->BaseVertexLocation; });
+
+	for(size_t i = 0; i < submeshesByVertex.size(); ++i)
+	{
+		SubmeshGeometry* submesh = submeshesByVertex[i];
+		size_t begin = (size_t)submesh->BaseVertexLocation;
+
+		// Names sharing a range after deduplication end at the next different base.
+		size_t end = vertices.size();
+		for(size_t next = i + 1; next < submeshesByVertex.size(); ++next)
+		{
+			if(submeshesByVertex[next]->BaseVertexLocation != submesh->BaseVertexLocation)
+			{
+				end = (size_t)submeshesByVertex[next]->BaseVertexLocation;
+				break;
+			}
+		}
+
+		BoundsUtil::ComputeBounds(&vertices[begin].Pos, end - begin, sizeof(Vertex),
+			submesh->Bounds, submesh->SphereBounds);
+	}
 
 	mGeometries[geo->Name] = std::move(geo);
 }
 
+template<typename Index>
+void ShapesApp::DeduplicateSubmeshes(std::vector<Vertex>& vertices, std::vector<Index>& indices,
+	std::unordered_map<std::string, SubmeshGeometry>& drawArgs)
+{
+	//
+	// A submesh's vertices run from its BaseVertexLocation up to the next distinct
+	// base in the buffer.  Indices are relative to the base, so two submeshes with
+	// the same vertex bytes and the same index values draw the same thing.
+	//
+
+	std::vector<INT> bases;
+	for(const auto& arg : drawArgs)
+		bases.push_back(arg.second.BaseVertexLocation);
+	std::sort(bases.begin(), bases.end());
+	bases.erase(std::unique(bases.begin(), bases.end()), bases.end());
+
+	auto vertexEnd = [&](INT base)
+	{
+		auto next = std::upper_bound(bases.begin(), bases.end(), base);
+		return next != bases.end() ? (size_t)*next : vertices.size();
+	};
+
+	struct Range
+	{
+		INT BaseVertex;
+		size_t VertexCount;
+		UINT StartIndex;
+		UINT IndexCount;
+
+		// Index into the ranges of the first one with the same content.
+		size_t Canonical;
+
+		// Location in the compacted buffers.
+		INT NewBaseVertex;
+		UINT NewStartIndex;
+	};
+
+	// Distinct ranges in buffer order, so the first copy of each mesh is the one kept.
+	std::vector<Range> ranges;
+	for(const auto& arg : drawArgs)
+	{
+		const SubmeshGeometry& submesh = arg.second;
+		auto existing = std::find_if(ranges.begin(), ranges.end(), [&](const Range& r)
+		{
+			return r.BaseVertex == submesh.BaseVertexLocation && r.StartIndex == submesh.StartIndexLocation &&
+				r.IndexCount == submesh.IndexCount;
+		});
+
+		if(existing == ranges.end())
+		{
+			Range range = {};
+			range.BaseVertex = submesh.BaseVertexLocation;
+			range.VertexCount = vertexEnd(submesh.BaseVertexLocation) - (size_t)submesh.BaseVertexLocation;
+			range.StartIndex = submesh.StartIndexLocation;
+			range.IndexCount = submesh.IndexCount;
+			ranges.push_back(range);
+		}
+	}
+
+	std::sort(ranges.begin(), ranges.end(),
+		[](const Range& a, const Range& b) { return a.StartIndex < b.StartIndex; });
+
+	// FNV-1a over the vertex bytes and the index values.  Equal hashes are confirmed
+	// by comparing the content.
+	auto hashRange = [&](const Range& r)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		auto hashBytes = [&](const void* data, size_t byteCount)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			for(size_t i = 0; i < byteCount; ++i)
+				hash = (hash ^ bytes[i])*1099511628211ull;
+		};
+
+		hashBytes(&vertices[r.BaseVertex], r.VertexCount*sizeof(Vertex));
+		hashBytes(&indices[r.StartIndex], r.IndexCount*sizeof(Index));
+		return hash;
+	};
+
+	auto sameContent = [&](const Range& a, const Range& b)
+	{
+		return a.VertexCount == b.VertexCount && a.IndexCount == b.IndexCount &&
+			std::memcmp(&vertices[a.BaseVertex], &vertices[b.BaseVertex], a.VertexCount*sizeof(Vertex)) == 0 &&
+			std::equal(indices.begin() + a.StartIndex, indices.begin() + a.StartIndex + a.IndexCount,
+				indices.begin() + b.StartIndex);
+	};
+
+	std::unordered_multimap<std::uint64_t, size_t> rangesByHash;
+	size_t duplicateCount = 0;
+
+	for(size_t i = 0; i < ranges.size(); ++i)
+	{
+		std::uint64_t hash = hashRange(ranges[i]);
+		ranges[i].Canonical = i;
+
+		auto candidates = rangesByHash.equal_range(hash);
+		for(auto it = candidates.first; it != candidates.second; ++it)
+		{
+			if(sameContent(ranges[it->second], ranges[i]))
+			{
+				ranges[i].Canonical = it->second;
+				++duplicateCount;
+				break;
+			}
+		}
+
+		if(ranges[i].Canonical == i)
+			rangesByHash.insert(std::make_pair(hash, i));
+	}
+
+	//
+	// Copy the unique ranges into new buffers.  Several index ranges can share one
+	// vertex range, so each vertex range is copied the first time it is reached.
+	//
+
+	std::vector<Vertex> uniqueVertices;
+	std::vector<Index> uniqueIndices;
+	std::unordered_map<INT, INT> newBases;
+
+	for(Range& range : ranges)
+	{
+		if(range.Canonical != (size_t)(&range - ranges.data()))
+			continue;
+
+		auto newBase = newBases.find(range.BaseVertex);
+		if(newBase == newBases.end())
+		{
+			newBase = newBases.insert(std::make_pair(range.BaseVertex, (INT)uniqueVertices.size())).first;
+			uniqueVertices.insert(uniqueVertices.end(), vertices.begin() + range.BaseVertex,
+				vertices.begin() + range.BaseVertex + range.VertexCount);
+		}
+
+		range.NewBaseVertex = newBase->second;
+		range.NewStartIndex = (UINT)uniqueIndices.size();
+		uniqueIndices.insert(uniqueIndices.end(), indices.begin() + range.StartIndex,
+			indices.begin() + range.StartIndex + range.IndexCount);
+	}
+
+	for(auto& arg : drawArgs)
+	{
+		SubmeshGeometry& submesh = arg.second;
+		auto range = std::find_if(ranges.begin(), ranges.end(), [&](const Range& r)
+		{
+			return r.BaseVertex == submesh.BaseVertexLocation && r.StartIndex == submesh.StartIndexLocation &&
+				r.IndexCount == submesh.IndexCount;
+		});
+
+		const Range& canonical = ranges[range->Canonical];
+		submesh.BaseVertexLocation = canonical.NewBaseVertex;
+		submesh.StartIndexLocation = canonical.NewStartIndex;
+	}
+
+	size_t bytesBefore = vertices.size()*sizeof(Vertex) + indices.size()*sizeof(Index);
+	size_t bytesAfter = uniqueVertices.size()*sizeof(Vertex) + uniqueIndices.size()*sizeof(Index);
+
+	std::ostringstream ss;
+	ss << "Geometry dedup: " << duplicateCount << " of " << ranges.size() << " submeshes were copies, vertices "
+	   << vertices.size() << " -> " << uniqueVertices.size() << ", indices " << indices.size() << " -> "
+	   << uniqueIndices.size() << ", " << bytesBefore - bytesAfter << " of " << bytesBefore << " bytes saved\n";
+	::OutputDebugStringA(ss.str().c_str());
+
+	vertices.swap(uniqueVertices);
+	indices.swap(uniqueIndices);
+}
+
 void ShapesApp::BuildPSOs()
 {
     D3D12_GRAPHICS_PIPELINE_STATE_DESC opaquePsoDesc;
@@ -1089,15 +1717,61 @@ void ShapesApp::BuildPSOs()
     D3D12_GRAPHICS_PIPELINE_STATE_DESC opaqueWireframePsoDesc = opaquePsoDesc;
     opaqueWireframePsoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
     ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaqueWireframePsoDesc, IID_PPV_ARGS(&mPSOs["opaque_wireframe"])));
+
+    //
+    // Instanced variants of both.
+    //
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPsoDesc = opaquePsoDesc;
+    instancedPsoDesc.InputLayout = { mInstancedInputLayout.data(), (UINT)mInstancedInputLayout.size() };
+    instancedPsoDesc.VS =
+    {
+        reinterpret_cast<BYTE*>(mShaders["instancedVS"]->GetBufferPointer()),
+        mShaders["instancedVS"]->GetBufferSize()
+    };
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedPsoDesc, IID_PPV_ARGS(&mPSOs["opaque_instanced"])));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedWireframePsoDesc = instancedPsoDesc;
+    instancedWireframePsoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedWireframePsoDesc, IID_PPV_ARGS(&mPSOs["opaque_instanced_wireframe"])));
+
+    //
+    // And the variants reading the object buffer.
+    //
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC objectBufferPsoDesc = opaquePsoDesc;
+    objectBufferPsoDesc.InputLayout = { mObjectBufferInputLayout.data(), (UINT)mObjectBufferInputLayout.size() };
+    objectBufferPsoDesc.VS =
+    {
+        reinterpret_cast<BYTE*>(mShaders["objectBufferVS"]->GetBufferPointer()),
+        mShaders["objectBufferVS"]->GetBufferSize()
+    };
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&objectBufferPsoDesc, IID_PPV_ARGS(&mPSOs["opaque_objects"])));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC objectBufferWireframePsoDesc = objectBufferPsoDesc;
+    objectBufferWireframePsoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&objectBufferWireframePsoDesc, IID_PPV_ARGS(&mPSOs["opaque_objects_wireframe"])));
 }
 
 void ShapesApp::BuildFrameResources()
 {
     for(int i = 0; i < gNumFrameResources; ++i)
     {
-        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(),
-            1, (UINT)mAllRitems.size()));
+        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(), (UINT)mAllRitems.size()));
     }
+
+	// Queue every item once so each object buffer starts out complete.
+	mObjectData.resize(mAllRitems.size());
+	mObjectDirtyFrames.assign(mAllRitems.size(), 0);
+	for(auto& e : mAllRitems)
+		MarkObjectDirty(e.get());
+
+	// Room for every item to be drawn on its own in each frame in flight, in the mode
+	// with per object constants.
+	UINT64 frameByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants)) +
+		mAllRitems.size()*(d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants)) + sizeof(InstanceData));
+	mUploadRing = std::make_unique<UploadRingBuffer>(md3dDevice.Get(),
+		std::max(gMinUploadRingByteSize, frameByteSize*gNumFrameResources));
 }
 
 void ShapesApp::BuildRenderItems()/////////////////////////////////////////////////////////////////render
@@ -1108,10 +1782,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 
 
 	auto boxthreeRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&boxthreeRitem->World, XMMatrixScaling(5.0f, 2.0f, 0.5f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(-3.0f, 0.5f, -8.0f));
+	boxthreeRitem->World.Store(XMMatrixScaling(5.0f, 2.0f, 0.5f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(-3.0f, 0.5f, -8.0f));
 	boxthreeRitem->ObjCBIndex = j;
 	boxthreeRitem->Geo = mGeometries["shapeGeo"].get();
 	boxthreeRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	boxthreeRitem->DrawArg = "boxthree";
 	boxthreeRitem->IndexCount = boxthreeRitem->Geo->DrawArgs["boxthree"].IndexCount;
 	boxthreeRitem->StartIndexLocation = boxthreeRitem->Geo->DrawArgs["boxthree"].StartIndexLocation;
 	boxthreeRitem->BaseVertexLocation = boxthreeRitem->Geo->DrawArgs["boxthree"].BaseVertexLocation;
@@ -1119,10 +1794,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto boxfourRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&boxfourRitem->World, XMMatrixScaling(5.0f, 2.0f, 0.50f)*XMMatrixRotationY(deg2rad(-45))*XMMatrixTranslation(3.0f, 0.5f, -8.0f));
+	boxfourRitem->World.Store(XMMatrixScaling(5.0f, 2.0f, 0.50f)*XMMatrixRotationY(deg2rad(-45))*XMMatrixTranslation(3.0f, 0.5f, -8.0f));
 	boxfourRitem->ObjCBIndex = j;
 	boxfourRitem->Geo = mGeometries["shapeGeo"].get();
 	boxfourRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	boxfourRitem->DrawArg = "boxfour";
 	boxfourRitem->IndexCount = boxfourRitem->Geo->DrawArgs["boxfour"].IndexCount;
 	boxfourRitem->StartIndexLocation = boxfourRitem->Geo->DrawArgs["boxfour"].StartIndexLocation;
 	boxfourRitem->BaseVertexLocation = boxfourRitem->Geo->DrawArgs["boxfour"].BaseVertexLocation;
@@ -1130,10 +1806,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto boxfiveRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&boxfiveRitem->World, XMMatrixScaling(5.0f, 2.0f, 0.5f)*XMMatrixRotationY(deg2rad(90))*XMMatrixTranslation(6.0f, 0.5f, -1.0f));
+	boxfiveRitem->World.Store(XMMatrixScaling(5.0f, 2.0f, 0.5f)*XMMatrixRotationY(deg2rad(90))*XMMatrixTranslation(6.0f, 0.5f, -1.0f));
 	boxfiveRitem->ObjCBIndex = j;
 	boxfiveRitem->Geo = mGeometries["shapeGeo"].get();
 	boxfiveRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	boxfiveRitem->DrawArg = "boxfive";
 	boxfiveRitem->IndexCount = boxfiveRitem->Geo->DrawArgs["boxfive"].IndexCount;
 	boxfiveRitem->StartIndexLocation = boxfiveRitem->Geo->DrawArgs["boxfive"].StartIndexLocation;
 	boxfiveRitem->BaseVertexLocation = boxfiveRitem->Geo->DrawArgs["boxfive"].BaseVertexLocation;
@@ -1141,10 +1818,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto boxsixRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&boxsixRitem->World, XMMatrixScaling(5.0f, 2.0f, 0.50f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(3.0f, 0.5f, 6.0f));
+	boxsixRitem->World.Store(XMMatrixScaling(5.0f, 2.0f, 0.50f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(3.0f, 0.5f, 6.0f));
 	boxsixRitem->ObjCBIndex = j;
 	boxsixRitem->Geo = mGeometries["shapeGeo"].get();
 	boxsixRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	boxsixRitem->DrawArg = "boxsix";
 	boxsixRitem->IndexCount = boxsixRitem->Geo->DrawArgs["boxsix"].IndexCount;
 	boxsixRitem->StartIndexLocation = boxsixRitem->Geo->DrawArgs["boxsix"].StartIndexLocation;
 	boxsixRitem->BaseVertexLocation = boxsixRitem->Geo->DrawArgs["boxsix"].BaseVertexLocation;
@@ -1152,10 +1830,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
     auto gridRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&gridRitem->World, XMMatrixScaling(0.05f, 0.0f, 0.05f)*XMMatrixRotationX(deg2rad(-90))*XMMatrixTranslation(0.0f, 0.5f, -10.25f));
+	gridRitem->World.Store(XMMatrixScaling(0.05f, 0.0f, 0.05f)*XMMatrixRotationX(deg2rad(-90))*XMMatrixTranslation(0.0f, 0.5f, -10.25f));
 	gridRitem->ObjCBIndex = j;
 	gridRitem->Geo = mGeometries["shapeGeo"].get();
 	gridRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    gridRitem->DrawArg = "grid";
     gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
     gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
     gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
@@ -1163,10 +1842,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto hexRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&hexRitem->World, XMMatrixRotationY(deg2rad(0)));
+	hexRitem->World.Store(XMMatrixRotationY(deg2rad(0)));
 	hexRitem->ObjCBIndex = j;
 	hexRitem->Geo = mGeometries["shapeGeo"].get();
 	hexRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	hexRitem->DrawArg = "hexagon";
 	hexRitem->IndexCount = hexRitem->Geo->DrawArgs["hexagon"].IndexCount;
 	hexRitem->StartIndexLocation = hexRitem->Geo->DrawArgs["hexagon"].StartIndexLocation;
 	hexRitem->BaseVertexLocation = hexRitem->Geo->DrawArgs["hexagon"].BaseVertexLocation;
@@ -1175,10 +1855,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	
 
 	auto tetraRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&tetraRitem->World, XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 2.0f, -10.0f));
+	tetraRitem->World.Store(XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 2.0f, -10.0f));
 	tetraRitem->ObjCBIndex = j;
 	tetraRitem->Geo = mGeometries["shapeGeo"].get();
 	tetraRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	tetraRitem->DrawArg = "tetrahedron";
 	tetraRitem->IndexCount = tetraRitem->Geo->DrawArgs["tetrahedron"].IndexCount;
 	tetraRitem->StartIndexLocation = tetraRitem->Geo->DrawArgs["tetrahedron"].StartIndexLocation;
 	tetraRitem->BaseVertexLocation = tetraRitem->Geo->DrawArgs["tetrahedron"].BaseVertexLocation;
@@ -1186,10 +1867,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto sphereRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&sphereRitem->World, XMMatrixScaling(1.0f, 1.0f, 1.0f)*XMMatrixTranslation(0.0f, 3.5f, -10.5f));
+	sphereRitem->World.Store(XMMatrixScaling(1.0f, 1.0f, 1.0f)*XMMatrixTranslation(0.0f, 3.5f, -10.5f));
 	sphereRitem->ObjCBIndex = j;
 	sphereRitem->Geo = mGeometries["shapeGeo"].get();
 	sphereRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	sphereRitem->DrawArg = "sphere";
 	sphereRitem->IndexCount = sphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 	sphereRitem->StartIndexLocation = sphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 	sphereRitem->BaseVertexLocation = sphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
@@ -1197,10 +1879,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto pyramidRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&pyramidRitem->World, XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 0.0f, 0.0f));
+	pyramidRitem->World.Store(XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 0.0f, 0.0f));
 	pyramidRitem->ObjCBIndex = j;
 	pyramidRitem->Geo = mGeometries["shapeGeo"].get();
 	pyramidRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	pyramidRitem->DrawArg = "pyramid";
 	pyramidRitem->IndexCount = pyramidRitem->Geo->DrawArgs["pyramid"].IndexCount;
 	pyramidRitem->StartIndexLocation = pyramidRitem->Geo->DrawArgs["pyramid"].StartIndexLocation;
 	pyramidRitem->BaseVertexLocation = pyramidRitem->Geo->DrawArgs["pyramid"].BaseVertexLocation;
@@ -1208,10 +1891,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto diamondRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&diamondRitem->World, XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 1.0f, -3.0f));
+	diamondRitem->World.Store(XMMatrixScaling(2.0f, 2.0f, 2.0f)*XMMatrixRotationX(0.0f)*XMMatrixTranslation(0.0f, 1.0f, -3.0f));
 	diamondRitem->ObjCBIndex = j;
 	diamondRitem->Geo = mGeometries["shapeGeo"].get();
 	diamondRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	diamondRitem->DrawArg = "diamond";
 	diamondRitem->IndexCount = diamondRitem->Geo->DrawArgs["diamond"].IndexCount;
 	diamondRitem->StartIndexLocation = diamondRitem->Geo->DrawArgs["diamond"].StartIndexLocation;
 	diamondRitem->BaseVertexLocation = diamondRitem->Geo->DrawArgs["diamond"].BaseVertexLocation;
@@ -1219,10 +1903,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 	
 	auto coneRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&coneRitem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 3.0f, -5.0f));
+	coneRitem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 3.0f, -5.0f));
 	coneRitem->ObjCBIndex = j;
 	coneRitem->Geo = mGeometries["shapeGeo"].get();
 	coneRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	coneRitem->DrawArg = "cone";
 	coneRitem->IndexCount = coneRitem->Geo->DrawArgs["cone"].IndexCount;
 	coneRitem->StartIndexLocation = coneRitem->Geo->DrawArgs["cone"].StartIndexLocation;
 	coneRitem->BaseVertexLocation = coneRitem->Geo->DrawArgs["cone"].BaseVertexLocation;
@@ -1230,10 +1915,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cone2Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cone2Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 3.0f, 3.0f));
+	cone2Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 3.0f, 3.0f));
 	cone2Ritem->ObjCBIndex = j;
 	cone2Ritem->Geo = mGeometries["shapeGeo"].get();
 	cone2Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cone2Ritem->DrawArg = "cone2";
 	cone2Ritem->IndexCount = cone2Ritem->Geo->DrawArgs["cone2"].IndexCount;
 	cone2Ritem->StartIndexLocation = cone2Ritem->Geo->DrawArgs["cone2"].StartIndexLocation;
 	cone2Ritem->BaseVertexLocation = cone2Ritem->Geo->DrawArgs["cone2"].BaseVertexLocation;
@@ -1241,10 +1927,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cone3Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cone3Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(0.0f, 3.0f, 9.0f));
+	cone3Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(0.0f, 3.0f, 9.0f));
 	cone3Ritem->ObjCBIndex = j;
 	cone3Ritem->Geo = mGeometries["shapeGeo"].get();
 	cone3Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cone3Ritem->DrawArg = "cone3";
 	cone3Ritem->IndexCount = cone3Ritem->Geo->DrawArgs["cone3"].IndexCount;
 	cone3Ritem->StartIndexLocation = cone3Ritem->Geo->DrawArgs["cone3"].StartIndexLocation;
 	cone3Ritem->BaseVertexLocation = cone3Ritem->Geo->DrawArgs["cone3"].BaseVertexLocation;
@@ -1252,10 +1939,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cone4Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cone4Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 3.0f, -5.0f));
+	cone4Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 3.0f, -5.0f));
 	cone4Ritem->ObjCBIndex = j;
 	cone4Ritem->Geo = mGeometries["shapeGeo"].get();
 	cone4Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cone4Ritem->DrawArg = "cone4";
 	cone4Ritem->IndexCount = cone4Ritem->Geo->DrawArgs["cone4"].IndexCount;
 	cone4Ritem->StartIndexLocation = cone4Ritem->Geo->DrawArgs["cone4"].StartIndexLocation;
 	cone4Ritem->BaseVertexLocation = cone4Ritem->Geo->DrawArgs["cone4"].BaseVertexLocation;
@@ -1263,10 +1951,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cone5Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cone5Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 3.0f, 3.0f));
+	cone5Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 3.0f, 3.0f));
 	cone5Ritem->ObjCBIndex = j;
 	cone5Ritem->Geo = mGeometries["shapeGeo"].get();
 	cone5Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cone5Ritem->DrawArg = "cone5";
 	cone5Ritem->IndexCount = cone5Ritem->Geo->DrawArgs["cone5"].IndexCount;
 	cone5Ritem->StartIndexLocation = cone5Ritem->Geo->DrawArgs["cone5"].StartIndexLocation;
 	cone5Ritem->BaseVertexLocation = cone5Ritem->Geo->DrawArgs["cone5"].BaseVertexLocation;
@@ -1274,10 +1963,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 	
 	auto cylinderRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cylinderRitem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 1.0f, -5.0f));
+	cylinderRitem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 1.0f, -5.0f));
 	cylinderRitem->ObjCBIndex = j;
 	cylinderRitem->Geo = mGeometries["shapeGeo"].get();
 	cylinderRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinderRitem->DrawArg = "cylinder5";
 	cylinderRitem->IndexCount = cylinderRitem->Geo->DrawArgs["cylinder5"].IndexCount;
 	cylinderRitem->StartIndexLocation = cylinderRitem->Geo->DrawArgs["cylinder5"].StartIndexLocation;
 	cylinderRitem->BaseVertexLocation = cylinderRitem->Geo->DrawArgs["cylinder5"].BaseVertexLocation;
@@ -1285,10 +1975,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cylinder2Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cylinder2Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 1.0f, 3.0f));
+	cylinder2Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(6.0f, 1.0f, 3.0f));
 	cylinder2Ritem->ObjCBIndex = j;
 	cylinder2Ritem->Geo = mGeometries["shapeGeo"].get();
 	cylinder2Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinder2Ritem->DrawArg = "cylinder2";
 	cylinder2Ritem->IndexCount = cylinder2Ritem->Geo->DrawArgs["cylinder2"].IndexCount;
 	cylinder2Ritem->StartIndexLocation = cylinder2Ritem->Geo->DrawArgs["cylinder2"].StartIndexLocation;
 	cylinder2Ritem->BaseVertexLocation = cylinder2Ritem->Geo->DrawArgs["cylinder2"].BaseVertexLocation;
@@ -1296,10 +1987,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cylinder3Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cylinder3Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(0.0f, 1.0f, 9.0f));
+	cylinder3Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(0.0f, 1.0f, 9.0f));
 	cylinder3Ritem->ObjCBIndex = j;
 	cylinder3Ritem->Geo = mGeometries["shapeGeo"].get();
 	cylinder3Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinder3Ritem->DrawArg = "cylinder3";
 	cylinder3Ritem->IndexCount = cylinder3Ritem->Geo->DrawArgs["cylinder3"].IndexCount;
 	cylinder3Ritem->StartIndexLocation = cylinder3Ritem->Geo->DrawArgs["cylinder3"].StartIndexLocation;
 	cylinder3Ritem->BaseVertexLocation = cylinder3Ritem->Geo->DrawArgs["cylinder3"].BaseVertexLocation;
@@ -1307,10 +1999,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cylinder4Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cylinder4Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 1.0f, 3.0f));
+	cylinder4Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 1.0f, 3.0f));
 	cylinder4Ritem->ObjCBIndex = j;
 	cylinder4Ritem->Geo = mGeometries["shapeGeo"].get();
 	cylinder4Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinder4Ritem->DrawArg = "cylinder4";
 	cylinder4Ritem->IndexCount = cylinder4Ritem->Geo->DrawArgs["cylinder4"].IndexCount;
 	cylinder4Ritem->StartIndexLocation = cylinder4Ritem->Geo->DrawArgs["cylinder4"].StartIndexLocation;
 	cylinder4Ritem->BaseVertexLocation = cylinder4Ritem->Geo->DrawArgs["cylinder4"].BaseVertexLocation;
@@ -1318,10 +2011,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto cylinder5Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&cylinder5Ritem->World, XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 1.0f, -5.0f));
+	cylinder5Ritem->World.Store(XMMatrixScaling(1.0f, 2.0f, 1.0f)*XMMatrixTranslation(-6.0f, 1.0f, -5.0f));
 	cylinder5Ritem->ObjCBIndex = j;
 	cylinder5Ritem->Geo = mGeometries["shapeGeo"].get();
 	cylinder5Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	cylinder5Ritem->DrawArg = "cylinder5";
 	cylinder5Ritem->IndexCount = cylinder5Ritem->Geo->DrawArgs["cylinder5"].IndexCount;
 	cylinder5Ritem->StartIndexLocation = cylinder5Ritem->Geo->DrawArgs["cylinder5"].StartIndexLocation;
 	cylinder5Ritem->BaseVertexLocation = cylinder5Ritem->Geo->DrawArgs["cylinder5"].BaseVertexLocation;
@@ -1329,10 +2023,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto wedgeRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&wedgeRitem->World, XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(225))*XMMatrixTranslation(-1.5f, 1.0f, -9.5f));
+	wedgeRitem->World.Store(XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(225))*XMMatrixTranslation(-1.5f, 1.0f, -9.5f));
 	wedgeRitem->ObjCBIndex = j;
 	wedgeRitem->Geo = mGeometries["shapeGeo"].get();
 	wedgeRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	wedgeRitem->DrawArg = "wedge";
 	wedgeRitem->IndexCount = wedgeRitem->Geo->DrawArgs["wedge"].IndexCount;
 	wedgeRitem->StartIndexLocation = wedgeRitem->Geo->DrawArgs["wedge"].StartIndexLocation;
 	wedgeRitem->BaseVertexLocation = wedgeRitem->Geo->DrawArgs["wedge"].BaseVertexLocation;
@@ -1340,10 +2035,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto wedge2Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&wedge2Ritem->World, XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(-4.5f, 1.0f, -6.5f));
+	wedge2Ritem->World.Store(XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(45))*XMMatrixTranslation(-4.5f, 1.0f, -6.5f));
 	wedge2Ritem->ObjCBIndex = j;
 	wedge2Ritem->Geo = mGeometries["shapeGeo"].get();
 	wedge2Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	wedge2Ritem->DrawArg = "wedge2";
 	wedge2Ritem->IndexCount = wedge2Ritem->Geo->DrawArgs["wedge2"].IndexCount;
 	wedge2Ritem->StartIndexLocation = wedge2Ritem->Geo->DrawArgs["wedge2"].StartIndexLocation;
 	wedge2Ritem->BaseVertexLocation = wedge2Ritem->Geo->DrawArgs["wedge2"].BaseVertexLocation;
@@ -1351,10 +2047,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto wedge3Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&wedge3Ritem->World, XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(135))*XMMatrixTranslation(4.5f, 1.0f, -6.5f));
+	wedge3Ritem->World.Store(XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(135))*XMMatrixTranslation(4.5f, 1.0f, -6.5f));
 	wedge3Ritem->ObjCBIndex = j;
 	wedge3Ritem->Geo = mGeometries["shapeGeo"].get();
 	wedge3Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	wedge3Ritem->DrawArg = "wedge3";
 	wedge3Ritem->IndexCount = wedge3Ritem->Geo->DrawArgs["wedge3"].IndexCount;
 	wedge3Ritem->StartIndexLocation = wedge3Ritem->Geo->DrawArgs["wedge3"].StartIndexLocation;
 	wedge3Ritem->BaseVertexLocation = wedge3Ritem->Geo->DrawArgs["wedge3"].BaseVertexLocation;
@@ -1362,10 +2059,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto wedge4Ritem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&wedge4Ritem->World, XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(315))*XMMatrixTranslation(1.5f, 1.0f, -9.5f));
+	wedge4Ritem->World.Store(XMMatrixScaling(3.0f, 2.0f, 1.0f)*XMMatrixRotationY(deg2rad(315))*XMMatrixTranslation(1.5f, 1.0f, -9.5f));
 	wedge4Ritem->ObjCBIndex = j;
 	wedge4Ritem->Geo = mGeometries["shapeGeo"].get();
 	wedge4Ritem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	wedge4Ritem->DrawArg = "wedge4";
 	wedge4Ritem->IndexCount = wedge4Ritem->Geo->DrawArgs["wedge4"].IndexCount;
 	wedge4Ritem->StartIndexLocation = wedge4Ritem->Geo->DrawArgs["wedge4"].StartIndexLocation;
 	wedge4Ritem->BaseVertexLocation = wedge4Ritem->Geo->DrawArgs["wedge4"].BaseVertexLocation;
@@ -1373,10 +2071,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 
 	auto geosphereRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&geosphereRitem->World, XMMatrixScaling(3.0f, 3.0f, 3.0f)*XMMatrixTranslation(-10.0f, 1.0f, 9.0f));
+	geosphereRitem->World.Store(XMMatrixScaling(3.0f, 3.0f, 3.0f)*XMMatrixTranslation(-10.0f, 1.0f, 9.0f));
 	geosphereRitem->ObjCBIndex = j;
 	geosphereRitem->Geo = mGeometries["shapeGeo"].get();
 	geosphereRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	geosphereRitem->DrawArg = "geosphere";
 	geosphereRitem->IndexCount = geosphereRitem->Geo->DrawArgs["geosphere"].IndexCount;
 	geosphereRitem->StartIndexLocation = geosphereRitem->Geo->DrawArgs["geosphere"].StartIndexLocation;
 	geosphereRitem->BaseVertexLocation = geosphereRitem->Geo->DrawArgs["geosphere"].BaseVertexLocation;
@@ -1386,10 +2085,11 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 /*	
 
 	auto quadRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&quadRitem->World, XMMatrixScaling(1.0f, 0.0f, 1.0f)*XMMatrixTranslation(0.0f, 0.5f, -2.0f));
+	quadRitem->World.Store(XMMatrixScaling(1.0f, 0.0f, 1.0f)*XMMatrixTranslation(0.0f, 0.5f, -2.0f));
 	quadRitem->ObjCBIndex = j;
 	quadRitem->Geo = mGeometries["shapeGeo"].get();
 	quadRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	quadRitem->DrawArg = "quad";
 	quadRitem->IndexCount = gridRitem->Geo->DrawArgs["quad"].IndexCount;
 	quadRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["quad"].StartIndexLocation;
 	quadRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["quad"].BaseVertexLocation;
@@ -1397,6 +2097,15 @@ void ShapesApp::BuildRenderItems()//////////////////////////////////////////////
 	j++;
 	*/
 
+	auto terrainRitem = std::make_unique<RenderItem>();
+	terrainRitem->World.Store(XMMatrixTranslation(0.0f, -0.01f, 0.0f));
+	terrainRitem->ObjCBIndex = j;
+	terrainRitem->Geo = mGeometries["shapeGeo"].get();
+	terrainRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	terrainRitem->DrawArg = "terrain";
+	mAllRitems.push_back(std::move(terrainRitem));
+	j++;
+
 for (int i = 1; i < 1; i++)
 {
 	//auto barItem = std::make_unique<RenderItem>();
@@ -1409,10 +2118,11 @@ for (int i = 1; i < 1; i++)
 		{
 
 			auto boxRitem = std::make_unique<RenderItem>();
-			XMStoreFloat4x4(&boxRitem->World, XMMatrixScaling(1.0f, 0.1f, 0.5f)*XMMatrixTranslation(q - 0.5f, i + 0.1f, -1.0f + k * 0.5f));
+			boxRitem->World.Store(XMMatrixScaling(1.0f, 0.1f, 0.5f)*XMMatrixTranslation(q - 0.5f, i + 0.1f, -1.0f + k * 0.5f));
 			boxRitem->ObjCBIndex = j;
 			boxRitem->Geo = mGeometries["shapeGeo"].get();
 			boxRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+			boxRitem->DrawArg = "box";
 			boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 			boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 			boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
@@ -1423,10 +2133,11 @@ for (int i = 1; i < 1; i++)
 	}*/
 	//bottom solid piece
 	auto barRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&barRitem->World, XMMatrixScaling(1.0f, 1.0f, 1.0f));
+	barRitem->World.Store(XMMatrixScaling(1.0f, 1.0f, 1.0f));
 	barRitem->ObjCBIndex = j;
 	barRitem->Geo = mGeometries["shapeGeo"].get();
 	barRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	barRitem->DrawArg = "bar";
 	barRitem->IndexCount = barRitem->Geo->DrawArgs["bar"].IndexCount;
 	barRitem->StartIndexLocation = barRitem->Geo->DrawArgs["bar"].StartIndexLocation;
 	barRitem->BaseVertexLocation = barRitem->Geo->DrawArgs["bar"].BaseVertexLocation;
@@ -1445,18 +2156,20 @@ UINT objCBIndex = j;
 		XMMATRIX topDiamWorld = XMMatrixTranslation(0.0f + (2*c), 0.225f, 0.0f);
 		XMMATRIX botDiamWorld = XMMatrixRotationZ(deg2rad(180))*XMMatrixTranslation(0.0f + (2*c), -0.375f, 0.0f);
 
-		XMStoreFloat4x4(&topDiamitem->World, botDiamWorld);
+		topDiamitem->World.Store(botDiamWorld);
 		topDiamitem->ObjCBIndex = objCBIndex++;
 		topDiamitem->Geo = mGeometries["shapeGeo"].get();
 		topDiamitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		topDiamitem->DrawArg = "hexagon";
 		topDiamitem->IndexCount = topDiamitem->Geo->DrawArgs["hexagon"].IndexCount;
 		topDiamitem->StartIndexLocation = topDiamitem->Geo->DrawArgs["hexagon"].StartIndexLocation;
 		topDiamitem->BaseVertexLocation = topDiamitem->Geo->DrawArgs["hexagon"].BaseVertexLocation;
 
-		XMStoreFloat4x4(&botDiamitem->World, topDiamWorld);
+		botDiamitem->World.Store(topDiamWorld);
 		botDiamitem->ObjCBIndex = objCBIndex++;
 		botDiamitem->Geo = mGeometries["shapeGeo"].get();
 		botDiamitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		botDiamitem->DrawArg = "hexagon";
 		botDiamitem->IndexCount = botDiamitem->Geo->DrawArgs["hexagon"].IndexCount;
 		botDiamitem->StartIndexLocation = botDiamitem->Geo->DrawArgs["hexagon"].StartIndexLocation;
 		botDiamitem->BaseVertexLocation = botDiamitem->Geo->DrawArgs["hexagon"].BaseVertexLocation;
@@ -1471,30 +2184,226 @@ UINT objCBIndex = j;
 	// All the render items are opaque.
 	for(auto& e : mAllRitems)
 		mOpaqueRitems.push_back(e.get());
+
+	// Number the geometries for the draw sort keys.
+	std::unordered_map<const MeshGeometry*, UINT> geoSortIds;
+	for(const auto& geo : mGeometries)
+		geoSortIds.insert(std::make_pair(geo.second.get(), (UINT)geoSortIds.size()));
+	for(auto& e : mAllRitems)
+		e->GeoSortId = geoSortIds[e->Geo];
+
+	// Look up the submesh each item was created to draw to pick up its bounds and color.
+	// Items that draw the full detail level of a LOD chain switch levels with distance,
+	// and items that draw a split submesh are drawn a meshlet at a time.  Items that
+	// draw a paged mesh take their draw arguments from its pages.
+	for(auto& e : mAllRitems)
+	{
+		e->Color = mDrawArgColors.at(e->DrawArg);
+
+		auto pageCount = mDrawArgPageCounts.find(e->DrawArg);
+		if(pageCount != mDrawArgPageCounts.end())
+		{
+			e->Pages.clear();
+			for(UINT i = 0; i < pageCount->second; ++i)
+				e->Pages.push_back(e->Geo->DrawArgs.at(e->DrawArg + "_page" + std::to_string(i)));
+
+			e->IndexCount = e->Pages[0].IndexCount;
+			e->StartIndexLocation = e->Pages[0].StartIndexLocation;
+			e->BaseVertexLocation = e->Pages[0].BaseVertexLocation;
+
+			e->Bounds = e->Pages[0].Bounds;
+			for(const SubmeshGeometry& page : e->Pages)
+				BoundingBox::CreateMerged(e->Bounds, e->Bounds, page.Bounds);
+		}
+		else
+		{
+			auto submesh = e->Geo->DrawArgs.find(e->DrawArg);
+			assert(submesh != e->Geo->DrawArgs.end());
+
+			e->Bounds = submesh->second.Bounds;
+		}
+
+		auto lods = mLodChains.find(e->DrawArg);
+		if(lods != mLodChains.end())
+			e->Lods = &lods->second;
+
+		auto meshlets = mMeshlets.find(e->DrawArg);
+		if(meshlets != mMeshlets.end())
+			e->Meshlets = &meshlets->second;
+
+		e->IsOccluder = std::find_if(std::begin(gOccluderDrawArgs), std::end(gOccluderDrawArgs),
+			[&](const char* name) { return e->DrawArg == name; }) != std::end(gOccluderDrawArgs);
+	}
+
+	// World bounds of the items where they start.  MarkObjectDirty updates them and
+	// the culler's boxes when an item moves, and the BVH is refit from them.
+	mWorldBounds.resize(mOpaqueRitems.size());
+	mFrustumCuller.Resize(mOpaqueRitems.size());
+	for(size_t i = 0; i < mOpaqueRitems.size(); ++i)
+	{
+		mOpaqueRitems[i]->CullIndex = (UINT)i;
+		mOpaqueRitems[i]->Bounds.Transform(mWorldBounds[i], mOpaqueRitems[i]->World.Load());
+		mFrustumCuller.SetBox(i, mWorldBounds[i]);
+	}
+
+	mSceneBvh.Build(mWorldBounds);
+
+	mOcclusionCuller.Resize(gOcclusionBufferWidth, gOcclusionBufferHeight);
+
+	std::ostringstream ss;
+	ss << "Scene BVH: " << mSceneBvh.GetItemCount() << " items, " << mSceneBvh.GetNodeCount()
+	   << " nodes, built in " << mSceneBvh.GetBuildMs() << " ms\n";
+	::OutputDebugStringA(ss.str().c_str());
 }
 
-void ShapesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
+void ShapesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<DrawItem>& drawItems)
 {
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
- 
-	auto objectCB = mCurrFrameResource->ObjectCB->Resource();
+	//
+	// Sort the items so the ones sharing state are drawn together, nearest first
+	// within a run to help early depth rejection.
+	//
 
-    // For each render item...
-    for(size_t i = 0; i < ritems.size(); ++i)
-    {
-        auto ri = ritems[i];
+	auto sortStart = std::chrono::high_resolution_clock::now();
+
+	const UINT pso = mIsWireframe ? 1 : 0;
+
+	mRenderQueue.Clear();
+	for(size_t i = 0; i < drawItems.size(); ++i)
+	{
+		const DrawItem& drawItem = drawItems[i];
+		const RenderItem* ri = drawItem.Item;
+
+		UINT drawPso = pso;
+		if(mUseObjectBuffer)
+			drawPso += gObjectBufferPsoOffset;
+		else if(drawItem.InstanceCount > 0)
+			drawPso += gInstancedPsoOffset;
+
+		mRenderQueue.Push(RenderQueue::MakeKey(drawPso, ri->GeoSortId, (UINT)ri->PrimitiveType, drawItem.Depth), (UINT)i);
+	}
+	mRenderQueue.Sort();
+
+	auto sortEnd = std::chrono::high_resolution_clock::now();
+	mFrameStats.SortMs = std::chrono::duration<double, std::milli>(sortEnd - sortStart).count();
+	mFrameStats.DrawPackets = (UINT)drawItems.size();
+
+	// State bound by earlier packets; only changes are sent.  The PSO was set when
+	// the command list was reset.
+	UINT boundPso = pso;
+	const MeshGeometry* boundGeo = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY boundTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	// The instance stream stays in slot 1 for the whole frame.
+	if(mInstanceBufferView.SizeInBytes > 0)
+		cmdList->IASetVertexBuffers(1, 1, &mInstanceBufferView);
 
-        cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-        cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
-        cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+	for(const DrawPacket& packet : mRenderQueue.GetPackets())
+	{
+		const DrawItem& drawItem = drawItems[packet.Item];
+		auto ri = drawItem.Item;
+
+		UINT packetPso = RenderQueue::GetPso(packet.Key);
+		if(packetPso != boundPso)
+		{
+			cmdList->SetPipelineState(mPSOs[gPsoNames[packetPso]].Get());
+			boundPso = packetPso;
+			mFrameStats.PsoBinds++;
+		}
 
-        // Offset to the CBV in the descriptor heap for this object and for this frame resource.
-        UINT cbvIndex = mCurrFrameResourceIndex*(UINT)mOpaqueRitems.size() + ri->ObjCBIndex;
-        auto cbvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(mCbvHeap->GetGPUDescriptorHandleForHeapStart());
-        cbvHandle.Offset(cbvIndex, mCbvSrvUavDescriptorSize);
+		if(ri->Geo != boundGeo)
+		{
+			cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
+			cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
+			boundGeo = ri->Geo;
+			mFrameStats.GeometryBinds++;
+		}
 
-        cmdList->SetGraphicsRootDescriptorTable(0, cbvHandle);
+		if(ri->PrimitiveType != boundTopology)
+		{
+			cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+			boundTopology = ri->PrimitiveType;
+			mFrameStats.TopologyBinds++;
+		}
 
-        cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		// A paged item is drawn one page at a time with the same instances.
+		auto drawIndexed = [&](UINT instanceCount, UINT startInstance)
+		{
+			if(ri->Pages.empty())
+			{
+				cmdList->DrawIndexedInstanced(ri->IndexCount, instanceCount, ri->StartIndexLocation,
+					ri->BaseVertexLocation, startInstance);
+				mFrameStats.Draws++;
+			}
+
+			for(const SubmeshGeometry& page : ri->Pages)
+			{
+				cmdList->DrawIndexedInstanced(page.IndexCount, instanceCount, page.StartIndexLocation,
+					page.BaseVertexLocation, startInstance);
+				mFrameStats.Draws++;
+			}
+		};
+
+		if(drawItem.InstanceCount > 0)
+		{
+			drawIndexed(drawItem.InstanceCount, drawItem.InstanceStart);
+			continue;
+		}
+
+		// A single item reads either its own constants or its one entry of the
+		// instance stream.
+		UINT startInstance = 0;
+		if(mUseObjectBuffer)
+			startInstance = drawItem.InstanceStart;
+		else
+			cmdList->SetGraphicsRootConstantBufferView(0, drawItem.ObjectCBAddress);
+
+		if(ri->Meshlets == nullptr || ri->LodIndex != 0)
+		{
+			drawIndexed(1, startInstance);
+			continue;
+		}
+
+		// Skip the meshlets that face away from the eye.  The test is done in object
+		// space, and runs of visible meshlets that are adjacent in the index buffer
+		// are merged into one draw.
+		XMMATRIX world = ri->World.Load();
+		XMVECTOR eyePos = XMVector3TransformCoord(XMLoadFloat3(&mEyePos), XMMatrixInverse(nullptr, world));
+
+		UINT runStart = 0;
+		UINT runCount = 0;
+		for(const Meshlet& meshlet : *ri->Meshlets)
+		{
+			if(MeshletBuilder::IsBackfacing(meshlet, eyePos))
+			{
+				mFrameStats.MeshletsCulled++;
+				continue;
+			}
+
+			mFrameStats.MeshletsDrawn++;
+
+			if(runCount > 0 && runStart + runCount == meshlet.StartIndex)
+			{
+				runCount += meshlet.IndexCount;
+				continue;
+			}
+
+			if(runCount > 0)
+			{
+				cmdList->DrawIndexedInstanced(runCount, 1, ri->StartIndexLocation + runStart, ri->BaseVertexLocation, startInstance);
+				mFrameStats.Draws++;
+			}
+
+			runStart = meshlet.StartIndex;
+			runCount = meshlet.IndexCount;
+		}
+
+		if(runCount > 0)
+		{
+			cmdList->DrawIndexedInstanced(runCount, 1, ri->StartIndexLocation + runStart, ri->BaseVertexLocation, startInstance);
+			mFrameStats.Draws++;
+		}
     }
+
+	auto submitEnd = std::chrono::high_resolution_clock::now();
+	mFrameStats.SubmitMs = std::chrono::duration<double, std::milli>(submitEnd - sortEnd).count();
 }
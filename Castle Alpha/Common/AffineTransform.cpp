@@ -0,0 +1,21 @@
+//***************************************************************************************
+// AffineTransform.cpp
+//***************************************************************************************
+
+#include "AffineTransform.h"
+
+using namespace DirectX;
+
+XMMATRIX AffineTransform::Load()const
+{
+	XMMATRIX m(XMLoadFloat4(&Rows[0]), XMLoadFloat4(&Rows[1]), XMLoadFloat4(&Rows[2]), g_XMIdentityR3);
+	return XMMatrixTranspose(m);
+}
+
+void AffineTransform::Store(FXMMATRIX m)
+{
+	XMMATRIX t = XMMatrixTranspose(m);
+	XMStoreFloat4(&Rows[0], t.r[0]);
+	XMStoreFloat4(&Rows[1], t.r[1]);
+	XMStoreFloat4(&Rows[2], t.r[2]);
+}
@@ -0,0 +1,37 @@
+//***************************************************************************************
+// AffineTransform.h
+//
+// World transforms in 3x4 form.  The last column of an affine row vector matrix is
+// always (0, 0, 0, 1), so only the first three columns are kept, each stored as a row:
+// coordinate i of a transformed point is Rows[i] dotted with (x, y, z, 1).  That is 48
+// bytes instead of 64, and the layout HLSL reads as a row_major float3x4.
+//
+// Render items hold their world transform in this form from the moment it is set, so
+// the per frame uploads copy it as-is and there is no 4x4 to 3x4 batch pack on that
+// path.  Store transposes once, when a transform changes.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+
+struct AffineTransform
+{
+	DirectX::XMFLOAT4 Rows[3] =
+	{
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f }
+	};
+
+	///<summary>
+	/// Returns the transform as a row vector matrix for DirectXMath.
+	///</summary>
+	DirectX::XMMATRIX Load()const;
+
+	///<summary>
+	/// Stores the first three columns of m, which must be affine.
+	///</summary>
+	void Store(DirectX::FXMMATRIX m);
+};
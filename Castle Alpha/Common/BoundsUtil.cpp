@@ -0,0 +1,113 @@
+//***************************************************************************************
+// BoundsUtil.cpp
+//***************************************************************************************
+
+#include "BoundsUtil.h"
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	inline XMVECTOR LoadPoint(const std::uint8_t* base, size_t i, size_t stride)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(base + i*stride));
+	}
+}
+
+void BoundsUtil::ComputeBounds(const XMFLOAT3* points, size_t count, size_t stride,
+	BoundingBox& box, BoundingSphere& sphere)
+{
+	if(count == 0)
+	{
+		box.Center = box.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		sphere.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		sphere.Radius = 0.0f;
+		return;
+	}
+
+	const std::uint8_t* base = reinterpret_cast<const std::uint8_t*>(points);
+
+	//
+	// Box: four points per iteration into four independent min/max accumulators, so
+	// consecutive iterations do not wait on each other.
+	//
+
+	XMVECTOR min0 = LoadPoint(base, 0, stride);
+	XMVECTOR max0 = min0;
+	XMVECTOR min1 = min0, max1 = min0;
+	XMVECTOR min2 = min0, max2 = min0;
+	XMVECTOR min3 = min0, max3 = min0;
+
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		XMVECTOR p0 = LoadPoint(base, i + 0, stride);
+		XMVECTOR p1 = LoadPoint(base, i + 1, stride);
+		XMVECTOR p2 = LoadPoint(base, i + 2, stride);
+		XMVECTOR p3 = LoadPoint(base, i + 3, stride);
+
+		min0 = XMVectorMin(min0, p0); max0 = XMVectorMax(max0, p0);
+		min1 = XMVectorMin(min1, p1); max1 = XMVectorMax(max1, p1);
+		min2 = XMVectorMin(min2, p2); max2 = XMVectorMax(max2, p2);
+		min3 = XMVectorMin(min3, p3); max3 = XMVectorMax(max3, p3);
+	}
+
+	for(; i < count; ++i)
+	{
+		XMVECTOR p = LoadPoint(base, i, stride);
+		min0 = XMVectorMin(min0, p);
+		max0 = XMVectorMax(max0, p);
+	}
+
+	XMVECTOR vMin = XMVectorMin(XMVectorMin(min0, min1), XMVectorMin(min2, min3));
+	XMVECTOR vMax = XMVectorMax(XMVectorMax(max0, max1), XMVectorMax(max2, max3));
+
+	XMVECTOR center = 0.5f*(vMin + vMax);
+	XMStoreFloat3(&box.Center, center);
+	XMStoreFloat3(&box.Extents, 0.5f*(vMax - vMin));
+
+	//
+	// Sphere radius: transpose four points into x, y and z registers and take the
+	// squared distance of all four at once.
+	//
+
+	XMVECTOR cx = XMVectorSplatX(center);
+	XMVECTOR cy = XMVectorSplatY(center);
+	XMVECTOR cz = XMVectorSplatZ(center);
+	XMVECTOR maxDistSq = XMVectorZero();
+
+	for(i = 0; i + 4 <= count; i += 4)
+	{
+		XMVECTOR p0 = LoadPoint(base, i + 0, stride);
+		XMVECTOR p1 = LoadPoint(base, i + 1, stride);
+		XMVECTOR p2 = LoadPoint(base, i + 2, stride);
+		XMVECTOR p3 = LoadPoint(base, i + 3, stride);
+
+		XMVECTOR t0 = XMVectorMergeXY(p0, p2); // x0 x2 y0 y2
+		XMVECTOR t1 = XMVectorMergeXY(p1, p3); // x1 x3 y1 y3
+		XMVECTOR t2 = XMVectorMergeZW(p0, p2); // z0 z2 -  -
+		XMVECTOR t3 = XMVectorMergeZW(p1, p3); // z1 z3 -  -
+
+		XMVECTOR dx = XMVectorMergeXY(t0, t1) - cx;
+		XMVECTOR dy = XMVectorMergeZW(t0, t1) - cy;
+		XMVECTOR dz = XMVectorMergeXY(t2, t3) - cz;
+
+		XMVECTOR distSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, dz*dz));
+		maxDistSq = XMVectorMax(maxDistSq, distSq);
+	}
+
+	for(; i < count; ++i)
+	{
+		XMVECTOR distSq = XMVector3LengthSq(LoadPoint(base, i, stride) - center);
+		maxDistSq = XMVectorMax(maxDistSq, XMVectorSplatX(distSq));
+	}
+
+	float radiusSq = XMVectorGetX(maxDistSq);
+	radiusSq = XMMax(radiusSq, XMVectorGetY(maxDistSq));
+	radiusSq = XMMax(radiusSq, XMVectorGetZ(maxDistSq));
+	radiusSq = XMMax(radiusSq, XMVectorGetW(maxDistSq));
+
+	sphere.Center = box.Center;
+	sphere.Radius = sqrtf(radiusSq);
+}
@@ -0,0 +1,40 @@
+//***************************************************************************************
+// BoundsUtil.h
+//
+// Vectorized bounding volume construction for packed vertex data, and the small SIMD
+// helpers shared by the culling code.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+
+class BoundsUtil
+{
+public:
+	///<summary>
+	/// Computes the axis aligned box and a bounding sphere of count points spaced
+	/// stride bytes apart, so positions can be read straight out of an interleaved
+	/// vertex buffer.  The sphere is centred on the box, which is within a factor of
+	/// sqrt(3) of the smallest sphere but needs only one more pass over the points.
+	///</summary>
+	static void ComputeBounds(const DirectX::XMFLOAT3* points, size_t count, size_t stride,
+		DirectX::BoundingBox& box, DirectX::BoundingSphere& sphere);
+
+	///<summary>
+	/// Bit i is set if lane i of the comparison result v is true.
+	///</summary>
+	static std::uint32_t LaneMask(DirectX::FXMVECTOR v)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		return (std::uint32_t)_mm_movemask_ps(v);
+#else
+		std::uint32_t lanes[4];
+		DirectX::XMStoreInt4(lanes, v);
+		return (lanes[0] >> 31) | ((lanes[1] >> 31) << 1) | ((lanes[2] >> 31) << 2) | ((lanes[3] >> 31) << 3);
+#endif
+	}
+};
@@ -0,0 +1,198 @@
+//***************************************************************************************
+// FrustumCuller.cpp
+//***************************************************************************************
+
+#include "FrustumCuller.h"
+#include "BoundsUtil.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = FrustumCuller::uint32;
+
+	// The SoA arrays are padded so the 8 wide loop never needs a scalar tail.
+	const size_t kBatchSize = 8;
+
+	// A plane splatted across all lanes, with the absolute values of its normal used
+	// for the box's projected radius.
+	struct SplatPlane
+	{
+		XMVECTOR Nx, Ny, Nz, D;
+		XMVECTOR AbsNx, AbsNy, AbsNz;
+	};
+
+	inline void EmitVisible(uint32 visibleMask, size_t first, size_t count, std::vector<uint32>& visible)
+	{
+		for(uint32 lane = 0; visibleMask != 0; ++lane, visibleMask >>= 1)
+		{
+			if((visibleMask & 1) && first + lane < count)
+				visible.push_back((uint32)(first + lane));
+		}
+	}
+}
+
+void FrustumCuller::ExtractPlanes(FXMMATRIX viewProj, XMFLOAT4 planes[6])
+{
+	// With clip = v*M, each plane is a sum or difference of the matrix's columns.
+	XMMATRIX m = XMMatrixTranspose(viewProj);
+
+	XMVECTOR p[6];
+	p[0] = m.r[3] + m.r[0]; // left
+	p[1] = m.r[3] - m.r[0]; // right
+	p[2] = m.r[3] + m.r[1]; // bottom
+	p[3] = m.r[3] - m.r[1]; // top
+	p[4] = m.r[2];          // near
+	p[5] = m.r[3] - m.r[2]; // far
+
+	for(int i = 0; i < 6; ++i)
+		XMStoreFloat4(&planes[i], XMPlaneNormalize(p[i]));
+}
+
+size_t FrustumCuller::GetCount()const
+{
+	return mCount;
+}
+
+void FrustumCuller::Resize(size_t count)
+{
+	mCount = count;
+
+	size_t padded = (count + kBatchSize - 1) / kBatchSize * kBatchSize;
+	mCenterX.assign(padded, 0.0f);
+	mCenterY.assign(padded, 0.0f);
+	mCenterZ.assign(padded, 0.0f);
+	mExtentX.assign(padded, 0.0f);
+	mExtentY.assign(padded, 0.0f);
+	mExtentZ.assign(padded, 0.0f);
+}
+
+void FrustumCuller::SetBox(size_t index, const BoundingBox& worldBox)
+{
+	mCenterX[index] = worldBox.Center.x;
+	mCenterY[index] = worldBox.Center.y;
+	mCenterZ[index] = worldBox.Center.z;
+	mExtentX[index] = worldBox.Extents.x;
+	mExtentY[index] = worldBox.Extents.y;
+	mExtentZ[index] = worldBox.Extents.z;
+}
+
+size_t FrustumCuller::Cull(FXMMATRIX viewProj, std::vector<uint32>& visible)const
+{
+	visible.clear();
+
+	XMFLOAT4 planes[6];
+	ExtractPlanes(viewProj, planes);
+
+	// A box is outside if it is entirely behind any plane: the signed distance of its
+	// centre plus its radius projected on the plane normal is negative.
+	size_t i = 0;
+
+#if defined(__AVX__)
+	__m256 nx[6], ny[6], nz[6], d[6], absNx[6], absNy[6], absNz[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm256_set1_ps(planes[p].x);
+		ny[p] = _mm256_set1_ps(planes[p].y);
+		nz[p] = _mm256_set1_ps(planes[p].z);
+		d[p] = _mm256_set1_ps(planes[p].w);
+		absNx[p] = _mm256_set1_ps(fabsf(planes[p].x));
+		absNy[p] = _mm256_set1_ps(fabsf(planes[p].y));
+		absNz[p] = _mm256_set1_ps(fabsf(planes[p].z));
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	for(; i < mCount; i += 8)
+	{
+		__m256 cx = _mm256_loadu_ps(&mCenterX[i]);
+		__m256 cy = _mm256_loadu_ps(&mCenterY[i]);
+		__m256 cz = _mm256_loadu_ps(&mCenterZ[i]);
+		__m256 ex = _mm256_loadu_ps(&mExtentX[i]);
+		__m256 ey = _mm256_loadu_ps(&mExtentY[i]);
+		__m256 ez = _mm256_loadu_ps(&mExtentZ[i]);
+
+		__m256 outside = zero;
+		for(int p = 0; p < 6; ++p)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)),
+				_mm256_add_ps(_mm256_mul_ps(nz[p], cz), d[p]));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absNx[p], ex), _mm256_mul_ps(absNy[p], ey)),
+				_mm256_mul_ps(absNz[p], ez));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_LT_OQ));
+		}
+
+		EmitVisible(~(uint32)_mm256_movemask_ps(outside) & 0xff, i, mCount, visible);
+	}
+#else
+	SplatPlane splat[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		XMVECTOR plane = XMLoadFloat4(&planes[p]);
+		XMVECTOR absPlane = XMVectorAbs(plane);
+
+		splat[p].Nx = XMVectorSplatX(plane);
+		splat[p].Ny = XMVectorSplatY(plane);
+		splat[p].Nz = XMVectorSplatZ(plane);
+		splat[p].D = XMVectorSplatW(plane);
+		splat[p].AbsNx = XMVectorSplatX(absPlane);
+		splat[p].AbsNy = XMVectorSplatY(absPlane);
+		splat[p].AbsNz = XMVectorSplatZ(absPlane);
+	}
+
+	const XMVECTOR zero = XMVectorZero();
+	for(; i < mCount; i += 4)
+	{
+		XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterX[i]));
+		XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterY[i]));
+		XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mCenterZ[i]));
+		XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentX[i]));
+		XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentY[i]));
+		XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&mExtentZ[i]));
+
+		XMVECTOR outside = XMVectorFalseInt();
+		for(int p = 0; p < 6; ++p)
+		{
+			const SplatPlane& s = splat[p];
+
+			XMVECTOR dist = XMVectorMultiplyAdd(s.Nx, cx, XMVectorMultiplyAdd(s.Ny, cy, XMVectorMultiplyAdd(s.Nz, cz, s.D)));
+			XMVECTOR radius = XMVectorMultiplyAdd(s.AbsNx, ex, XMVectorMultiplyAdd(s.AbsNy, ey, s.AbsNz*ez));
+
+			outside = XMVectorOrInt(outside, XMVectorLess(dist + radius, zero));
+		}
+
+		EmitVisible(~BoundsUtil::LaneMask(outside) & 0xf, i, mCount, visible);
+	}
+#endif
+
+	return visible.size();
+}
+
+size_t FrustumCuller::CullScalar(FXMMATRIX viewProj, std::vector<uint32>& visible)const
+{
+	visible.clear();
+
+	XMFLOAT4 planes[6];
+	ExtractPlanes(viewProj, planes);
+
+	for(size_t i = 0; i < mCount; ++i)
+	{
+		bool outside = false;
+		for(int p = 0; p < 6 && !outside; ++p)
+		{
+			float dist = planes[p].x*mCenterX[i] + planes[p].y*mCenterY[i] + planes[p].z*mCenterZ[i] + planes[p].w;
+			float radius = fabsf(planes[p].x)*mExtentX[i] + fabsf(planes[p].y)*mExtentY[i] + fabsf(planes[p].z)*mExtentZ[i];
+			outside = dist + radius < 0.0f;
+		}
+
+		if(!outside)
+			visible.push_back((uint32)i);
+	}
+
+	return visible.size();
+}
@@ -0,0 +1,56 @@
+//***************************************************************************************
+// FrustumCuller.h
+//
+// Batch frustum culling of world space boxes.  The boxes are kept in structure of
+// arrays form so four (SSE) or eight (AVX) of them are tested per iteration against
+// the six planes of the view frustum.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class FrustumCuller
+{
+public:
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Extracts the left, right, bottom, top, near and far planes from a row vector
+	/// view-projection matrix with a [0, 1] depth range.  The planes are normalized and
+	/// point into the frustum.
+	///</summary>
+	static void ExtractPlanes(DirectX::FXMMATRIX viewProj, DirectX::XMFLOAT4 planes[6]);
+
+	// Number of boxes; slots past it are padding.
+	size_t GetCount()const;
+
+	void Resize(size_t count);
+	void SetBox(size_t index, const DirectX::BoundingBox& worldBox);
+
+	///<summary>
+	/// Writes the indices of the boxes that intersect or are inside the frustum of
+	/// viewProj to visible, in increasing order, and returns how many there are.
+	///</summary>
+	size_t Cull(DirectX::FXMMATRIX viewProj, std::vector<uint32>& visible)const;
+
+	///<summary>
+	/// Same result as Cull, one box at a time.  Kept as the reference for benchmarks.
+	///</summary>
+	size_t CullScalar(DirectX::FXMMATRIX viewProj, std::vector<uint32>& visible)const;
+
+private:
+	size_t mCount = 0;
+
+	// Box centres and half extents, padded to a multiple of 8 entries.
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mExtentX;
+	std::vector<float> mExtentY;
+	std::vector<float> mExtentZ;
+};
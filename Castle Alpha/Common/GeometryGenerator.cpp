@@ -3,10 +3,532 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "GeometryTables.h"
 #include <algorithm>
+#include <iterator>
 
 using namespace DirectX;
 
+namespace
+{
+	using uint32 = GeometryGenerator::uint32;
+	using Vertex = GeometryGenerator::Vertex;
+	using MeshData = GeometryGenerator::MeshData;
+
+	inline XMVECTOR Load4(const float* values)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(values));
+	}
+
+	inline void Store4(float* values, FXMVECTOR v)
+	{
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(values), v);
+	}
+
+	// Sines and cosines of i*step for i = 0..count, evaluated four angles per
+	// XMVectorSinCos.  The tables are padded to a multiple of four so the ring
+	// kernels can always load whole vectors.
+	struct SinCosTable
+	{
+		SinCosTable(uint32 count, float step)
+		{
+			const uint32 paddedCount = (count + 4) & ~3u;
+			Sin.resize(paddedCount);
+			Cos.resize(paddedCount);
+
+			const XMVECTOR lanes = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+			for(uint32 i = 0; i < paddedCount; i += 4)
+			{
+				XMVECTOR s, c;
+				XMVectorSinCos(&s, &c, (XMVectorReplicate((float)i) + lanes)*step);
+				Store4(&Sin[i], s);
+				Store4(&Cos[i], c);
+			}
+		}
+
+		std::vector<float> Sin;
+		std::vector<float> Cos;
+	};
+
+	// A closed cross-section in structure-of-arrays form.  Every array has one entry
+	// per ring vertex, with the first point repeated at the end for the texture seam,
+	// and is padded to a multiple of four so the ring kernel can always load whole
+	// vectors.  Points go counterclockwise from +x towards +z.
+	struct SweepSection
+	{
+		explicit SweepSection(uint32 pointCount) :
+			Count(pointCount + 1)
+		{
+			const uint32 paddedCount = (Count + 3) & ~3u;
+			X.resize(paddedCount);
+			Z.resize(paddedCount);
+			NormalX.resize(paddedCount);
+			NormalZ.resize(paddedCount);
+			Support.resize(paddedCount);
+			U.resize(paddedCount);
+		}
+
+		uint32 Count;
+
+		std::vector<float> X;
+		std::vector<float> Z;
+
+		// Outward unit normal in the section plane.
+		std::vector<float> NormalX;
+		std::vector<float> NormalZ;
+
+		// X*NormalX + Z*NormalZ.  Scales how much the normal tilts when the section
+		// grows or shrinks along the sweep; it is one for every point of a unit circle.
+		std::vector<float> Support;
+
+		// Fraction of the perimeter from the first point.
+		std::vector<float> U;
+	};
+
+	SweepSection CircleSection(uint32 sliceCount)
+	{
+		SinCosTable slices(sliceCount, 2.0f*XM_PI/sliceCount);
+
+		SweepSection section(sliceCount);
+		section.X = slices.Cos;
+		section.Z = slices.Sin;
+		section.NormalX = slices.Cos;
+		section.NormalZ = slices.Sin;
+		std::fill(section.Support.begin(), section.Support.end(), 1.0f);
+
+		for(uint32 j = 0; j < section.Count; ++j)
+			section.U[j] = (float)j/sliceCount;
+
+		return section;
+	}
+
+	// Vertex normals are the average of the normals of the two edges that meet at
+	// the point, so a polygon section shades smoothly around its perimeter.
+	SweepSection PolygonSection(const std::vector<XMFLOAT2>& points)
+	{
+		const uint32 pointCount = (uint32)points.size();
+		assert(pointCount >= 3);
+
+		SweepSection section(pointCount);
+
+		float perimeter = 0.0f;
+		for(uint32 j = 0; j < section.Count; ++j)
+		{
+			const XMFLOAT2& prev = points[(j + pointCount - 1) % pointCount];
+			const XMFLOAT2& p = points[j % pointCount];
+			const XMFLOAT2& next = points[(j + 1) % pointCount];
+
+			XMVECTOR toPrev = XMVectorSet(p.y - prev.y, prev.x - p.x, 0.0f, 0.0f);
+			XMVECTOR toNext = XMVectorSet(next.y - p.y, p.x - next.x, 0.0f, 0.0f);
+			XMVECTOR normal = XMVector2Normalize(XMVector2Normalize(toPrev) + XMVector2Normalize(toNext));
+
+			section.X[j] = p.x;
+			section.Z[j] = p.y;
+			section.NormalX[j] = XMVectorGetX(normal);
+			section.NormalZ[j] = XMVectorGetY(normal);
+			section.Support[j] = p.x*section.NormalX[j] + p.y*section.NormalZ[j];
+			section.U[j] = perimeter;
+
+			perimeter += XMVectorGetX(XMVector2Length(toNext));
+		}
+
+		for(uint32 j = 0; j < section.Count; ++j)
+			section.U[j] /= section.U[section.Count - 1];
+
+		return section;
+	}
+
+	// Placement of one ring of a sweep.  The section's x and z axes map to AxisX and
+	// AxisZ, with AxisZ = AxisX x Direction as for x, z and y.  Axial is the ring's
+	// position along the sweep, which with Scale forms the 2D profile the normals
+	// and v coordinates are derived from.
+	struct RingFrame
+	{
+		XMFLOAT3 Origin;
+		XMFLOAT3 AxisX;
+		XMFLOAT3 AxisZ;
+		XMFLOAT3 Direction;
+		float Scale;
+		float Axial;
+	};
+
+	RingFrame LatheFrame(float radius, float y)
+	{
+		return { XMFLOAT3(0.0f, y, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f),
+			XMFLOAT3(0.0f, 1.0f, 0.0f), radius, y };
+	}
+
+	// Writes the section.Count vertices of one ring, four section points at a time.
+	// (normalRadial, normalAxial) is the unit normal of the profile at the ring.
+	void WriteSweptRing(const SweepSection& section, const RingFrame& frame,
+		float normalRadial, float normalAxial, float v, Vertex* ring)
+	{
+		const XMVECTOR ox = XMVectorReplicate(frame.Origin.x);
+		const XMVECTOR oy = XMVectorReplicate(frame.Origin.y);
+		const XMVECTOR oz = XMVectorReplicate(frame.Origin.z);
+		const XMVECTOR ax = XMVectorReplicate(frame.AxisX.x);
+		const XMVECTOR ay = XMVectorReplicate(frame.AxisX.y);
+		const XMVECTOR az = XMVectorReplicate(frame.AxisX.z);
+		const XMVECTOR bx = XMVectorReplicate(frame.AxisZ.x);
+		const XMVECTOR by = XMVectorReplicate(frame.AxisZ.y);
+		const XMVECTOR bz = XMVectorReplicate(frame.AxisZ.z);
+		const XMVECTOR scale = XMVectorReplicate(frame.Scale);
+		const XMVECTOR radial = XMVectorReplicate(normalRadial);
+		const XMVECTOR axialX = XMVectorReplicate(normalAxial*frame.Direction.x);
+		const XMVECTOR axialY = XMVectorReplicate(normalAxial*frame.Direction.y);
+		const XMVECTOR axialZ = XMVectorReplicate(normalAxial*frame.Direction.z);
+
+		float px[4], py[4], pz[4], nx[4], ny[4], nz[4], tx[4], ty[4], tz[4];
+		for(uint32 j = 0; j < section.Count; j += 4)
+		{
+			XMVECTOR sx = scale*Load4(&section.X[j]);
+			XMVECTOR sz = scale*Load4(&section.Z[j]);
+			XMVECTOR mx = Load4(&section.NormalX[j]);
+			XMVECTOR mz = Load4(&section.NormalZ[j]);
+			XMVECTOR h = Load4(&section.Support[j]);
+
+			Store4(px, ox + sx*ax + sz*bx);
+			Store4(py, oy + sx*ay + sz*by);
+			Store4(pz, oz + sx*az + sz*bz);
+
+			// The in-plane normal tilted towards the sweep direction by the profile.
+			XMVECTOR rx = radial*mx;
+			XMVECTOR rz = radial*mz;
+			XMVECTOR wx = rx*ax + rz*bx + h*axialX;
+			XMVECTOR wy = rx*ay + rz*by + h*axialY;
+			XMVECTOR wz = rx*az + rz*bz + h*axialZ;
+			XMVECTOR length = XMVectorSqrt(wx*wx + wy*wy + wz*wz);
+
+			Store4(nx, wx/length);
+			Store4(ny, wy/length);
+			Store4(nz, wz/length);
+
+			// The section tangent, (-NormalZ, NormalX), in the ring's frame.
+			Store4(tx, mx*bx - mz*ax);
+			Store4(ty, mx*by - mz*ay);
+			Store4(tz, mx*bz - mz*az);
+
+			const uint32 laneCount = std::min<uint32>(4, section.Count - j);
+			for(uint32 k = 0; k < laneCount; ++k)
+			{
+				Vertex& vertex = ring[j + k];
+				vertex.Position = XMFLOAT3(px[k], py[k], pz[k]);
+				vertex.Normal = XMFLOAT3(nx[k], ny[k], nz[k]);
+				vertex.TangentU = XMFLOAT3(tx[k], ty[k], tz[k]);
+				vertex.TexC = XMFLOAT2(section.U[j + k], v);
+			}
+		}
+	}
+
+	// Appends a ring of the section for every frame and stitches consecutive rings.
+	// The profile normal at a ring averages its two neighbouring segments, so
+	// repeating a frame makes a crease, and a frame with zero scale closes the
+	// surface like the pole of a sphere.  v runs from one at the first ring to zero
+	// at the last, by distance along the profile.
+	void BuildSweep(const SweepSection& section, const std::vector<RingFrame>& frames, MeshData& meshData)
+	{
+		const uint32 ringCount = (uint32)frames.size();
+		const uint32 ringVertexCount = section.Count;
+		assert(ringCount >= 2);
+
+		std::vector<XMFLOAT2> segmentNormals(ringCount - 1);
+		std::vector<float> distances(ringCount);
+		distances[0] = 0.0f;
+
+		for(uint32 k = 0; k + 1 < ringCount; ++k)
+		{
+			float dr = frames[k+1].Scale - frames[k].Scale;
+			float da = frames[k+1].Axial - frames[k].Axial;
+			float length = sqrtf(dr*dr + da*da);
+
+			segmentNormals[k] = length > 0.0f ? XMFLOAT2(da/length, -dr/length) : XMFLOAT2(0.0f, 0.0f);
+			distances[k+1] = distances[k] + length;
+		}
+
+		const float totalDistance = distances.back();
+		const uint32 baseIndex = (uint32)meshData.Vertices.size();
+		meshData.Vertices.resize(baseIndex + ringCount*ringVertexCount);
+
+		for(uint32 k = 0; k < ringCount; ++k)
+		{
+			XMVECTOR normal = XMVectorZero();
+			if(k > 0)
+				normal += XMLoadFloat2(&segmentNormals[k-1]);
+			if(k + 1 < ringCount)
+				normal += XMLoadFloat2(&segmentNormals[k]);
+
+			// A ring with no segment of any length next to it, like the closing ring of
+			// a repeated end point, or one where the profile turns straight back,
+			// takes the normal of the nearest segment that has one.
+			for(uint32 d = 0; XMVector2Equal(normal, XMVectorZero()) && d + 1 < ringCount; ++d)
+			{
+				if(k > d)
+					normal = XMLoadFloat2(&segmentNormals[k-1-d]);
+				if(XMVector2Equal(normal, XMVectorZero()) && k + d + 1 < ringCount)
+					normal = XMLoadFloat2(&segmentNormals[k+d]);
+			}
+			normal = XMVector2Normalize(normal);
+
+			float v = totalDistance > 0.0f ? 1.0f - distances[k]/totalDistance : 0.0f;
+
+			WriteSweptRing(section, frames[k], XMVectorGetX(normal), XMVectorGetY(normal), v,
+				&meshData.Vertices[baseIndex + k*ringVertexCount]);
+		}
+
+		// Repeated frames get no triangles, and neither do the halves of a quad that
+		// would collapse onto a zero scale ring.
+		const uint32 sliceCount = ringVertexCount - 1;
+
+		size_t triangleCount = 0;
+		for(uint32 k = 0; k + 1 < ringCount; ++k)
+		{
+			if(distances[k+1] > distances[k])
+				triangleCount += sliceCount*((frames[k+1].Scale != 0.0f) + (frames[k].Scale != 0.0f));
+		}
+
+		size_t firstIndex = meshData.Indices32.size();
+		meshData.Indices32.resize(firstIndex + 3*triangleCount);
+
+		uint32* index = meshData.Indices32.data() + firstIndex;
+		for(uint32 k = 0; k + 1 < ringCount; ++k)
+		{
+			if(!(distances[k+1] > distances[k]))
+				continue;
+
+			const uint32 ring0 = baseIndex + k*ringVertexCount;
+			const uint32 ring1 = ring0 + ringVertexCount;
+			const bool first = frames[k+1].Scale != 0.0f;
+			const bool second = frames[k].Scale != 0.0f;
+
+			for(uint32 j = 0; j < sliceCount; ++j)
+			{
+				if(first)
+				{
+					*index++ = ring0 + j;
+					*index++ = ring1 + j;
+					*index++ = ring1 + j+1;
+				}
+
+				if(second)
+				{
+					*index++ = ring0 + j;
+					*index++ = ring1 + j+1;
+					*index++ = ring0 + j+1;
+				}
+			}
+		}
+
+		assert(index == meshData.Indices32.data() + meshData.Indices32.size());
+	}
+
+	std::vector<RingFrame> LatheFrames(const std::vector<XMFLOAT2>& profile)
+	{
+		std::vector<RingFrame> frames;
+		frames.reserve(profile.size());
+		for(const XMFLOAT2& p : profile)
+			frames.push_back(LatheFrame(p.x, p.y));
+
+		return frames;
+	}
+
+	// Unit vector perpendicular to t, closest to r, or to the world axis least aligned
+	// with t when r is parallel to t.
+	XMVECTOR Perpendicular(FXMVECTOR t, FXMVECTOR r)
+	{
+		XMVECTOR p = r - XMVector3Dot(r, t)*t;
+		if(XMVectorGetX(XMVector3LengthSq(p)) > 1.0e-12f)
+			return XMVector3Normalize(p);
+
+		XMFLOAT3 absT;
+		XMStoreFloat3(&absT, XMVectorAbs(t));
+		XMVECTOR axis = absT.x <= absT.y && absT.x <= absT.z ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) :
+			absT.y <= absT.z ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+		return XMVector3Normalize(axis - XMVector3Dot(axis, t)*t);
+	}
+
+	// Frames along a path, rotated as little as possible from one point to the next
+	// with the double reflection method, so a tube does not twist on its own.
+	std::vector<RingFrame> ExtrusionFrames(const std::vector<XMFLOAT3>& path, const std::vector<float>& radii)
+	{
+		const size_t count = path.size();
+		assert(count >= 2 && radii.size() == count);
+
+		std::vector<RingFrame> frames(count);
+
+		// Direction at each point: the central difference between the nearest points
+		// before and after it that are not at the same place, one-sided at the ends.
+		// Repeated points, as used to close the ends, so get the direction of the
+		// tube they belong to.
+		float axial = 0.0f;
+		for(size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR p = XMLoadFloat3(&path[i]);
+
+			size_t prevIndex = i;
+			while(prevIndex > 0 && XMVector3Equal(XMLoadFloat3(&path[prevIndex]), p))
+				--prevIndex;
+
+			size_t nextIndex = i;
+			while(nextIndex + 1 < count && XMVector3Equal(XMLoadFloat3(&path[nextIndex]), p))
+				++nextIndex;
+
+			XMVECTOR prev = XMLoadFloat3(&path[prevIndex]);
+			XMVECTOR next = XMLoadFloat3(&path[nextIndex]);
+
+			// Where the path turns straight back, use the way out of the point.
+			XMVECTOR direction = next - prev;
+			if(XMVector3Equal(direction, XMVectorZero()))
+				direction = XMVector3Equal(next, p) ? p - prev : next - p;
+
+			// A path that never leaves its first point is swept along +y.
+			if(XMVector3Equal(direction, XMVectorZero()))
+				direction = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+			if(i > 0)
+				axial += XMVectorGetX(XMVector3Length(p - XMLoadFloat3(&path[i-1])));
+
+			frames[i].Origin = path[i];
+			frames[i].Scale = radii[i];
+			frames[i].Axial = axial;
+			XMStoreFloat3(&frames[i].Direction, XMVector3Normalize(direction));
+		}
+
+		// Start from the world axis least aligned with the first direction, which is
+		// that of the first segment with a length.
+		XMVECTOR t = XMLoadFloat3(&frames[0].Direction);
+		XMVECTOR r = Perpendicular(t, XMVectorZero());
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR nextT = XMLoadFloat3(&frames[i].Direction);
+
+			if(i > 0)
+			{
+				// Reflect across the bisector plane of the two points, then across
+				// the plane that maps the reflected direction onto the new one.
+				XMVECTOR v1 = XMLoadFloat3(&path[i]) - XMLoadFloat3(&path[i-1]);
+				float c1 = XMVectorGetX(XMVector3Dot(v1, v1));
+				if(c1 > 0.0f)
+				{
+					XMVECTOR rL = r - (2.0f/c1)*XMVector3Dot(v1, r)*v1;
+					XMVECTOR tL = t - (2.0f/c1)*XMVector3Dot(v1, t)*v1;
+					XMVECTOR v2 = nextT - tL;
+					float c2 = XMVectorGetX(XMVector3Dot(v2, v2));
+					r = c2 > 0.0f ? rL - (2.0f/c2)*XMVector3Dot(v2, rL)*v2 : rL;
+				}
+				t = nextT;
+
+				// A repeated point skips the reflections while the direction may
+				// still change, and rounding builds up over a long path, so project
+				// r back onto the plane of the new direction.
+				r = Perpendicular(t, r);
+			}
+
+			XMStoreFloat3(&frames[i].AxisX, r);
+			XMStoreFloat3(&frames[i].AxisZ, XMVector3Normalize(XMVector3Cross(r, t)));
+		}
+
+		return frames;
+	}
+
+	// The stacks of a cylinder whose radius goes linearly from bottomRadius at the
+	// bottom to topRadius at the top.
+	std::vector<RingFrame> CylinderFrames(float bottomRadius, float topRadius, float height, uint32 stackCount)
+	{
+		float stackHeight = height / stackCount;
+
+		// Amount to increment radius as we move up each stack level from bottom to top.
+		float radiusStep = (topRadius - bottomRadius) / stackCount;
+
+		std::vector<RingFrame> frames(stackCount + 1);
+		for(uint32 i = 0; i <= stackCount; ++i)
+			frames[i] = LatheFrame(bottomRadius + i*radiusStep, -0.5f*height + i*stackHeight);
+
+		return frames;
+	}
+
+	// Appends a cap at the top (normal +y) or bottom (normal -y) of a cylinder.
+	void BuildCylinderCap(const SweepSection& circle, float radius, float height,
+		bool top, MeshData& meshData)
+	{
+		const uint32 sliceCount = circle.Count - 1;
+
+		uint32 baseIndex = (uint32)meshData.Vertices.size();
+		size_t firstIndex = meshData.Indices32.size();
+
+		float y = top ? 0.5f*height : -0.5f*height;
+		float normalY = top ? 1.0f : -1.0f;
+
+		// Duplicate cap ring vertices because the texture coordinates and normals
+		// differ, plus the cap center vertex.
+		meshData.Vertices.resize(baseIndex + sliceCount + 2);
+		meshData.Indices32.resize(firstIndex + 3*sliceCount);
+
+		const XMVECTOR r = XMVectorReplicate(radius);
+		const XMVECTOR heightV = XMVectorReplicate(height);
+		const XMVECTOR half = XMVectorReplicate(0.5f);
+
+		float x[4], z[4], u[4], v[4];
+		for(uint32 i = 0; i <= sliceCount; i += 4)
+		{
+			XMVECTOR cx = r*Load4(&circle.X[i]);
+			XMVECTOR cz = r*Load4(&circle.Z[i]);
+
+			// Scale down by the height to try and make top cap texture coord area
+			// proportional to base.
+			Store4(x, cx);
+			Store4(z, cz);
+			Store4(u, cx/heightV + half);
+			Store4(v, cz/heightV + half);
+
+			const uint32 laneCount = std::min<uint32>(4, sliceCount + 1 - i);
+			for(uint32 k = 0; k < laneCount; ++k)
+				meshData.Vertices[baseIndex + i + k] = Vertex(x[k], y, z[k], 0.0f, normalY, 0.0f, 1.0f, 0.0f, 0.0f, u[k], v[k]);
+		}
+
+		// Cap center vertex.
+		uint32 centerIndex = baseIndex + sliceCount + 1;
+		meshData.Vertices[centerIndex] = Vertex(0.0f, y, 0.0f, 0.0f, normalY, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f);
+
+		// The top cap is seen from above, the bottom one from below.
+		uint32* index = &meshData.Indices32[firstIndex];
+		for(uint32 i = 0; i < sliceCount; ++i)
+		{
+			*index++ = centerIndex;
+			*index++ = baseIndex + (top ? i+1 : i);
+			*index++ = baseIndex + (top ? i : i+1);
+		}
+	}
+
+	// Appends the vertices of a unit-size table with the positions scaled per axis.
+	void AppendScaled(const GeometryTables::UnitVertex* first, const GeometryTables::UnitVertex* last,
+		float sx, float sy, float sz, std::vector<Vertex>& vertices)
+	{
+		size_t base = vertices.size();
+		vertices.resize(base + (last - first));
+
+		for(Vertex* out = &vertices[base]; first != last; ++first, ++out)
+		{
+			out->Position = XMFLOAT3(first->Position[0]*sx, first->Position[1]*sy, first->Position[2]*sz);
+			out->Normal = XMFLOAT3(first->Normal[0], first->Normal[1], first->Normal[2]);
+			out->TangentU = XMFLOAT3(first->TangentU[0], first->TangentU[1], first->TangentU[2]);
+			out->TexC = XMFLOAT2(first->TexC[0], first->TexC[1]);
+		}
+	}
+
+	// Builds a fixed-topology shape from its unit tables, scaled to width x height x depth.
+	template<size_t VertexCount, size_t IndexCount>
+	MeshData FromTables(const GeometryTables::UnitVertex (&vertices)[VertexCount],
+		const uint32 (&indices)[IndexCount], float width, float height, float depth)
+	{
+		MeshData meshData;
+		AppendScaled(std::begin(vertices), std::end(vertices), width, height, depth, meshData.Vertices);
+		meshData.Indices32.assign(std::begin(indices), std::end(indices));
+
+		return meshData;
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBar(float width, float height, float depth, uint32 numSubdivisions)
 {
 	MeshData meshData;
@@ -197,931 +719,8 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
 
 GeometryGenerator::MeshData GeometryGenerator::CreateChocolate(float width, float height, float depth, uint32 numSubdivisions)
 {
-	MeshData meshData;
+	MeshData meshData = FromTables(GeometryTables::ChocolateVertices, GeometryTables::ChocolateIndices, width, height, depth);
 
-	Vertex v[264];
-
-	float w2 = 0.5f*width;
-	float h2 = 0.5f*height;
-	float d2 = 0.5f*depth;
-
-	//chocolate bottom
-				v[0] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[1] = Vertex(-w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[2] = Vertex(+w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[3] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[4] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[5] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[6] = Vertex(+w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[7] = Vertex(-w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[8] = Vertex(-w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[9] = Vertex(-w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[10] = Vertex(+w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[11] = Vertex(+w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[12] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[13] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[14] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[15] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[16] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[17] = Vertex(-w2, +h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[18] = Vertex(-w2, +h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[19] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[20] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[21] = Vertex(+w2, +h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[22] = Vertex(+w2, +h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[23] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 1
-				v[24] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[25] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[26] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[27] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[28] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[29] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[30] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[31] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[32] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[33] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[34] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[35] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[36] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[37] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[38] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[39] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[40] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[41] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[42] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[43] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[44] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[45] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[46] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[47] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 2
-				v[48] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[49] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[50] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[51] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[52] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[53] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[54] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[55] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[56] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[57] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[58] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[59] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[60] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[61] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[62] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[63] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[64] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[65] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[66] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[67] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[68] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[69] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[70] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[71] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 3
-				v[72] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[73] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[74] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[75] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[76] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[77] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[78] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[79] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[80] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[81] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[82] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[83] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[84] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[85] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[86] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[87] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[88] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[89] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[90] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[91] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[92] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[93] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[94] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[95] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 4
-				v[96] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[97] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[98] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[99] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[100] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[101] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[102] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[103] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[104] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[105] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[106] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[107] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[108] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[109] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[110] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[111] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[112] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[113] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[114] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[115] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[116] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[117] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[118] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[119] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 5
-				v[120] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[121] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[122] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[123] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[124] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[125] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[126] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[127] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[128] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[129] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[130] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[131] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[132] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[133] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[134] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[135] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[136] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[137] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[138] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[139] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[140] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[141] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[142] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[143] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 6
-				v[144] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[145] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[146] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[147] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[148] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[149] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[150] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[151] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[152] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[153] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[154] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[155] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[156] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[157] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[158] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[159] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[160] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[161] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[162] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[163] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[164] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[165] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[166] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[167] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 7
-				v[168] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[169] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[170] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[171] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[172] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[173] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[174] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[175] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[176] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[177] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[178] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[179] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[180] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[181] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[182] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[183] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[184] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[185] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[186] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[187] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[188] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[189] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[190] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[191] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 8
-				v[192] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[193] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[194] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[195] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[196] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[197] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[198] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[199] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[200] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[201] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[202] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[203] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[204] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[205] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[206] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[207] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[208] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[209] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[210] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[211] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[212] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[213] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[214] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[215] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 9
-				v[216] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[217] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[218] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[219] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[220] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[221] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[222] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[223] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[224] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[225] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[226] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[227] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[228] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[229] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[233] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[231] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[232] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[233] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[234] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[235] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[236] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[237] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[238] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[239] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				//chocolate top 10
-				v[240] = Vertex(-w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[241] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[242] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[243] = Vertex(+w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the back face vertex data.
-				v[244] = Vertex(-w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[245] = Vertex(+w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[246] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[247] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the top face vertex data.
-				v[248] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[249] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[250] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-				v[251] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-				// Fill in the bottom face vertex data.
-				v[252] = Vertex(-w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-				v[253] = Vertex(+w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-				v[254] = Vertex(+w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-				v[255] = Vertex(-w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-
-				// Fill in the left face vertex data.
-				v[256] = Vertex(-w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-				v[257] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-				v[258] = Vertex(-w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-				v[259] = Vertex(-w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-
-				// Fill in the right face vertex data.
-				v[260] = Vertex(+w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-				v[261] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-				v[262] = Vertex(+w2 * 0.9f, +h2 * 0.9f, 0.9f * +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-				v[263] = Vertex(+w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-
-				meshData.Vertices.assign(&v[0], &v[264]);
-
-			
-
-			//	meshData.Indices32.assign(&i[0 + ], &i[36 + ]);
-				
-
-
-		//
-		// Create the indices.
-		//
-		uint32 i[396];
-		// Fill in the front face index data
-		//Bottom Box
-		i[0] = 0; 
-		i[1] = 1; 
-		i[2] = 2;
-		i[3] = 0; 
-		i[4] = 2; 
-		i[5] = 3;
-
-		// Fill in the back face index data
-		i[6] = 4; 
-		i[7] = 5; 
-		i[8] = 6;
-		i[9] = 4; 
-		i[10] = 6; 
-		i[11] = 7;
-
-		// Fill in the top face index data
-		i[12] = 8; 
-		i[13] = 9; 
-		i[14] = 10;
-		i[15] = 8; 
-		i[16] = 10; 
-		i[17] = 11;
-
-		// Fill in the bottom face index data
-		i[18] = 12; 
-		i[19] = 13; 
-		i[20] = 14;
-		i[21] = 12; 
-		i[22] = 14; 
-		i[23] = 15;
-
-		// Fill in the left face index data
-		i[24] = 16; 
-		i[25] = 17; 
-		i[26] = 18;
-		i[27] = 16; 
-		i[28] = 18; 
-		i[29] = 19;
-
-		// Fill in the right face index data
-		i[30] = 20; 
-		i[31] = 21; 
-		i[32] = 22;
-		i[33] = 20; 
-		i[34] = 22; 
-		i[35] = 23;
-
-		//Candy top 1
-		i[36] = 0;
-		i[37] = 1;
-		i[38] = 2;
-		i[39] = 0;
-		i[40] = 2;
-		i[41] = 3;
-
-		// Fill in the back face index data
-		i[42] = 4;
-		i[43] = 5;
-		i[44] = 6;
-		i[45] = 4;
-		i[46] = 6;
-		i[47] = 7;
-
-		// Fill in the top face index data
-		i[48] = 8;
-		i[49] = 9;
-		i[50] = 10;
-		i[51] = 8;
-		i[52] = 10;
-		i[53] = 11;
-
-		// Fill in the bottom face index data
-		i[54] = 12;
-		i[55] = 13;
-		i[56] = 14;
-		i[57] = 12;
-		i[58] = 14;
-		i[59] = 15;
-
-		// Fill in the left face index data
-		i[60] = 16;
-		i[61] = 17;
-		i[62] = 18;
-		i[63] = 16;
-		i[64] = 18;
-		i[65] = 19;
-
-		// Fill in the right face index data
-		i[66] = 20;
-		i[67] = 21;
-		i[68] = 22;
-		i[67] = 20;
-		i[70] = 22;
-		i[71] = 23;
-
-		//Candy top 2
-		i[72] = 0;
-		i[73] = 1;
-		i[74] = 2;
-		i[75] = 0;
-		i[76] = 2;
-		i[77] = 3;
-
-		// Fill in the back face index data
-		i[78] = 4;
-		i[79] = 5;
-		i[80] = 6;
-		i[81] = 4;
-		i[82] = 6;
-		i[83] = 7;
-
-		// Fill in the top face index data
-		i[84] = 8;
-		i[85] = 9;
-		i[86] = 10;
-		i[87] = 8;
-		i[88] = 10;
-		i[89] = 11;
-
-		// Fill in the bottom face index data
-		i[90] = 12;
-		i[91] = 13;
-		i[92] = 14;
-		i[93] = 12;
-		i[94] = 14;
-		i[95] = 15;
-
-		// Fill in the left face index data
-		i[96] = 16;
-		i[97] = 17;
-		i[98] = 18;
-		i[99] = 16;
-		i[100] = 18;
-		i[101] = 19;
-
-		// Fill in the right face index data
-		i[102] = 20;
-		i[103] = 21;
-		i[104] = 22;
-		i[105] = 20;
-		i[106] = 22;
-		i[107] = 23;
-
-		//Candy top 3
-		i[108] = 0;
-		i[109] = 1;
-		i[110] = 2;
-		i[111] = 0;
-		i[112] = 2;
-		i[113] = 3;
-
-		// Fill in the back face index data
-		i[114] = 4;
-		i[115] = 5;
-		i[116] = 6;
-		i[117] = 4;
-		i[118] = 6;
-		i[119] = 7;
-
-		// Fill in the top face index data
-		i[120] = 8;
-		i[121] = 9;
-		i[122] = 10;
-		i[123] = 8;
-		i[124] = 10;
-		i[125] = 11;
-
-		// Fill in the bottom face index data
-		i[126] = 12;
-		i[127] = 13;
-		i[128] = 14;
-		i[129] = 12;
-		i[130] = 14;
-		i[131] = 15;
-
-		// Fill in the left face index data
-		i[132] = 16;
-		i[133] = 17;
-		i[134] = 18;
-		i[135] = 16;
-		i[136] = 18;
-		i[137] = 19;
-
-		// Fill in the right face index data
-		i[138] = 20;
-		i[139] = 21;
-		i[140] = 22;
-		i[141] = 20;
-		i[142] = 22;
-		i[143] = 23;
-
-		//Candy top 4
-		i[144] = 0;
-		i[145] = 1;
-		i[146] = 2;
-		i[147] = 0;
-		i[148] = 2;
-		i[149] = 3;
-
-		// Fill in the back face index data
-		i[150] = 4;
-		i[151] = 5;
-		i[152] = 6;
-		i[153] = 4;
-		i[154] = 6;
-		i[155] = 7;
-
-		// Fill in the top face index data
-		i[156] = 8;
-		i[157] = 9;
-		i[158] = 10;
-		i[159] = 8;
-		i[160] = 10;
-		i[161] = 11;
-
-		// Fill in the bottom face index data
-		i[162] = 12;
-		i[163] = 13;
-		i[164] = 14;
-		i[165] = 12;
-		i[166] = 14;
-		i[167] = 15;
-
-		// Fill in the left face index data
-		i[168] = 16;
-		i[169] = 17;
-		i[170] = 18;
-		i[171] = 16;
-		i[172] = 18;
-		i[173] = 19;
-
-		// Fill in the right face index data
-		i[174] = 20;
-		i[175] = 21;
-		i[176] = 22;
-		i[177] = 20;
-		i[178] = 22;
-		i[179] = 23;
-
-		//Candy top 5
-		i[180] = 0;
-		i[181] = 1;
-		i[182] = 2;
-		i[183] = 0;
-		i[184] = 2;
-		i[185] = 3;
-
-		// Fill in the back face index data
-		i[186] = 4;
-		i[187] = 5;
-		i[188] = 6;
-		i[189] = 4;
-		i[190] = 6;
-		i[191] = 7;
-
-		// Fill in the top face index data
-		i[192] = 8;
-		i[193] = 9;
-		i[194] = 10;
-		i[195] = 8;
-		i[196] = 10;
-		i[197] = 11;
-
-		// Fill in the bottom face index data
-		i[198] = 12;
-		i[199] = 13;
-		i[200] = 14;
-		i[201] = 12;
-		i[202] = 14;
-		i[203] = 15;
-
-		// Fill in the left face index data
-		i[204] = 16;
-		i[205] = 17;
-		i[206] = 18;
-		i[207] = 16;
-		i[208] = 18;
-		i[209] = 19;
-
-		// Fill in the right face index data
-		i[210] = 20;
-		i[211] = 21;
-		i[212] = 22;
-		i[213] = 20;
-		i[214] = 22;
-		i[215] = 23;
-
-
-		//Candy top 6
-		i[216] = 0;
-		i[217] = 1;
-		i[218] = 2;
-		i[219] = 0;
-		i[220] = 2;
-		i[221] = 3;
-
-		// Fill in the back face index data
-		i[222] = 4;
-		i[223] = 5;
-		i[224] = 6;
-		i[225] = 4;
-		i[226] = 6;
-		i[227] = 7;
-
-		// Fill in the top face index data
-		i[228] = 8;
-		i[229] = 9;
-		i[230] = 10;
-		i[231] = 8;
-		i[232] = 10;
-		i[233] = 11;
-
-		// Fill in the bottom face index data
-		i[234] = 12;
-		i[235] = 13;
-		i[236] = 14;
-		i[237] = 12;
-		i[238] = 14;
-		i[239] = 15;
-
-		// Fill in the left face index data
-		i[240] = 16;
-		i[241] = 17;
-		i[242] = 18;
-		i[243] = 16;
-		i[244] = 18;
-		i[245] = 19;
-
-		// Fill in the right face index data
-		i[246] = 20;
-		i[247] = 21;
-		i[248] = 22;
-		i[249] = 20;
-		i[250] = 22;
-		i[251] = 23;
-
-		//Candy top 7
-		i[252] = 0;
-		i[253] = 1;
-		i[254] = 2;
-		i[255] = 0;
-		i[256] = 2;
-		i[257] = 3;
-
-		// Fill in the back face index data
-		i[258] = 4;
-		i[259] = 5;
-		i[260] = 6;
-		i[261] = 4;
-		i[262] = 6;
-		i[263] = 7;
-
-		// Fill in the top face index data
-		i[264] = 8;
-		i[265] = 9;
-		i[266] = 10;
-		i[267] = 8;
-		i[268] = 10;
-		i[269] = 11;
-
-		// Fill in the bottom face index data
-		i[270] = 12;
-		i[271] = 13;
-		i[272] = 14;
-		i[273] = 12;
-		i[274] = 14;
-		i[275] = 15;
-
-		// Fill in the left face index data
-		i[276] = 16;
-		i[277] = 17;
-		i[278] = 18;
-		i[279] = 16;
-		i[280] = 18;
-		i[281] = 19;
-
-		// Fill in the right face index data
-		i[282] = 20;
-		i[283] = 21;
-		i[284] = 22;
-		i[285] = 20;
-		i[286] = 22;
-		i[287] = 23;
-
-		//Candy top 8
-		i[288] = 0;
-		i[289] = 1;
-		i[290] = 2;
-		i[291] = 0;
-		i[292] = 2;
-		i[293] = 3;
-
-		// Fill in the back face index data
-		i[294] = 4;
-		i[295] = 5;
-		i[296] = 6;
-		i[297] = 4;
-		i[298] = 6;
-		i[299] = 7;
-
-		// Fill in the top face index data
-		i[300] = 8;
-		i[301] = 9;
-		i[302] = 10;
-		i[303] = 8;
-		i[304] = 10;
-		i[305] = 11;
-
-		// Fill in the bottom face index data
-		i[306] = 12;
-		i[307] = 13;
-		i[308] = 14;
-		i[309] = 12;
-		i[310] = 14;
-		i[311] = 15;
-
-		// Fill in the left face index data
-		i[312] = 16;
-		i[313] = 17;
-		i[314] = 18;
-		i[315] = 16;
-		i[316] = 18;
-		i[317] = 19;
-
-		// Fill in the right face index data
-		i[318] = 20;
-		i[319] = 21;
-		i[320] = 22;
-		i[321] = 20;
-		i[322] = 22;
-		i[323] = 23;
-
-		//Candy top 9
-		i[324] = 0;
-		i[325] = 1;
-		i[326] = 2;
-		i[327] = 0;
-		i[328] = 2;
-		i[329] = 3;
-
-		// Fill in the back face index data
-		i[330] = 4;
-		i[331] = 5;
-		i[332] = 6;
-		i[333] = 4;
-		i[334] = 6;
-		i[335] = 7;
-
-		// Fill in the top face index data
-		i[336] = 8;
-		i[337] = 9;
-		i[338] = 10;
-		i[339] = 8;
-		i[340] = 10;
-		i[341] = 11;
-
-		// Fill in the bottom face index data
-		i[342] = 12;
-		i[343] = 13;
-		i[344] = 14;
-		i[345] = 12;
-		i[346] = 14;
-		i[347] = 15;
-
-		// Fill in the left face index data
-		i[348] = 16;
-		i[349] = 17;
-		i[350] = 18;
-		i[351] = 16;
-		i[352] = 18;
-		i[353] = 19;
-
-		// Fill in the right face index data
-		i[354] = 20;
-		i[355] = 21;
-		i[356] = 22;
-		i[357] = 20;
-		i[358] = 22;
-		i[359] = 23;
-
-		//candy 10
-		// Fill in the front face index data
-		i[360] = 0; 
-		i[361] = 1; i[362] = 2;
-		i[363] = 0; i[364] = 2; i[365] = 3;
-
-		// Fill in the back face index data
-		i[366] = 4; i[367] = 5; i[368] = 6;
-		i[369] = 4; i[370] = 6; i[371] = 7;
-
-		// Fill in the top face index data
-		i[372] = 8; i[373] = 9; i[374] = 10;
-		i[375] = 8; i[376] = 10; i[377] = 11;
-
-		// Fill in the bottom face index data
-		i[378] = 12; i[379] = 13; i[380] = 14;
-		i[381] = 12; i[382] = 14; i[383] = 15;
-
-		// Fill in the left face index data
-		i[384] = 16; i[385] = 17; i[386] = 18;
-		i[387] = 16; i[388] = 18; i[389] = 19;
-
-		// Fill in the right face index data
-		i[390] = 20; i[391] = 21; i[392] = 22;
-		i[393] = 20; i[394] = 22; i[395] = 23;
-
-		meshData.Indices32.assign(&i[0], &i[396]);
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
 
@@ -1129,7 +728,6 @@ GeometryGenerator::MeshData GeometryGenerator::CreateChocolate(float width, floa
 		Subdivide(meshData);
 
 	return meshData;
-
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateBar2(float width, float height, float depth, uint32 numSubdivisions)
@@ -1299,66 +897,49 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 
 	//
 	// Compute the vertices stating at the top pole and moving down the stacks.
+	// The sines and cosines of every stack and slice angle are evaluated up front,
+	// so each ring is written from the tables without any per vertex trig.
 	//
 
+	SinCosTable stacks(stackCount, XM_PI/stackCount);
+	SweepSection circle = CircleSection(sliceCount);
+
+	// Poles are not counted as rings.
+	uint32 ringCount = stackCount - 1;
+	uint32 ringVertexCount = sliceCount + 1;
+
+	meshData.Vertices.resize(ringCount*ringVertexCount + 2);
+	meshData.Indices32.resize(6*sliceCount*ringCount);
+
 	// Poles: note that there will be texture coordinate distortion as there is
 	// not a unique point on the texture map to assign to the pole when mapping
 	// a rectangular texture onto a sphere.
-	Vertex topVertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	Vertex bottomVertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	meshData.Vertices.front() = Vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	meshData.Vertices.back() = Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-	meshData.Vertices.push_back( topVertex );
-
-	float phiStep   = XM_PI/stackCount;
-	float thetaStep = 2.0f*XM_PI/sliceCount;
-
-	// Compute vertices for each stack ring (do not count the poles as rings).
-	for(uint32 i = 1; i <= stackCount-1; ++i)
+	// Compute vertices for each stack ring.  The normal of a point on the sphere
+	// is its position divided by the radius, so the profile normal is exact
+	// rather than averaged from the neighbouring rings.
+	for(uint32 i = 1; i <= ringCount; ++i)
 	{
-		float phi = i*phiStep;
-
-		// Vertices of ring.
-        for(uint32 j = 0; j <= sliceCount; ++j)
-		{
-			float theta = j*thetaStep;
-
-			Vertex v;
-
-			// spherical to cartesian
-			v.Position.x = radius*sinf(phi)*cosf(theta);
-			v.Position.y = radius*cosf(phi);
-			v.Position.z = radius*sinf(phi)*sinf(theta);
-
-			// Partial derivative of P with respect to theta
-			v.TangentU.x = -radius*sinf(phi)*sinf(theta);
-			v.TangentU.y = 0.0f;
-			v.TangentU.z = +radius*sinf(phi)*cosf(theta);
-
-			XMVECTOR T = XMLoadFloat3(&v.TangentU);
-			XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
+		float sinPhi = stacks.Sin[i];
+		float cosPhi = stacks.Cos[i];
 
-			XMVECTOR p = XMLoadFloat3(&v.Position);
-			XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
-
-			v.TexC.x = theta / XM_2PI;
-			v.TexC.y = phi / XM_PI;
-
-			meshData.Vertices.push_back( v );
-		}
+		WriteSweptRing(circle, LatheFrame(radius*sinPhi, radius*cosPhi), sinPhi, cosPhi,
+			(float)i/stackCount, &meshData.Vertices[1 + (i-1)*ringVertexCount]);
 	}
 
-	meshData.Vertices.push_back( bottomVertex );
-
 	//
 	// Compute indices for top stack.  The top stack was written first to the vertex buffer
 	// and connects the top pole to the first ring.
 	//
 
+	uint32* index = meshData.Indices32.data();
     for(uint32 i = 1; i <= sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(0);
-		meshData.Indices32.push_back(i+1);
-		meshData.Indices32.push_back(i);
+		*index++ = 0;
+		*index++ = i+1;
+		*index++ = i;
 	}
 	
 	//
@@ -1368,18 +949,17 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	// Offset the indices to the index of the first vertex in the first ring.
 	// This is just skipping the top pole vertex.
     uint32 baseIndex = 1;
-    uint32 ringVertexCount = sliceCount + 1;
 	for(uint32 i = 0; i < stackCount-2; ++i)
 	{
 		for(uint32 j = 0; j < sliceCount; ++j)
 		{
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
+			*index++ = baseIndex + i*ringVertexCount + j;
+			*index++ = baseIndex + i*ringVertexCount + j+1;
+			*index++ = baseIndex + (i+1)*ringVertexCount + j;
 
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back(baseIndex + i*ringVertexCount + j+1);
-			meshData.Indices32.push_back(baseIndex + (i+1)*ringVertexCount + j+1);
+			*index++ = baseIndex + (i+1)*ringVertexCount + j;
+			*index++ = baseIndex + i*ringVertexCount + j+1;
+			*index++ = baseIndex + (i+1)*ringVertexCount + j+1;
 		}
 	}
 
@@ -1396,130 +976,48 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
 	
 	for(uint32 i = 0; i < sliceCount; ++i)
 	{
-		meshData.Indices32.push_back(southPoleIndex);
-		meshData.Indices32.push_back(baseIndex+i);
-		meshData.Indices32.push_back(baseIndex+i+1);
+		*index++ = southPoleIndex;
+		*index++ = baseIndex+i;
+		*index++ = baseIndex+i+1;
 	}
 
+	assert(index == meshData.Indices32.data() + meshData.Indices32.size());
+
     return meshData;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateCandy(float width, float height, float depth, uint32 numSubdivisions)
 {
-	MeshData meshData;
-
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[20];
-
 	float w2 = 0.5f*width;
 	float h2 = 0.5f*height;
 	float d2 = 0.5f*depth;
 
-	// Fill in the top face vertex data.
-	v[0] = Vertex(0.0f   * w2, h2, 0.0f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-0.5f  * w2, h2, -0.5  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(-0.75f * w2, h2, 0.0f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(-0.5f  * w2, h2, 0.5f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[4] = Vertex(0.5f   * w2, h2, 0.5f  * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[5] = Vertex(0.75f  * w2, h2, 0.0f  * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[6] = Vertex(0.5f   * w2, h2, -0.5f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-
-	//Bottom
-	v[7] = Vertex(0.0f   * w2, -h2, 0.0f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[8] = Vertex(-0.5f  * w2, -h2, -0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[9] = Vertex(-0.75f * w2, -h2, 0.0f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[10] = Vertex(-0.5f  * w2, -h2, 0.5f  * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[11] = Vertex(0.5f   * w2, -h2, 0.5f  * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[12] = Vertex(0.75f  * w2, -h2, 0.0f  * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[13] = Vertex(0.5f   * w2, -h2, -0.5f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-
-	//////Middle! 
-	v[14] = Vertex(-0.5f  * (w2*1.5f), 0.0f, -0.5f * (d2*1.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[15] = Vertex(-0.75f * (w2*1.5f), 0.0f, 0.0f  * (d2*1.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[16] = Vertex(-0.5f * (w2*1.5f), 0.0f, 0.5f  * (d2*1.5f), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[17] = Vertex(0.5f  * (w2*1.5f), 0.0f, 0.5f  * (d2*1.5f), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[18] = Vertex(0.75f * (w2*1.5f), 0.0f, 0.0f  * (d2*1.5f), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[19] = Vertex(0.5f  * (w2*1.5f), 0.0f, -0.5f * (d2*1.5f), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-
-
-	meshData.Vertices.assign(&v[0], &v[20]);
+	// A six sided section, widest along x.
+	std::vector<XMFLOAT2> section =
+	{
+		XMFLOAT2(0.75f*w2, 0.0f),
+		XMFLOAT2(0.5f*w2, 0.5f*d2),
+		XMFLOAT2(-0.5f*w2, 0.5f*d2),
+		XMFLOAT2(-0.75f*w2, 0.0f),
+		XMFLOAT2(-0.5f*w2, -0.5f*d2),
+		XMFLOAT2(0.5f*w2, -0.5f*d2)
+	};
 
-	//
-	// Create the indices.
-	//
+	// Flat bottom and top faces with a band that bulges to one and a half times
+	// the section at half height.  The repeated points crease the edges of the
+	// faces.
+	std::vector<XMFLOAT2> profile =
+	{
+		XMFLOAT2(0.0f, -h2),
+		XMFLOAT2(1.0f, -h2),
+		XMFLOAT2(1.0f, -h2),
+		XMFLOAT2(1.5f, 0.0f),
+		XMFLOAT2(1.0f, +h2),
+		XMFLOAT2(1.0f, +h2),
+		XMFLOAT2(0.0f, +h2)
+	};
 
-	uint32 i[108];
-
-	// Fill in the top face index data
-	i[0] = 0; i[1] = 1; i[2] = 2;
-	i[3] = 0; i[4] = 2; i[5] = 3;
-	i[6] = 0; i[7] = 3; i[8] = 4;
-	i[9] = 0; i[10] = 4; i[11] = 5;
-	i[12] = 0; i[13] = 5; i[14] = 6;
-	i[15] = 0; i[16] = 6; i[17] = 1;
-
-	/////bottom face indices
-	i[18] = 7; i[19] = 9; i[20] = 8;
-	i[21] = 7; i[22] = 10; i[23] = 9;
-	i[24] = 7; i[25] = 11; i[26] = 10;
-	i[27] = 7; i[28] = 12; i[29] = 11;
-	i[30] = 7; i[31] = 13; i[32] = 12;
-	i[33] = 7; i[34] = 8; i[35] = 13;
-
-
-	/*Old
-	//Perimeter Top 1/2
-	i[36] = 1; i[37] = 8; i[38] = 2;
-	i[39] = 2; i[40] = 9; i[41] = 3;
-	i[42] = 3; i[43] = 10; i[44] = 4;
-	i[45] = 4; i[46] = 11; i[47] = 5;
-	i[48] = 5; i[49] = 12; i[50] = 6;
-	i[51] = 6; i[52] = 13; i[53] = 1;
-
-	//Perimeter Top 2/2
-	i[54] = 8; i[55] = 9; i[56] = 2;
-	i[57] = 9; i[58] = 10; i[59] = 3;
-	i[60] = 10; i[61] = 11; i[62] = 4;
-	i[63] = 11; i[64] = 12; i[65] = 5;
-	i[66] = 12; i[67] = 13; i[68] = 6;
-	i[69] = 13; i[70] = 8; i[71] = 1;	*/
-
-	//Perimeter Top 1/2
-	i[36] = 1; i[37] = 14; i[38] = 2;
-	i[39] = 2; i[40] = 15; i[41] = 3;
-	i[42] = 3; i[43] = 16; i[44] = 4;
-	i[45] = 4; i[46] = 17; i[47] = 5;
-	i[48] = 5; i[49] = 18; i[50] = 6;
-	i[51] = 6; i[52] = 19; i[53] = 1;
-
-	//Perimeter Top 2/2
-	i[54] = 14; i[55] = 15; i[56] = 2;
-	i[57] = 15; i[58] = 16; i[59] = 3;
-	i[60] = 16; i[61] = 17; i[62] = 4;
-	i[63] = 17; i[64] = 18; i[65] = 5;
-	i[66] = 18; i[67] = 19; i[68] = 6;
-	i[69] = 19; i[70] = 14; i[71] = 1;
-
-	//Perimeter Bottom 1/2
-	i[36 + 36] = 14; i[37 + 36] = 8; i[38 + 36] = 15;
-	i[39 + 36] = 15; i[40 + 36] = 9; i[41 + 36] = 16;
-	i[42 + 36] = 16; i[43 + 36] = 10; i[44 + 36] = 17;
-	i[45 + 36] = 17; i[46 + 36] = 11; i[47 + 36] = 18;
-	i[48 + 36] = 18; i[49 + 36] = 12; i[50 + 36] = 19;
-	i[51 + 36] = 19; i[52 + 36] = 13; i[53 + 36] = 14;
-
-	//Perimeter Bottom 2/2
-	i[54 + 36] = 8; i[55 + 36] = 9; i[56 + 36] = 15;
-	i[57 + 36] = 9; i[58 + 36] = 10; i[59 + 36] = 16;
-	i[60 + 36] = 10; i[61 + 36] = 11; i[62 + 36] = 17;
-	i[63 + 36] = 11; i[64 + 36] = 12; i[65 + 36] = 18;
-	i[66 + 36] = 12; i[67 + 36] = 13; i[68 + 36] = 19;
-	i[69 + 36] = 13; i[70 + 36] = 8; i[71 + 36] = 14;
-
-	meshData.Indices32.assign(&i[0], &i[108]);
+	MeshData meshData = CreateLathe(profile, section);
 
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
@@ -1531,6 +1029,83 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCandy(float width, float he
 }
  
 void GeometryGenerator::Subdivide(MeshData& meshData)
+{
+	//       v1
+	//       *
+	//      / \
+	//     /   \
+	//  m0*-----*m1
+	//   / \   / \
+	//  /   \ /   \
+	// *-----*-----*
+	// v0    m2     v2
+
+	uint32 numVerts = (uint32)meshData.Vertices.size();
+	uint32 numTris = (uint32)meshData.Indices32.size()/3;
+
+	// The input vertices keep their indices and every edge adds exactly one midpoint.
+	// A mesh has at most 3*numTris edges, so one reserve covers the whole pass.
+	meshData.Vertices.reserve(numVerts + 3*numTris);
+
+	//
+	// Edge -> midpoint cache.  Open addressing on the packed (min,max) vertex pair
+	// keeps the lookup allocation free; the table is kept at most half full.
+	//
+
+	uint32 tableSize = 1;
+	while(tableSize < 6*numTris)
+		tableSize <<= 1;
+
+	const std::uint64_t emptyKey = ~0ull;
+	std::vector<std::uint64_t> edgeKeys(tableSize, emptyKey);
+	std::vector<uint32> edgeMidpoints(tableSize);
+
+	auto midpointIndex = [&](uint32 a, uint32 b) -> uint32
+	{
+		std::uint64_t key = a < b ?
+			((std::uint64_t)a << 32) | b :
+			((std::uint64_t)b << 32) | a;
+
+		uint32 slot = (uint32)((key * 0x9E3779B97F4A7C15ull) >> 32) & (tableSize-1);
+		while(edgeKeys[slot] != emptyKey)
+		{
+			if(edgeKeys[slot] == key)
+				return edgeMidpoints[slot];
+
+			slot = (slot + 1) & (tableSize-1);
+		}
+
+		uint32 m = (uint32)meshData.Vertices.size();
+		meshData.Vertices.push_back(MidPoint(meshData.Vertices[a], meshData.Vertices[b]));
+
+		edgeKeys[slot] = key;
+		edgeMidpoints[slot] = m;
+		return m;
+	};
+
+	std::vector<uint32> indices(numTris*12);
+	for(uint32 i = 0; i < numTris; ++i)
+	{
+		uint32 v0 = meshData.Indices32[i*3+0];
+		uint32 v1 = meshData.Indices32[i*3+1];
+		uint32 v2 = meshData.Indices32[i*3+2];
+
+		uint32 m0 = midpointIndex(v0, v1);
+		uint32 m1 = midpointIndex(v1, v2);
+		uint32 m2 = midpointIndex(v0, v2);
+
+		uint32* tri = &indices[i*12];
+
+		tri[0] = v0; tri[1]  = m0; tri[2]  = m2;
+		tri[3] = m0; tri[4]  = m1; tri[5]  = m2;
+		tri[6] = m2; tri[7]  = m1; tri[8]  = v2;
+		tri[9] = m0; tri[10] = v1; tri[11] = m1;
+	}
+
+	meshData.Indices32.swap(indices);
+}
+
+void GeometryGenerator::SubdivideUnshared(MeshData& meshData)
 {
 	// Save a copy of the input geometry.
 	MeshData inputCopy = meshData;
@@ -1662,209 +1237,89 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 	for(uint32 i = 0; i < numSubdivisions; ++i)
 		Subdivide(meshData);
 
-	// Project vertices onto sphere and scale.
-	for(uint32 i = 0; i < meshData.Vertices.size(); ++i)
-	{
-		// Project onto unit sphere.
-		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&meshData.Vertices[i].Position));
-
-		// Project onto sphere.
-		XMVECTOR p = radius*n;
-
-		XMStoreFloat3(&meshData.Vertices[i].Position, p);
-		XMStoreFloat3(&meshData.Vertices[i].Normal, n);
-
-		// Derive texture coordinates from spherical coordinates.
-        float theta = atan2f(meshData.Vertices[i].Position.z, meshData.Vertices[i].Position.x);
-
-        // Put in [0, 2pi].
-        if(theta < 0.0f)
-            theta += XM_2PI;
-
-		float phi = acosf(meshData.Vertices[i].Position.y / radius);
-
-		meshData.Vertices[i].TexC.x = theta/XM_2PI;
-		meshData.Vertices[i].TexC.y = phi/XM_PI;
-
-		// Partial derivative of P with respect to theta
-		meshData.Vertices[i].TangentU.x = -radius*sinf(phi)*sinf(theta);
-		meshData.Vertices[i].TangentU.y = 0.0f;
-		meshData.Vertices[i].TangentU.z = +radius*sinf(phi)*cosf(theta);
-
-		XMVECTOR T = XMLoadFloat3(&meshData.Vertices[i].TangentU);
-		XMStoreFloat3(&meshData.Vertices[i].TangentU, XMVector3Normalize(T));
-	}
-
-    return meshData;
-}
-
-GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
-{
-    MeshData meshData;
-
-	//
-	// Build Stacks.
-	// 
-
-	float stackHeight = height / stackCount;
-
-	// Amount to increment radius as we move up each stack level from bottom to top.
-	float radiusStep = (topRadius - bottomRadius) / stackCount;
+	// Project vertices onto sphere and scale, four vertices at a time.
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR twoPi = XMVectorReplicate(XM_2PI);
+	const XMVECTOR pi = XMVectorReplicate(XM_PI);
 
-	uint32 ringCount = stackCount+1;
+	const uint32 vertexCount = (uint32)meshData.Vertices.size();
 
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for(uint32 i = 0; i < ringCount; ++i)
+	float x[4], y[4], z[4], u[4], v[4], tx[4], tz[4];
+	for(uint32 i = 0; i < vertexCount; i += 4)
 	{
-		float y = -0.5f*height + i*stackHeight;
-		float r = bottomRadius + i*radiusStep;
+		const uint32 laneCount = std::min<uint32>(4, vertexCount - i);
 
-		// vertices of ring
-		float dTheta = 2.0f*XM_PI/sliceCount;
-		for(uint32 j = 0; j <= sliceCount; ++j)
+		// The lanes past the end of the last batch repeat its first vertex.
+		for(uint32 k = 0; k < 4; ++k)
 		{
-			Vertex vertex;
-
-			float c = cosf(j*dTheta);
-			float s = sinf(j*dTheta);
-
-			vertex.Position = XMFLOAT3(r*c, y, r*s);
-
-			vertex.TexC.x = (float)j/sliceCount;
-			vertex.TexC.y = 1.0f - (float)i/stackCount;
-
-			// Cylinder can be parameterized as follows, where we introduce v
-			// parameter that goes in the same direction as the v tex-coord
-			// so that the bitangent goes in the same direction as the v tex-coord.
-			//   Let r0 be the bottom radius and let r1 be the top radius.
-			//   y(v) = h - hv for v in [0,1].
-			//   r(v) = r1 + (r0-r1)v
-			//
-			//   x(t, v) = r(v)*cos(t)
-			//   y(t, v) = h - hv
-			//   z(t, v) = r(v)*sin(t)
-			// 
-			//  dx/dt = -r(v)*sin(t)
-			//  dy/dt = 0
-			//  dz/dt = +r(v)*cos(t)
-			//
-			//  dx/dv = (r0-r1)*cos(t)
-			//  dy/dv = -h
-			//  dz/dv = (r0-r1)*sin(t)
-
-			// This is unit length.
-			vertex.TangentU = XMFLOAT3(-s, 0.0f, c);
-
-			float dr = bottomRadius-topRadius;
-			XMFLOAT3 bitangent(dr*c, -height, dr*s);
-
-			XMVECTOR T = XMLoadFloat3(&vertex.TangentU);
-			XMVECTOR B = XMLoadFloat3(&bitangent);
-			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-			XMStoreFloat3(&vertex.Normal, N);
-
-			meshData.Vertices.push_back(vertex);
+			const XMFLOAT3& p = meshData.Vertices[i + (k < laneCount ? k : 0)].Position;
+			x[k] = p.x;
+			y[k] = p.y;
+			z[k] = p.z;
 		}
-	}
 
-	// Add one because we duplicate the first and last vertex per ring
-	// since the texture coordinates are different.
-	uint32 ringVertexCount = sliceCount+1;
+		XMVECTOR px = Load4(x);
+		XMVECTOR py = Load4(y);
+		XMVECTOR pz = Load4(z);
 
-	// Compute indices for each stack.
-	for(uint32 i = 0; i < stackCount; ++i)
-	{
-		for(uint32 j = 0; j < sliceCount; ++j)
+		// Project onto unit sphere.
+		XMVECTOR length = XMVectorSqrt(px*px + py*py + pz*pz);
+		XMVECTOR nx = px/length;
+		XMVECTOR ny = py/length;
+		XMVECTOR nz = pz/length;
+
+		// Derive texture coordinates from spherical coordinates, with theta put in
+		// [0, 2pi].
+		XMVECTOR theta = XMVectorATan2(nz, nx);
+		theta = XMVectorSelect(theta, theta + twoPi, XMVectorLess(theta, zero));
+
+		XMVECTOR phi = XMVectorACos(XMVectorClamp(ny, -one, one));
+
+		// Partial derivative of P with respect to theta, (-sin(phi)*sin(theta), 0,
+		// sin(phi)*cos(theta)), points along (-z, 0, x).  It vanishes at the poles,
+		// which get the same +x tangent as the poles of CreateSphere.
+		XMVECTOR ringRadius = XMVectorSqrt(nx*nx + nz*nz);
+		XMVECTOR pole = XMVectorEqual(ringRadius, zero);
+
+		Store4(x, nx);
+		Store4(y, ny);
+		Store4(z, nz);
+		Store4(u, theta/twoPi);
+		Store4(v, phi/pi);
+		Store4(tx, XMVectorSelect(-nz/ringRadius, one, pole));
+		Store4(tz, XMVectorSelect(nx/ringRadius, zero, pole));
+
+		for(uint32 k = 0; k < laneCount; ++k)
 		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i+1)*ringVertexCount + j+1);
-			meshData.Indices32.push_back(i*ringVertexCount + j+1);
+			Vertex& vertex = meshData.Vertices[i + k];
+			vertex.Position = XMFLOAT3(radius*x[k], radius*y[k], radius*z[k]);
+			vertex.Normal = XMFLOAT3(x[k], y[k], z[k]);
+			vertex.TangentU = XMFLOAT3(tx[k], 0.0f, tz[k]);
+			vertex.TexC = XMFLOAT2(u[k], v[k]);
 		}
 	}
 
-	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-
     return meshData;
 }
 
-void GeometryGenerator::BuildCylinderTopCap(float bottomRadius, float topRadius, float height,
-											uint32 sliceCount, uint32 stackCount, MeshData& meshData)
-{
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
-
-	float y = 0.5f*height;
-	float dTheta = 2.0f*XM_PI/sliceCount;
-
-	// Duplicate cap ring vertices because the texture coordinates and normals differ.
-	for(uint32 i = 0; i <= sliceCount; ++i)
-	{
-		float x = topRadius*cosf(i*dTheta);
-		float z = topRadius*sinf(i*dTheta);
-
-		// Scale down by the height to try and make top cap texture coord area
-		// proportional to base.
-		float u = x/height + 0.5f;
-		float v = z/height + 0.5f;
-
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
-	}
-
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
-
-	// Index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
-
-	for(uint32 i = 0; i < sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i+1);
-		meshData.Indices32.push_back(baseIndex + i);
-	}
-}
-
-void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadius, float height,
-											   uint32 sliceCount, uint32 stackCount, MeshData& meshData)
+GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
 {
-	// 
-	// Build bottom cap.
-	//
-
-	uint32 baseIndex = (uint32)meshData.Vertices.size();
-	float y = -0.5f*height;
-
-	// vertices of ring
-	float dTheta = 2.0f*XM_PI/sliceCount;
-	for(uint32 i = 0; i <= sliceCount; ++i)
-	{
-		float x = bottomRadius*cosf(i*dTheta);
-		float z = bottomRadius*sinf(i*dTheta);
-
-		// Scale down by the height to try and make top cap texture coord area
-		// proportional to base.
-		float u = x/height + 0.5f;
-		float v = z/height + 0.5f;
+    MeshData meshData;
 
-		meshData.Vertices.push_back( Vertex(x, y, z, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, u, v) );
-	}
+	// The stacks are a lathe of a straight profile.  The caps are separate so
+	// their texture coordinates can be planar mapped.
+	SweepSection circle = CircleSection(sliceCount);
 
-	// Cap center vertex.
-	meshData.Vertices.push_back( Vertex(0.0f, y, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f) );
+	uint32 ringVertexCount = sliceCount+1;
+	meshData.Vertices.reserve((stackCount+1)*ringVertexCount + 2*(ringVertexCount+1));
+	meshData.Indices32.reserve(6*stackCount*sliceCount + 6*sliceCount);
 
-	// Cache the index of center vertex.
-	uint32 centerIndex = (uint32)meshData.Vertices.size()-1;
+	BuildSweep(circle, CylinderFrames(bottomRadius, topRadius, height, stackCount), meshData);
+	BuildCylinderCap(circle, topRadius, height, true, meshData);
+	BuildCylinderCap(circle, bottomRadius, height, false, meshData);
 
-	for(uint32 i = 0; i < sliceCount; ++i)
-	{
-		meshData.Indices32.push_back(centerIndex);
-		meshData.Indices32.push_back(baseIndex + i);
-		meshData.Indices32.push_back(baseIndex + i+1);
-	}
+    return meshData;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32 m, uint32 n)
@@ -1979,49 +1434,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, floa
 
 GeometryGenerator::MeshData GeometryGenerator::CreateTetrahedron(float width, float height, float depth, uint32 numSubdivisions)
 {
-	MeshData meshData;
-
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[4];
-
-	float w2 = 0.5f*width;
-	float h2 = 0.5f*height;
-	float d2 = 0.5f*depth;
-
-	// Fill in the top face vertex data.
-	v[0] = Vertex(0.0f* w2, 1.0f * h2, -0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-1.0f * w2, 0.0f * h2, -1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(0.0f* w2, 0.0f * h2, 1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(1.0f* w2, 0.0f * h2, -1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	
-
-	
-
-	meshData.Vertices.assign(&v[0], &v[4]);
-
-	//
-	// Create the indices.
-	//
-
-	uint32 i[12];
-
-	// Fill in the bottom face index data
-	i[0] = 2; i[1] = 1; i[2] = 3;
-
-
-	////side1
-	i[3] = 0; i[4] = 3; i[5] = 1;
-
-	///side2
-	i[6] = 0; i[7] = 1; i[8] = 2;
-
-	////side3
-	i[9] = 0; i[10] = 2; i[11] = 3;
-
-	meshData.Indices32.assign(&i[0], &i[12]);
+	MeshData meshData = FromTables(GeometryTables::TetrahedronVertices, GeometryTables::TetrahedronIndices, width, height, depth);
 
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
@@ -2039,53 +1452,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTetrahedron(float width, fl
 
 GeometryGenerator::MeshData GeometryGenerator::CreatePyramid(float width, float height, float depth, uint32 numSubdivisions)
 {
-	MeshData meshData;
-
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[5];
-
-	float w2 = 0.5f*width;
-	float h2 = 0.5f*height;
-	float d2 = 0.5f*depth;
-
-	// Fill in the top face vertex data.
-	v[0] = Vertex(0.0f* w2, 1.0f * h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-1.0f * w2, 0.0f * h2, -1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(-1.0f* w2, 0.0f * h2, 1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(1.0f* w2, 0.0f * h2, 1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[4] = Vertex(1.0f* w2, 0.0f * h2, -1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-
-
-	meshData.Vertices.assign(&v[0], &v[5]);
-
-	//
-	// Create the indices.
-	//
-
-	uint32 i[18];
-
-	// Fill in the bottom face index data
-	i[0] = 4; i[1] = 2; i[2] = 1;
-	i[3] = 4; i[4] = 3; i[5] = 2;
-
-
-	///side1
-	i[6] = 0; i[7] = 4; i[8] = 1;
-
-	////side2
-	i[9] = 0; i[10] = 1; i[11] = 2;
-
-	/////side3
-	i[12] = 0; i[13] = 2; i[14] = 3;
-
-	/////side4
-	i[15] = 0; i[16] = 3; i[17] = 4;
-
-	meshData.Indices32.assign(&i[0], &i[18]);
+	MeshData meshData = FromTables(GeometryTables::PyramidVertices, GeometryTables::PyramidIndices, width, height, depth);
 
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
@@ -2103,56 +1470,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreatePyramid(float width, float
 
 GeometryGenerator::MeshData GeometryGenerator::CreateWedge(float width, float height, float depth, uint32 numSubdivisions)
 {
-	MeshData meshData;
-
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[6];
-
-	float w2 = 0.5f*width;
-	float h2 = 0.5f*height;
-	float d2 = 0.5f*depth;
-
-	// Fill in the top face vertex data.
-	v[0] = Vertex(-1.0f* w2, 0.0f * h2, -0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-1.0f * w2, 0.0f * h2, 0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(1.0f* w2, 0.0f * h2, 0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(1.0f* w2, 0.0f * h2, -0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[4] = Vertex(-1.0f* w2, 1.0f * h2, -0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[5] = Vertex(-1.0f* w2, 1.0f * h2,  0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-
-
-	meshData.Vertices.assign(&v[0], &v[6]);
-
-	//
-	// Create the indices.
-	//
-
-	uint32 i[24];
-
-	// Fill in the bottom face index data
-	i[0] = 1; i[1] = 0; i[2] = 3;
-	i[3] = 1; i[4] = 3; i[5] = 2;
-
-
-	///side1
-	i[6] = 1; i[7] = 5; i[8] = 4;
-	i[9] = 1; i[10] = 4; i[11] = 0;
-
-	/////side2
-	i[12] = 4; i[13] = 5; i[14] = 2;
-	i[15] = 4; i[16] = 2; i[17] = 3;
-
-	////front
-	i[18] = 0; i[19] = 4; i[20] = 3;
-
-	////back
-	i[21] = 1; i[22] = 2; i[23] = 5;
-
-
-	meshData.Indices32.assign(&i[0], &i[24]);
+	MeshData meshData = FromTables(GeometryTables::WedgeVertices, GeometryTables::WedgeIndices, width, height, depth);
 
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
@@ -2171,81 +1489,15 @@ GeometryGenerator::MeshData GeometryGenerator::CreateHexagon(float width, float
 {
 	MeshData meshData;
 
-	//
-	// Create the vertices.
-	//
+	const GeometryTables::UnitVertex* top = std::begin(GeometryTables::HexagonVertices);
+	const GeometryTables::UnitVertex* ring = top + GeometryTables::HexagonTopVertexCount;
+	const GeometryTables::UnitVertex* end = std::end(GeometryTables::HexagonVertices);
 
-	Vertex v[24];
+	// The bottom ring is half a unit wider than the top on every axis.
+	AppendScaled(top, ring, width, height, depth, meshData.Vertices);
+	AppendScaled(ring, end, width + 1.0f, height + 1.0f, depth + 1.0f, meshData.Vertices);
 
-	float w2 = 0.5f*width;
-	float h2 = 0.5f*height;
-	float d2 = 0.5f*depth;
-
-	// Fill in the top face vertex data.
-	v[0] = Vertex(0.0f* w2, 0.0f * h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-0.5f * w2, 0.0f * h2, -0.5 * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(-0.75f* w2, 0.0f * h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(-0.5f* w2, 0.0f * h2, 0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[4] = Vertex(0.5f* w2, 0.0f * h2, 0.5f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[5] = Vertex(0.75f* w2, 0.0f* h2, 0.0f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[6] = Vertex(0.5f* w2, 0.0f * h2, -0.5f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-
-	//////BOTTOM FACE VERTEX DATA
-	v[7] = Vertex(0.0f* (w2+0.5), -0.3f * (h2+0.5), 0.0f * (d2+0.5), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[8] = Vertex(-0.5f * (w2+0.5), -0.3f * (h2+0.5), -0.5 * (d2+0.5), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[9] = Vertex(-0.75f* (w2+0.5), -0.3f * (h2+0.5), 0.0f * (d2+0.5), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[10] = Vertex(-0.5f* (w2+0.5), -0.3f * (h2+0.5), 0.5f * (d2+0.5), 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[11] = Vertex(0.5f* (w2+0.5), -0.3f * (h2+0.5), 0.5f* (d2+0.5), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[12] = Vertex(0.75f* (w2+0.5), -0.3f* (h2+0.5), 0.0f * (d2+0.5), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[13] = Vertex(0.5f* (w2+0.5), -0.3f * (h2+0.5), -0.5f * (d2+0.5), 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-/*
-	v[7] = Vertex(0.0f* w2, -0.3f * h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[8] = Vertex(-0.5f * w2, -0.3f * h2, -0.5 * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[9] = Vertex(-0.75f* w2, -0.3f * h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[10] = Vertex(-0.5f* w2, -0.3f * h2, 0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[11] = Vertex(0.5f* w2, -0.3f * h2, 0.5f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[12] = Vertex(0.75f* w2, -0.3f* h2, 0.0f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[13] = Vertex(0.5f* w2, -0.3f * h2, -0.5f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	*/
-	meshData.Vertices.assign(&v[0], &v[24]);
-
-	//
-	// Create the indices.
-	//
-
-	uint32 i[72];
-
-	// Fill in the top face index data
-	i[0] = 0; i[1] = 1; i[2] = 2;
-	i[3] = 0; i[4] = 2; i[5] = 3;
-	i[6] = 0; i[7] = 3; i[8] = 4;
-	i[9] = 0; i[10] = 4; i[11] = 5;
-	i[12] = 0; i[13] = 5; i[14] = 6;
-	i[15] = 0; i[16] = 6; i[17] = 1;
-
-	/////bottom face indices
-	i[18] = 7; i[19] = 9; i[20] = 8;
-	i[21] = 7; i[22] = 10; i[23] = 9;
-	i[24] = 7; i[25] = 11; i[26] = 10;
-	i[27] = 7; i[28] = 12; i[29] = 11;
-	i[30] = 7; i[31] = 13; i[32] = 12;
-	i[33] = 7; i[34] = 8; i[35] = 13;
-
-	i[36] = 1; i[37] = 8; i[38] = 2;
-	i[39] = 2; i[40] = 9; i[41] = 3;
-	i[42] = 3; i[43] = 10; i[44] = 4;
-	i[45] = 4; i[46] = 11; i[47] = 5;
-	i[48] = 5; i[49] = 12; i[50] = 6;
-	i[51] = 6; i[52] = 13; i[53] = 1;
-
-	i[54] = 8; i[55] = 9; i[56] = 2;
-	i[57] = 9; i[58] = 10; i[59] = 3;
-	i[60] = 10; i[61] = 11; i[62] = 4;
-	i[63] = 11; i[64] = 12; i[65] = 5;
-	i[66] = 12; i[67] = 13; i[68] = 6;
-	i[69] = 13; i[70] = 8; i[71] = 1;	
-
-	meshData.Indices32.assign(&i[0], &i[72]);
+	meshData.Indices32.assign(std::begin(GeometryTables::HexagonIndices), std::end(GeometryTables::HexagonIndices));
 
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
@@ -2264,273 +1516,58 @@ GeometryGenerator::MeshData GeometryGenerator::CreateCone(float bottomRadius, fl
 {
 	MeshData meshData;
 
-	//
-	// Build Stacks.
-	// 
-
-	float stackHeight = height / stackCount;
-
-	// Amount to increment radius as we move up each stack level from bottom to top.
-	float radiusStep = (0 - bottomRadius) / stackCount;
-
-	uint32 ringCount = stackCount + 1;
-
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for (uint32 i = 0; i < ringCount; ++i)
-	{
-		float y = -0.5f*height + i * stackHeight;
-		float r = bottomRadius + i * radiusStep;
+	// A cone is a cylinder with a top radius of zero and no top cap.
+	SweepSection circle = CircleSection(sliceCount);
 
-		// vertices of ring
-		float dTheta = 2.0f*XM_PI / sliceCount;
-		for (uint32 j = 0; j <= sliceCount; ++j)
-		{
-			Vertex vertex;
-
-			float c = cosf(j*dTheta);
-			float s = sinf(j*dTheta);
-
-			vertex.Position = XMFLOAT3(r*c, y, r*s);
-
-			vertex.TexC.x = (float)j / sliceCount;
-			vertex.TexC.y = 1.0f - (float)i / stackCount;
-
-			// Cylinder can be parameterized as follows, where we introduce v
-			// parameter that goes in the same direction as the v tex-coord
-			// so that the bitangent goes in the same direction as the v tex-coord.
-			//   Let r0 be the bottom radius and let r1 be the top radius.
-			//   y(v) = h - hv for v in [0,1].
-			//   r(v) = r1 + (r0-r1)v
-			//
-			//   x(t, v) = r(v)*cos(t)
-			//   y(t, v) = h - hv
-			//   z(t, v) = r(v)*sin(t)
-			// 
-			//  dx/dt = -r(v)*sin(t)
-			//  dy/dt = 0
-			//  dz/dt = +r(v)*cos(t)
-			//
-			//  dx/dv = (r0-r1)*cos(t)
-			//  dy/dv = -h
-			//  dz/dv = (r0-r1)*sin(t)
-
-			// This is unit length.
-			vertex.TangentU = XMFLOAT3(-s, 0.0f, c);
-
-			float dr = bottomRadius;
-			XMFLOAT3 bitangent(dr*c, -height, dr*s);
-
-			XMVECTOR T = XMLoadFloat3(&vertex.TangentU);
-			XMVECTOR B = XMLoadFloat3(&bitangent);
-			XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-			XMStoreFloat3(&vertex.Normal, N);
-
-			meshData.Vertices.push_back(vertex);
-		}
-	}
-
-	// Add one because we duplicate the first and last vertex per ring
-	// since the texture coordinates are different.
 	uint32 ringVertexCount = sliceCount + 1;
+	meshData.Vertices.reserve((stackCount + 1)*ringVertexCount + ringVertexCount + 1);
+	meshData.Indices32.reserve(6 * stackCount*sliceCount + 3 * sliceCount);
 
-	// Compute indices for each stack.
-	for (uint32 i = 0; i < stackCount; ++i)
-	{
-		for (uint32 j = 0; j < sliceCount; ++j)
-		{
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i + 1)*ringVertexCount + j);
-			meshData.Indices32.push_back((i + 1)*ringVertexCount + j + 1);
-
-			meshData.Indices32.push_back(i*ringVertexCount + j);
-			meshData.Indices32.push_back((i + 1)*ringVertexCount + j + 1);
-			meshData.Indices32.push_back(i*ringVertexCount + j + 1);
-		}
-	}
-
-	BuildCylinderBottomCap(bottomRadius, 0, height, sliceCount, stackCount, meshData);
+	BuildSweep(circle, CylinderFrames(bottomRadius, 0.0f, height, stackCount), meshData);
+	BuildCylinderCap(circle, bottomRadius, height, false, meshData);
 
 	return meshData;
 }
 
-///////////////////////////cone////////////////////////////////////////
-
-//diamond
-GeometryGenerator::MeshData GeometryGenerator::CreateDiamond(float width, float height, float depth, uint32 numSubdivisions)
+GeometryGenerator::MeshData GeometryGenerator::CreateLathe(const std::vector<XMFLOAT2>& profile, uint32 sliceCount)
 {
 	MeshData meshData;
+	BuildSweep(CircleSection(sliceCount), LatheFrames(profile), meshData);
 
-	//
-	// Create the vertices.
-	//
-
-	Vertex v[40];
-
-	float w2 = 0.5* width;
-	float h2 = 0.5* height;
-	float d2 = 0.5* depth;
-
-	////////////// Fill in the front face vertex data.
-	v[0] = Vertex(0.0f * w2, 0.0f *h2, 1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[1] = Vertex(-0.5f * w2, 0.5f*h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	v[2] = Vertex(0.5f* w2, 0.5f*h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[3] = Vertex(-0.25f* w2, 1.0f*h2, 0.5f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[4] = Vertex(0.25f* w2, 1.0f*h2, 0.5f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	//////////////////// Fill in the front face vertex data.
-
-
-
-	//side 2
-	v[5] = Vertex(0.0f* w2, 0.0f*h2, 1.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[6] = Vertex(0.5f* w2, 0.5f*h2, 0.0f * d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[7] = Vertex(1.0f* w2, 0.5f*h2, 0.5f * d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[8] = Vertex(0.25f* w2, 1.0f*h2, 0.5f * d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[9] = Vertex(0.50f* w2, 1.f*h2, 0.75f * d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	//side 2
-
-
-	////side 3
-	v[10] = Vertex(0.0f* w2, 0.0f*h2, 1.0f * d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[11] = Vertex(-1.0f* w2, 0.5f*h2, 0.5f * d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[12] = Vertex(-0.5f* w2, 0.5f*h2, 0.0f * d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[13] = Vertex(-0.50f* w2, 1.0f*h2, 0.75f * d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-	v[14] = Vertex(-0.25f* w2, 1.0f*h2, 0.5f * d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	///side 3
-
-
-	//side 4 - back
-	v[15] = Vertex(0.0f* w2, 0.0f*h2, 1.0f * d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[16] = Vertex(-0.5f* w2, 0.5f*h2, 2.0f * d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f);
-	v[17] = Vertex(0.5f* w2, 0.5f*h2, 2.0f * d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-	v[18] = Vertex(-0.25f* w2, 1.0f*h2, 1.5f * d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f);
-	v[19] = Vertex(0.25f* w2, 1.0f*h2, 1.5f * d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f);
-	//side 4
-
-	//side 5
-	v[20] = Vertex(0.0f* w2, 0.0f*h2, 1.0f* d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
-	v[21] = Vertex(0.5f* w2, 0.5f*h2, 2.0f* d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-	v[22] = Vertex(1.0f* w2, 0.5f*h2, 1.5f* d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
-	v[23] = Vertex(0.25f* w2, 1.0f*h2, 1.5f* d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
-	v[24] = Vertex(0.5f* w2, 1.0f*h2, 1.25f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	//side 5
-
-	//side 6
-	v[25] = Vertex(0.0f* w2, 0.0f*h2, 1.0f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[26] = Vertex(-0.5f* w2, 0.5f*h2, 2.0f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[27] = Vertex(-1.0f* w2, 0.5f*h2, 1.5f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[28] = Vertex(-0.25f* w2, 1.0f*h2, 1.5f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[29] = Vertex(-0.5f* w2, 1.0f*h2, 1.25f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	//side 6
-
-
-	//side 7
-	v[30] = Vertex(0.0f* w2, 0.0f*h2, 1.0f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[31] = Vertex(1.0f* w2, 0.5f*h2, 0.5f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[32] = Vertex(1.0f* w2, 0.5f*h2, 1.5f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[33] = Vertex(0.50f* w2, 1.f*h2, 0.75f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[34] = Vertex(0.5f* w2, 1.0f*h2, 1.25f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	//side 7
-
-	//side 8
-	v[35] = Vertex(0.0f* w2, 0.0f*h2, 1.0f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-	v[36] = Vertex(-1.0f* w2, 0.5f*h2, 0.5f* d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[37] = Vertex(-1.0f* w2, 0.5f*h2, 1.5f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[38] = Vertex(-0.50f* w2, 1.f*h2, 0.75f* d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f);
-	v[39] = Vertex(-0.5f* w2, 1.0f*h2, 1.25f* d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	//side 8
-
-
-
-
-	///////////////////////////////////////LID
-
-
-
-	meshData.Vertices.assign(&v[0], &v[40]);
-
-	//
-	// Create the indices.
-	//
-
-	uint32 i[90];
-
-	//////////////// Fill in the front face index data
-	i[0] = 0; i[1] = 1; i[2] = 2;
-	i[3] = 1; i[4] = 3; i[5] = 2;
-	i[6] = 3; i[7] = 4; i[8] = 2;
-	///////////////// Fill in the front face index data
-
-
-
-	///side 2
-	i[9] = 5; i[10] = 6; i[11] = 7;
-	i[12] = 6; i[13] = 8; i[14] = 7;
-	i[15] = 8; i[16] = 9; i[17] = 7;
-	///side 2
-
-
-	//side 3
-	i[18] = 10; i[19] = 11; i[20] = 12;
-	i[21] = 11; i[22] = 13; i[23] = 12;
-	i[24] = 13; i[25] = 14; i[26] = 12;
-	//side 3
-
-	//side4
-	i[27] = 16; i[28] = 15; i[29] = 17;
-	i[30] = 18; i[31] = 16; i[32] = 17;
-	i[33] = 19; i[34] = 18; i[35] = 17;
-	//side 4
-
-	//side 5
-	i[36] = 21; i[37] = 20; i[38] = 22;
-	i[39] = 23; i[40] = 21; i[41] = 22;
-	i[42] = 24; i[43] = 23; i[44] = 22;
-	//side 5
-
-	//side 6
-	i[45] = 25; i[46] = 26; i[47] = 27;
-	i[48] = 26; i[49] = 28; i[50] = 27;
-	i[51] = 28; i[52] = 29; i[53] = 27;
-	//side 6
-
-
-	//side 7
-	i[54] = 30; i[55] = 31; i[56] = 32;
-	i[57] = 31; i[58] = 33; i[59] = 32;
-	i[60] = 33; i[61] = 34; i[62] = 32;
-	//side 7
-
-	//side 8
-	i[63] = 36; i[64] = 35; i[65] = 37;
-	i[66] = 38; i[67] = 36; i[68] = 37;
-	i[69] = 39; i[70] = 38; i[71] = 37;
-	//side 8
-
-/*	////////////////////////////////lid
-	i[72] = 3; i[73] = 18; i[74] = 19;
-	i[75] = 3; i[76] = 19; i[77] = 24;
-	i[78] = 3; i[79] = 9; i[80] = 8;
-	i[81] = 3; i[82] = 29; i[83] = 28;
-	i[84] = 3; i[85] = 34; i[86] = 33;
-	i[87] = 3; i[88] = 13; i[89] = 29;
-
-*/	///////////////////////////////////lid
+	return meshData;
+}
 
+GeometryGenerator::MeshData GeometryGenerator::CreateLathe(const std::vector<XMFLOAT2>& profile, const std::vector<XMFLOAT2>& section)
+{
+	MeshData meshData;
+	BuildSweep(PolygonSection(section), LatheFrames(profile), meshData);
 
-	//last i
-	//i[74] = 50;
+	return meshData;
+}
 
+GeometryGenerator::MeshData GeometryGenerator::CreateExtrusion(const std::vector<XMFLOAT3>& path, const std::vector<float>& radii, uint32 sliceCount)
+{
+	MeshData meshData;
+	BuildSweep(CircleSection(sliceCount), ExtrusionFrames(path, radii), meshData);
 
+	return meshData;
+}
 
-	meshData.Indices32.assign(&i[0], &i[90]);
+GeometryGenerator::MeshData GeometryGenerator::CreateExtrusion(const std::vector<XMFLOAT3>& path, const std::vector<float>& radii, const std::vector<XMFLOAT2>& section)
+{
+	MeshData meshData;
+	BuildSweep(PolygonSection(section), ExtrusionFrames(path, radii), meshData);
 
-	// Put a cap on the number of subdivisions.
-	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	return meshData;
+}
 
-	for (uint32 i = 0; i < numSubdivisions; ++i)
-		//	Subdivide(meshData);
+///////////////////////////cone////////////////////////////////////////
 
-		return meshData;
+//diamond
+GeometryGenerator::MeshData GeometryGenerator::CreateDiamond(float width, float height, float depth, uint32 numSubdivisions)
+{
+	// The diamond is always built unsubdivided; numSubdivisions is ignored.
+	return FromTables(GeometryTables::DiamondVertices, GeometryTables::DiamondIndices, width, height, depth);
 }
 
 //
\ No newline at end of file
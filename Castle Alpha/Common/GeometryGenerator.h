@@ -13,9 +13,11 @@
 //***************************************************************************************
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <Windows.h>
 #include <DirectXMath.h>
+#include <stdexcept>
 #include <vector>
 
 class GeometryGenerator
@@ -62,6 +64,14 @@ public:
         {
 			if(mIndices16.empty())
 			{
+				// A mesh this big needs 32-bit indices.  Narrowing would wrap the
+				// index and draw the wrong vertices, so this fails in every build.
+				for(uint32 index : Indices32)
+				{
+					if(index > 0xffff)
+						throw std::out_of_range("MeshData::GetIndices16: index does not fit in 16 bits");
+				}
+
 				mIndices16.resize(Indices32.size());
 				for(size_t i = 0; i < Indices32.size(); ++i)
 					mIndices16[i] = static_cast<uint16>(Indices32[i]);
@@ -108,6 +118,26 @@ public:
 	///</summary>
 	MeshData CreateCone(float bottomRadius, float height, uint32 sliceCount, uint32 stackCount);
 
+	///<summary>
+	/// Revolves a profile of (radius, height) points about the y-axis.  A profile that
+	/// goes up on the outside faces outward.  Repeating a point creases the surface
+	/// there, and a point with radius zero closes it, so a cylinder with caps is
+	/// (0,-h) (r,-h) (r,-h) (r,h) (r,h) (0,h).  The section overload replaces the
+	/// circle with a closed polygon in the xz-plane, counterclockwise from +x to +z,
+	/// scaled by each radius.
+	///</summary>
+	MeshData CreateLathe(const std::vector<DirectX::XMFLOAT2>& profile, uint32 sliceCount);
+	MeshData CreateLathe(const std::vector<DirectX::XMFLOAT2>& profile, const std::vector<DirectX::XMFLOAT2>& section);
+
+	///<summary>
+	/// Sweeps a circle, or a polygon as for CreateLathe, along a path with a radius per
+	/// path point.  The frames along the path minimize rotation, so the tube does not
+	/// twist.  The ends are open unless the path repeats its end points with a radius
+	/// of zero.
+	///</summary>
+	MeshData CreateExtrusion(const std::vector<DirectX::XMFLOAT3>& path, const std::vector<float>& radii, uint32 sliceCount);
+	MeshData CreateExtrusion(const std::vector<DirectX::XMFLOAT3>& path, const std::vector<float>& radii, const std::vector<DirectX::XMFLOAT2>& section);
+
 	///<summary>
 	/// Creates an mxn grid in the xz-plane with m rows and n columns, centered
 	/// at the origin with the specified width and depth.
@@ -129,10 +159,19 @@ public:
 	MeshData CreatePyramid(float width, float height, float depth, uint32 numSubdivisions);
 	MeshData CreateWedge(float width, float height, float depth, uint32 numSubdivisions);
 
-private:
+	///<summary>
+	/// Splits every triangle of the mesh into four.  The midpoint of an edge is shared
+	/// by the triangles on both sides of it, so the output stays an indexed mesh.
+	///</summary>
 	void Subdivide(MeshData& meshData);
+
+	///<summary>
+	/// The original subdivision path, which emits six unshared vertices per input
+	/// triangle.  Kept as the reference that Subdivide is benchmarked against.
+	///</summary>
+	void SubdivideUnshared(MeshData& meshData);
+
+private:
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
-    void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
-    void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
 };
 
@@ -0,0 +1,373 @@
+//***************************************************************************************
+// MeshOptimizer.cpp
+//***************************************************************************************
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	using uint32 = MeshOptimizer::uint32;
+
+	// Size of the LRU cache the scoring models.  Larger than any real post-transform
+	// cache so the order degrades gracefully on smaller hardware caches.
+	const int kCacheSize = 32;
+	const int kMaxValence = 32;
+
+	const float kCacheDecayPower = 1.5f;
+	const float kLastTriScore = 0.75f;
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	struct ScoreTables
+	{
+		ScoreTables()
+		{
+			for(int i = 0; i < kCacheSize; ++i)
+			{
+				// The three vertices of the last triangle get a fixed score so the
+				// next triangle does not simply reuse the same edge over and over.
+				if(i < 3)
+					Cache[i] = kLastTriScore;
+				else
+					Cache[i] = powf(1.0f - (float)(i - 3) / (kCacheSize - 3), kCacheDecayPower);
+			}
+
+			Valence[0] = 0.0f;
+			for(int i = 1; i <= kMaxValence; ++i)
+				Valence[i] = kValenceBoostScale * powf((float)i, -kValenceBoostPower);
+		}
+
+		float Cache[kCacheSize];
+		float Valence[kMaxValence + 1];
+	};
+
+	const ScoreTables& GetScoreTables()
+	{
+		static ScoreTables tables;
+		return tables;
+	}
+
+	float VertexScore(int cachePosition, uint32 liveValence)
+	{
+		// Vertices with no triangles left are never worth anything.
+		if(liveValence == 0)
+			return -1.0f;
+
+		const ScoreTables& tables = GetScoreTables();
+
+		float score = cachePosition >= 0 ? tables.Cache[cachePosition] : 0.0f;
+		score += tables.Valence[std::min<uint32>(liveValence, kMaxValence)];
+
+		return score;
+	}
+
+	// Hashes and compares the leading FloatCount floats of a vertex.  -0.0f and 0.0f
+	// compare equal, so they must hash the same too.
+	template<int FloatCount>
+	struct VertexKey
+	{
+		float Values[FloatCount];
+
+		bool operator==(const VertexKey& rhs)const
+		{
+			for(int i = 0; i < FloatCount; ++i)
+			{
+				if(Values[i] != rhs.Values[i])
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	template<int FloatCount>
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey<FloatCount>& key)const
+		{
+			std::uint64_t h = 14695981039346656037ull;
+			for(int i = 0; i < FloatCount; ++i)
+			{
+				float f = key.Values[i] == 0.0f ? 0.0f : key.Values[i];
+
+				std::uint32_t bits;
+				memcpy(&bits, &f, sizeof(bits));
+
+				h = (h ^ bits) * 1099511628211ull;
+			}
+
+			return (size_t)h;
+		}
+	};
+
+	template<int FloatCount>
+	uint32 WeldVerticesImpl(MeshOptimizer::MeshData& meshData)
+	{
+		static_assert(FloatCount*sizeof(float) <= sizeof(GeometryGenerator::Vertex),
+			"Weld key is larger than the vertex.");
+
+		std::vector<GeometryGenerator::Vertex>& vertices = meshData.Vertices;
+
+		std::unordered_map<VertexKey<FloatCount>, uint32, VertexKeyHash<FloatCount>> firstIndex;
+		firstIndex.reserve(vertices.size());
+
+		std::vector<uint32> remap(vertices.size());
+		std::vector<GeometryGenerator::Vertex> welded;
+		welded.reserve(vertices.size());
+
+		for(size_t v = 0; v < vertices.size(); ++v)
+		{
+			// Position, Normal, TangentU and TexC are laid out as consecutive floats.
+			VertexKey<FloatCount> key;
+			memcpy(key.Values, &vertices[v].Position, sizeof(key.Values));
+
+			auto it = firstIndex.find(key);
+			if(it != firstIndex.end())
+			{
+				remap[v] = it->second;
+			}
+			else
+			{
+				remap[v] = (uint32)welded.size();
+				firstIndex.emplace(key, remap[v]);
+				welded.push_back(vertices[v]);
+			}
+		}
+
+		for(uint32& index : meshData.Indices32)
+			index = remap[index];
+
+		uint32 removed = (uint32)(vertices.size() - welded.size());
+		vertices.swap(welded);
+
+		return removed;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(MeshData& meshData)
+{
+	OptimizeVertexCache(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices.size());
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	const uint32 triCount = (uint32)(indexCount / 3);
+	if(triCount == 0 || !ValidateIndices(indices, triCount*3, vertexCount))
+		return;
+
+	//
+	// Vertex -> triangle adjacency, stored as one flat array with per vertex offsets.
+	// liveValence counts the not yet emitted triangles at the front of each range.
+	//
+
+	std::vector<uint32> liveValence(vertexCount, 0);
+	for(size_t i = 0; i < triCount*3; ++i)
+		++liveValence[indices[i]];
+
+	std::vector<uint32> adjOffset(vertexCount + 1, 0);
+	for(size_t v = 0; v < vertexCount; ++v)
+		adjOffset[v + 1] = adjOffset[v] + liveValence[v];
+
+	std::vector<uint32> adjTris(triCount*3);
+	{
+		std::vector<uint32> cursor(adjOffset.begin(), adjOffset.end() - 1);
+		for(uint32 t = 0; t < triCount; ++t)
+		{
+			for(uint32 k = 0; k < 3; ++k)
+				adjTris[cursor[indices[t*3 + k]]++] = t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for(size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = VertexScore(-1, liveValence[v]);
+
+	std::vector<bool> emitted(triCount, false);
+
+	int bestTri = -1;
+	float bestScore = -1.0f;
+	for(uint32 t = 0; t < triCount; ++t)
+	{
+		float score = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+		if(score > bestScore)
+		{
+			bestScore = score;
+			bestTri = (int)t;
+		}
+	}
+
+	// Two cache buffers, swapped every step.  The extra three slots hold the vertices
+	// that get pushed out by the triangle just emitted.
+	int cacheA[kCacheSize + 3];
+	int cacheB[kCacheSize + 3];
+	int* cache = cacheA;
+	int* newCache = cacheB;
+	int cacheCount = 0;
+
+	std::vector<uint32> output(triCount*3);
+	uint32 scanCursor = 0;
+
+	for(uint32 outTri = 0; outTri < triCount; ++outTri)
+	{
+		// Nothing in the cache touches an open triangle, so continue with the next
+		// triangle in input order.
+		if(bestTri < 0)
+		{
+			while(emitted[scanCursor])
+				++scanCursor;
+			bestTri = (int)scanCursor;
+		}
+
+		const uint32 t = (uint32)bestTri;
+		const uint32* tri = &indices[t*3];
+
+		output[outTri*3 + 0] = tri[0];
+		output[outTri*3 + 1] = tri[1];
+		output[outTri*3 + 2] = tri[2];
+		emitted[t] = true;
+
+		// Remove the triangle from the live adjacency of its vertices.
+		for(uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = tri[k];
+			uint32* begin = &adjTris[adjOffset[v]];
+			uint32* end = begin + liveValence[v];
+			uint32* it = std::find(begin, end, t);
+			std::swap(*it, *(end - 1));
+			--liveValence[v];
+		}
+
+		// New LRU order: the emitted triangle's vertices first, then the old contents.
+		int newCount = 0;
+		for(uint32 k = 0; k < 3; ++k)
+			newCache[newCount++] = (int)tri[k];
+
+		for(int i = 0; i < cacheCount; ++i)
+		{
+			int v = cache[i];
+			if(v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2])
+				newCache[newCount++] = v;
+		}
+
+		// Vertices that fell off the end lose their cache score.
+		for(int i = kCacheSize; i < newCount; ++i)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScore[newCache[i]] = VertexScore(-1, liveValence[newCache[i]]);
+		}
+
+		cacheCount = std::min(newCount, kCacheSize);
+		std::swap(cache, newCache);
+
+		for(int i = 0; i < cacheCount; ++i)
+		{
+			cachePosition[cache[i]] = i;
+			vertexScore[cache[i]] = VertexScore(i, liveValence[cache[i]]);
+		}
+
+		// Only triangles touching a cached vertex can have changed score, so the next
+		// best triangle is searched for among those.
+		bestTri = -1;
+		bestScore = -1.0f;
+		for(int i = 0; i < cacheCount; ++i)
+		{
+			uint32 v = (uint32)cache[i];
+			for(uint32 a = adjOffset[v]; a < adjOffset[v] + liveValence[v]; ++a)
+			{
+				uint32 adj = adjTris[a];
+				const uint32* adjIndices = &indices[adj*3];
+
+				float score = vertexScore[adjIndices[0]] + vertexScore[adjIndices[1]] + vertexScore[adjIndices[2]];
+
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTri = (int)adj;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+MeshOptimizer::uint32 MeshOptimizer::OptimizeVertexFetch(MeshData& meshData)
+{
+	return OptimizeVertexFetch(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices);
+}
+
+MeshOptimizer::uint32 MeshOptimizer::WeldVertices(MeshData& meshData, WeldMode mode)
+{
+	if(!ValidateIndices(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices.size()))
+		return 0;
+
+	// 3 floats of position, or all 11 floats of the vertex.
+	if(mode == WeldMode::Position)
+		return WeldVerticesImpl<3>(meshData);
+
+	return WeldVerticesImpl<11>(meshData);
+}
+
+bool MeshOptimizer::ValidateIndices(const uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		if(indices[i] >= vertexCount)
+			return false;
+	}
+
+	return true;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize)
+{
+	return AnalyzeVertexCache(meshData.Indices32.data(), meshData.Indices32.size(),
+		meshData.Vertices.size(), cacheSize);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32* indices, size_t indexCount,
+	size_t vertexCount, uint32 cacheSize)
+{
+	VertexCacheStats stats;
+
+	const size_t triCount = indexCount / 3;
+	if(triCount == 0 || !ValidateIndices(indices, triCount*3, vertexCount))
+		return stats;
+
+	// A FIFO cache only needs to know when each vertex was last inserted.
+	std::vector<size_t> insertedAt(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+
+	size_t misses = 0;
+	size_t uniqueVerts = 0;
+
+	for(size_t i = 0; i < triCount*3; ++i)
+	{
+		uint32 v = indices[i];
+
+		if(!referenced[v])
+		{
+			referenced[v] = true;
+			++uniqueVerts;
+		}
+
+		// misses is the FIFO insertion counter, so an entry is resident for as long
+		// as fewer than cacheSize other vertices have been inserted after it.
+		if(insertedAt[v] == 0 || misses - insertedAt[v] + 1 > cacheSize)
+		{
+			++misses;
+			insertedAt[v] = misses;
+		}
+	}
+
+	stats.Acmr = (float)misses / triCount;
+	stats.Atvr = (float)misses / uniqueVerts;
+
+	return stats;
+}
@@ -0,0 +1,101 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// Offline passes that reorder GeometryGenerator::MeshData for the GPU.  None of them
+// change what is drawn, only the order the vertices and triangles are stored in.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <vector>
+
+// Post-transform vertex cache statistics for an index buffer.
+struct VertexCacheStats
+{
+	// Average cache misses per triangle.  0.5 is the ideal for large regular meshes,
+	// 3.0 means no vertex was ever reused.
+	float Acmr = 0.0f;
+
+	// Average times each referenced vertex is transformed.  1.0 is ideal.
+	float Atvr = 0.0f;
+};
+
+class MeshOptimizer
+{
+public:
+	using uint32 = GeometryGenerator::uint32;
+	using MeshData = GeometryGenerator::MeshData;
+
+	///<summary>
+	/// Reorders the triangles of a triangle list to maximize post-transform vertex
+	/// cache hits, using Tom Forsyth's linear-speed greedy scoring.  The vertex
+	/// buffer is left untouched.
+	///</summary>
+	static void OptimizeVertexCache(MeshData& meshData);
+	static void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Renumbers the vertices into the order the index buffer first references them,
+	/// remaps the indices to match and drops vertices nothing references.  Run it
+	/// after OptimizeVertexCache so vertex fetches walk the buffer front to back.
+	/// Returns the new vertex count.
+	///</summary>
+	static uint32 OptimizeVertexFetch(MeshData& meshData);
+
+	template<typename VertexT>
+	static uint32 OptimizeVertexFetch(uint32* indices, size_t indexCount, std::vector<VertexT>& vertices)
+	{
+		if(!ValidateIndices(indices, indexCount, vertices.size()))
+			return (uint32)vertices.size();
+
+		const uint32 unused = ~0u;
+		std::vector<uint32> remap(vertices.size(), unused);
+
+		uint32 next = 0;
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			uint32& r = remap[indices[i]];
+			if(r == unused)
+				r = next++;
+
+			indices[i] = r;
+		}
+
+		std::vector<VertexT> reordered(next);
+		for(size_t v = 0; v < vertices.size(); ++v)
+		{
+			if(remap[v] != unused)
+				reordered[remap[v]] = vertices[v];
+		}
+
+		vertices.swap(reordered);
+		return next;
+	}
+
+	enum class WeldMode
+	{
+		AllAttributes,
+		Position
+	};
+
+	///<summary>
+	/// Merges vertices that compare equal and remaps the indices onto the survivor.
+	/// WeldMode::Position compares positions only and keeps the attributes of the
+	/// first vertex at each position, which is what callers that only upload
+	/// positions want.  Returns the number of vertices removed.
+	///</summary>
+	static uint32 WeldVertices(MeshData& meshData, WeldMode mode = WeldMode::AllAttributes);
+
+	///<summary>
+	/// Returns true if every index refers to a vertex in [0, vertexCount).
+	///</summary>
+	static bool ValidateIndices(const uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Simulates a FIFO post-transform cache of the given size over the index buffer.
+	///</summary>
+	static VertexCacheStats AnalyzeVertexCache(const MeshData& meshData, uint32 cacheSize = 16);
+	static VertexCacheStats AnalyzeVertexCache(const uint32* indices, size_t indexCount,
+		size_t vertexCount, uint32 cacheSize = 16);
+};
@@ -0,0 +1,605 @@
+//***************************************************************************************
+// MeshSimplifier.cpp
+//***************************************************************************************
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshSimplifier::uint32;
+
+	// Boundary edges get a plane perpendicular to their face so open borders keep their
+	// outline.  The weight is relative to the edge length squared.
+	const double kBoundaryWeight = 10.0;
+
+	// A collapse may not turn any remaining triangle by more than about 75 degrees.
+	const float kMinNormalCosine = 0.25f;
+
+	// Symmetric 4x4 quadric, stored as the 3x3 block A, the vector b and the scalar c,
+	// plus the total weight of the planes added so the error is an average.  It only
+	// ranks collapses; the error reported is measured on the result.
+	struct Quadric
+	{
+		double A00 = 0.0, A01 = 0.0, A02 = 0.0, A11 = 0.0, A12 = 0.0, A22 = 0.0;
+		double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+		double C = 0.0;
+		double W = 0.0;
+
+		void AddPlane(double nx, double ny, double nz, double d, double weight)
+		{
+			A00 += weight*nx*nx; A01 += weight*nx*ny; A02 += weight*nx*nz;
+			A11 += weight*ny*ny; A12 += weight*ny*nz; A22 += weight*nz*nz;
+			B0 += weight*nx*d; B1 += weight*ny*d; B2 += weight*nz*d;
+			C += weight*d*d;
+			W += weight;
+		}
+
+		void Add(const Quadric& q)
+		{
+			A00 += q.A00; A01 += q.A01; A02 += q.A02;
+			A11 += q.A11; A12 += q.A12; A22 += q.A22;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2;
+			C += q.C;
+			W += q.W;
+		}
+
+		// Weighted mean squared distance from p to the planes.
+		double Evaluate(const XMFLOAT3& p)const
+		{
+			double x = p.x, y = p.y, z = p.z;
+
+			double r = A00*x*x + A11*y*y + A22*z*z
+				+ 2.0*(A01*x*y + A02*x*z + A12*y*z)
+				+ 2.0*(B0*x + B1*y + B2*z)
+				+ C;
+
+			return W > 0.0 ? fabs(r) / W : 0.0;
+		}
+	};
+
+	XMFLOAT3 TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		XMVECTOR v0 = XMLoadFloat3(&p0);
+		XMVECTOR n = XMVector3Cross(XMLoadFloat3(&p1) - v0, XMLoadFloat3(&p2) - v0);
+
+		XMFLOAT3 result;
+		XMStoreFloat3(&result, n);
+		return result;
+	}
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x*b.x + a.y*b.y + a.z*b.z;
+	}
+
+	// Distance from p to the triangle (a, b, c), from Ericson, Real-Time Collision
+	// Detection, 5.1.5.
+	float PointTriangleDistance(const XMFLOAT3& p, const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+	{
+		XMVECTOR vp = XMLoadFloat3(&p);
+		XMVECTOR va = XMLoadFloat3(&a);
+		XMVECTOR vb = XMLoadFloat3(&b);
+		XMVECTOR vc = XMLoadFloat3(&c);
+
+		XMVECTOR ab = vb - va;
+		XMVECTOR ac = vc - va;
+		XMVECTOR ap = vp - va;
+
+		auto dot = [](FXMVECTOR x, FXMVECTOR y) { return XMVectorGetX(XMVector3Dot(x, y)); };
+		auto distance = [&](FXMVECTOR q) { return XMVectorGetX(XMVector3Length(vp - q)); };
+
+		float d1 = dot(ab, ap);
+		float d2 = dot(ac, ap);
+		if(d1 <= 0.0f && d2 <= 0.0f)
+			return distance(va);
+
+		XMVECTOR bp = vp - vb;
+		float d3 = dot(ab, bp);
+		float d4 = dot(ac, bp);
+		if(d3 >= 0.0f && d4 <= d3)
+			return distance(vb);
+
+		float vc0 = d1*d4 - d3*d2;
+		if(vc0 <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return distance(va + ab*(d1 / (d1 - d3)));
+
+		XMVECTOR cp = vp - vc;
+		float d5 = dot(ab, cp);
+		float d6 = dot(ac, cp);
+		if(d6 >= 0.0f && d5 <= d6)
+			return distance(vc);
+
+		float vb0 = d5*d2 - d1*d6;
+		if(vb0 <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return distance(va + ac*(d2 / (d2 - d6)));
+
+		float va0 = d3*d6 - d5*d4;
+		if(va0 <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return distance(vb + (vc - vb)*((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+		float sum = va0 + vb0 + vc0;
+		if(sum == 0.0f)
+			return distance(va);
+
+		return distance(va + ab*(vb0 / sum) + ac*(vc0 / sum));
+	}
+
+	std::uint64_t EdgeKey(uint32 a, uint32 b)
+	{
+		return a < b ? ((std::uint64_t)a << 32) | b : ((std::uint64_t)b << 32) | a;
+	}
+
+	// Vertices sharing a position with another vertex sit on an attribute seam.
+	// Collapsing them would tear the seam open, so they are locked.
+	std::vector<bool> FindSeamVertices(const std::vector<GeometryGenerator::Vertex>& vertices)
+	{
+		std::vector<uint32> order(vertices.size());
+		for(uint32 v = 0; v < (uint32)vertices.size(); ++v)
+			order[v] = v;
+
+		auto less = [&](uint32 a, uint32 b)
+		{
+			const XMFLOAT3& pa = vertices[a].Position;
+			const XMFLOAT3& pb = vertices[b].Position;
+			if(pa.x != pb.x) return pa.x < pb.x;
+			if(pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		std::vector<bool> seam(vertices.size(), false);
+		for(size_t i = 1; i < order.size(); ++i)
+		{
+			if(!less(order[i - 1], order[i]))
+			{
+				seam[order[i - 1]] = true;
+				seam[order[i]] = true;
+			}
+		}
+
+		return seam;
+	}
+
+	struct Collapse
+	{
+		uint32 From;
+		uint32 To;
+		float Error;
+	};
+}
+
+std::vector<MeshSimplifier::uint32> MeshSimplifier::Simplify(const MeshData& meshData,
+	size_t targetIndexCount, float maxError, float* resultError)
+{
+	const std::vector<GeometryGenerator::Vertex>& vertices = meshData.Vertices;
+	const size_t vertexCount = vertices.size();
+
+	std::vector<uint32> indices(meshData.Indices32.begin(),
+		meshData.Indices32.begin() + meshData.Indices32.size() / 3 * 3);
+
+	if(resultError)
+		*resultError = 0.0f;
+
+	if(!MeshOptimizer::ValidateIndices(indices.data(), indices.size(), vertexCount))
+		return indices;
+
+	const std::vector<bool> locked = FindSeamVertices(vertices);
+
+	//
+	// Every vertex starts with the planes of the triangles around it, weighted by area.
+	//
+
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<XMFLOAT3> faceNormals(indices.size() / 3);
+
+	for(size_t t = 0; t < indices.size() / 3; ++t)
+	{
+		const XMFLOAT3& p0 = vertices[indices[t*3 + 0]].Position;
+		const XMFLOAT3& p1 = vertices[indices[t*3 + 1]].Position;
+		const XMFLOAT3& p2 = vertices[indices[t*3 + 2]].Position;
+
+		XMFLOAT3 n = TriangleNormal(p0, p1, p2);
+		float length = sqrtf(Dot(n, n));
+		if(length == 0.0f)
+		{
+			faceNormals[t] = n;
+			continue;
+		}
+
+		n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+		faceNormals[t] = n;
+
+		double d = -Dot(n, p0);
+		for(int k = 0; k < 3; ++k)
+			quadrics[indices[t*3 + k]].AddPlane(n.x, n.y, n.z, d, 0.5*length);
+	}
+
+	// Boundary planes.  Edges used by a single triangle are open borders.
+	{
+		std::vector<std::pair<std::uint64_t, uint32>> edges;
+		edges.reserve(indices.size());
+		for(uint32 t = 0; t < (uint32)indices.size() / 3; ++t)
+		{
+			for(int k = 0; k < 3; ++k)
+				edges.push_back(std::make_pair(EdgeKey(indices[t*3 + k], indices[t*3 + (k + 1) % 3]), t));
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for(size_t i = 0; i < edges.size(); ++i)
+		{
+			bool shared = (i > 0 && edges[i - 1].first == edges[i].first) ||
+				(i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+			if(shared)
+				continue;
+
+			uint32 a = (uint32)(edges[i].first >> 32);
+			uint32 b = (uint32)(edges[i].first & 0xffffffff);
+			const XMFLOAT3& pa = vertices[a].Position;
+			const XMFLOAT3& pb = vertices[b].Position;
+
+			XMVECTOR e = XMLoadFloat3(&pb) - XMLoadFloat3(&pa);
+			XMVECTOR n = XMVector3Normalize(XMVector3Cross(e, XMLoadFloat3(&faceNormals[edges[i].second])));
+
+			XMFLOAT3 plane;
+			XMStoreFloat3(&plane, n);
+			double weight = kBoundaryWeight * XMVectorGetX(XMVector3LengthSq(e));
+			double d = -Dot(plane, pa);
+
+			quadrics[a].AddPlane(plane.x, plane.y, plane.z, d, weight);
+			quadrics[b].AddPlane(plane.x, plane.y, plane.z, d, weight);
+		}
+	}
+
+	//
+	// Collapse in passes.  Each pass ranks every edge, then performs the cheapest
+	// collapses that do not touch a vertex already changed in the same pass.
+	//
+
+	const size_t targetTriCount = targetIndexCount / 3;
+	size_t triCount = indices.size() / 3;
+
+	// The vertex each removed vertex was collapsed onto.
+	std::vector<uint32> collapsedTo(vertexCount);
+	for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+		collapsedTo[v] = v;
+
+	std::vector<uint32> adjOffset(vertexCount + 1);
+	std::vector<uint32> adjTris;
+	std::vector<std::uint64_t> edges;
+	std::vector<std::uint64_t> boundaryEdges;
+	std::vector<bool> boundary(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<uint32> remap(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<uint32> neighbours;
+
+	while(triCount > targetTriCount)
+	{
+		// Vertex -> triangle adjacency of the current index buffer.
+		std::fill(adjOffset.begin(), adjOffset.end(), 0);
+		for(uint32 index : indices)
+			++adjOffset[index + 1];
+		for(size_t v = 0; v < vertexCount; ++v)
+			adjOffset[v + 1] += adjOffset[v];
+
+		adjTris.resize(indices.size());
+		{
+			std::vector<uint32> cursor(adjOffset.begin(), adjOffset.end() - 1);
+			for(uint32 t = 0; t < (uint32)triCount; ++t)
+			{
+				for(int k = 0; k < 3; ++k)
+					adjTris[cursor[indices[t*3 + k]]++] = t;
+			}
+		}
+
+		// Unique edges, and the ones on open borders.
+		edges.clear();
+		for(size_t t = 0; t < triCount; ++t)
+		{
+			for(int k = 0; k < 3; ++k)
+				edges.push_back(EdgeKey(indices[t*3 + k], indices[t*3 + (k + 1) % 3]));
+		}
+		std::sort(edges.begin(), edges.end());
+
+		boundaryEdges.clear();
+		std::fill(boundary.begin(), boundary.end(), false);
+		for(size_t i = 0; i < edges.size(); )
+		{
+			size_t j = i + 1;
+			while(j < edges.size() && edges[j] == edges[i])
+				++j;
+
+			if(j - i == 1)
+			{
+				boundaryEdges.push_back(edges[i]);
+				boundary[edges[i] >> 32] = true;
+				boundary[edges[i] & 0xffffffff] = true;
+			}
+			i = j;
+		}
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		// Border vertices may only slide along the border.
+		auto canCollapse = [&](uint32 from, uint32 to)
+		{
+			if(locked[from])
+				return false;
+
+			return !boundary[from] ||
+				std::binary_search(boundaryEdges.begin(), boundaryEdges.end(), EdgeKey(from, to));
+		};
+
+		collapses.clear();
+		for(std::uint64_t edge : edges)
+		{
+			uint32 a = (uint32)(edge >> 32);
+			uint32 b = (uint32)(edge & 0xffffffff);
+
+			Quadric q = quadrics[a];
+			q.Add(quadrics[b]);
+
+			Collapse best = { 0, 0, -1.0f };
+			if(canCollapse(a, b))
+				best = { a, b, (float)sqrt(q.Evaluate(vertices[b].Position)) };
+
+			if(canCollapse(b, a))
+			{
+				float e = (float)sqrt(q.Evaluate(vertices[a].Position));
+				if(best.Error < 0.0f || e < best.Error)
+					best = { b, a, e };
+			}
+
+			if(best.Error >= 0.0f && best.Error <= maxError)
+				collapses.push_back(best);
+		}
+
+		std::sort(collapses.begin(), collapses.end(),
+			[](const Collapse& x, const Collapse& y) { return x.Error < y.Error; });
+
+		std::fill(touched.begin(), touched.end(), false);
+		for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+			remap[v] = v;
+
+		size_t removedTris = 0;
+		size_t collapseCount = 0;
+
+		for(const Collapse& c : collapses)
+		{
+			if(triCount - removedTris <= targetTriCount)
+				break;
+
+			if(touched[c.From] || touched[c.To])
+				continue;
+
+			const uint32* fromBegin = &adjTris[adjOffset[c.From]];
+			const uint32* fromEnd = &adjTris[adjOffset[c.From + 1]];
+			const uint32* toBegin = &adjTris[adjOffset[c.To]];
+			const uint32* toEnd = &adjTris[adjOffset[c.To + 1]];
+
+			// Triangles using both vertices disappear, the others must not flip.
+			size_t sharedTris = 0;
+			bool flips = false;
+			for(const uint32* it = fromBegin; it != fromEnd && !flips; ++it)
+			{
+				const uint32* tri = &indices[*it*3];
+				if(tri[0] == c.To || tri[1] == c.To || tri[2] == c.To)
+				{
+					++sharedTris;
+					continue;
+				}
+
+				XMFLOAT3 p[3];
+				for(int k = 0; k < 3; ++k)
+					p[k] = vertices[tri[k]].Position;
+
+				XMFLOAT3 before = TriangleNormal(p[0], p[1], p[2]);
+				for(int k = 0; k < 3; ++k)
+				{
+					if(tri[k] == c.From)
+						p[k] = vertices[c.To].Position;
+				}
+				XMFLOAT3 after = TriangleNormal(p[0], p[1], p[2]);
+
+				float lengths = sqrtf(Dot(before, before) * Dot(after, after));
+				flips = lengths == 0.0f || Dot(before, after) < kMinNormalCosine*lengths;
+			}
+
+			if(flips)
+				continue;
+
+			// Link condition: the two vertices may only share the neighbours of the
+			// triangles that disappear, or the result is no longer a manifold.
+			neighbours.clear();
+			for(const uint32* it = fromBegin; it != fromEnd; ++it)
+			{
+				for(int k = 0; k < 3; ++k)
+					neighbours.push_back(indices[*it*3 + k]);
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+			size_t commonNeighbours = 0;
+			for(const uint32* it = toBegin; it != toEnd; ++it)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					uint32 v = indices[*it*3 + k];
+					if(v != c.From && v != c.To &&
+						std::binary_search(neighbours.begin(), neighbours.end(), v))
+					{
+						++commonNeighbours;
+					}
+				}
+			}
+
+			// Every neighbour is counted once per triangle around c.To it appears in,
+			// which is twice for the interior neighbours on a closed fan.
+			if(commonNeighbours > 2*sharedTris)
+				continue;
+
+			remap[c.From] = c.To;
+			collapsedTo[c.From] = c.To;
+			quadrics[c.To].Add(quadrics[c.From]);
+
+			for(const uint32* it = fromBegin; it != fromEnd; ++it)
+			{
+				for(int k = 0; k < 3; ++k)
+					touched[indices[*it*3 + k]] = true;
+			}
+			touched[c.To] = true;
+
+			removedTris += sharedTris;
+			++collapseCount;
+		}
+
+		if(collapseCount == 0)
+			break;
+
+		// Apply the collapses and drop the triangles that became degenerate.
+		size_t write = 0;
+		for(size_t t = 0; t < triCount; ++t)
+		{
+			uint32 i0 = remap[indices[t*3 + 0]];
+			uint32 i1 = remap[indices[t*3 + 1]];
+			uint32 i2 = remap[indices[t*3 + 2]];
+
+			if(i0 == i1 || i1 == i2 || i0 == i2)
+				continue;
+
+			indices[write++] = i0;
+			indices[write++] = i1;
+			indices[write++] = i2;
+		}
+
+		indices.resize(write);
+		triCount = write / 3;
+	}
+
+	//
+	// The error is the largest distance from a removed vertex to the simplified
+	// surface.  The triangles around the vertices its source neighbours ended up on
+	// give an upper bound, and only a bound above the largest distance so far needs
+	// the search over every triangle.
+	//
+
+	if(resultError)
+	{
+		auto buildAdjacency = [&](const uint32* triIndices, size_t count,
+			std::vector<uint32>& offsets, std::vector<uint32>& tris)
+		{
+			offsets.assign(vertexCount + 1, 0);
+			for(size_t i = 0; i < count; ++i)
+				++offsets[triIndices[i] + 1];
+			for(size_t v = 0; v < vertexCount; ++v)
+				offsets[v + 1] += offsets[v];
+
+			tris.resize(count);
+			std::vector<uint32> cursor(offsets.begin(), offsets.end() - 1);
+			for(uint32 t = 0; t < (uint32)(count / 3); ++t)
+			{
+				for(int k = 0; k < 3; ++k)
+					tris[cursor[triIndices[t*3 + k]]++] = t;
+			}
+		};
+
+		const uint32* sourceIndices = meshData.Indices32.data();
+		std::vector<uint32> sourceOffset;
+		std::vector<uint32> sourceTris;
+		buildAdjacency(sourceIndices, meshData.Indices32.size() / 3 * 3, sourceOffset, sourceTris);
+		buildAdjacency(indices.data(), indices.size(), adjOffset, adjTris);
+
+		for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+		{
+			uint32 to = collapsedTo[v];
+			while(collapsedTo[to] != to)
+				to = collapsedTo[to];
+			collapsedTo[v] = to;
+		}
+
+		float error = 0.0f;
+		for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+		{
+			if(collapsedTo[v] == v)
+				continue;
+
+			const XMFLOAT3& p = vertices[v].Position;
+			float distance = XMVectorGetX(XMVector3Length(
+				XMLoadFloat3(&p) - XMLoadFloat3(&vertices[collapsedTo[v]].Position)));
+
+			for(uint32 i = sourceOffset[v]; i < sourceOffset[v + 1]; ++i)
+			{
+				for(int k = 0; k < 3; ++k)
+				{
+					uint32 to = collapsedTo[sourceIndices[sourceTris[i]*3 + k]];
+					for(uint32 j = adjOffset[to]; j < adjOffset[to + 1]; ++j)
+					{
+						const uint32* tri = &indices[adjTris[j]*3];
+						distance = std::min(distance, PointTriangleDistance(p,
+							vertices[tri[0]].Position, vertices[tri[1]].Position, vertices[tri[2]].Position));
+					}
+				}
+			}
+
+			if(distance > error)
+			{
+				for(size_t t = 0; t < indices.size(); t += 3)
+				{
+					distance = std::min(distance, PointTriangleDistance(p,
+						vertices[indices[t]].Position, vertices[indices[t + 1]].Position, vertices[indices[t + 2]].Position));
+				}
+
+				error = std::max(error, distance);
+			}
+		}
+
+		*resultError = error;
+	}
+
+	return indices;
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLodChain(const MeshData& meshData, uint32 lodCount,
+	float maxError, float reduction)
+{
+	std::vector<MeshLod> lods;
+
+	size_t previousIndexCount = meshData.Indices32.size();
+	for(uint32 level = 0; level < lodCount; ++level)
+	{
+		// Each level is simplified from the source mesh so its error is measured
+		// against the real surface rather than the previous approximation.
+		size_t targetIndexCount = (size_t)(previousIndexCount*reduction);
+
+		MeshLod lod;
+		lod.Mesh.Indices32 = Simplify(meshData, targetIndexCount, maxError, &lod.Error);
+
+		// maxError only limits each collapse's quadric estimate, so the measured error
+		// can still be over it.  Back off towards the previous level until it is not.
+		while(lod.Error > maxError && targetIndexCount < previousIndexCount*9/10)
+		{
+			targetIndexCount = (targetIndexCount + previousIndexCount) / 2;
+			lod.Mesh.Indices32 = Simplify(meshData, targetIndexCount, maxError, &lod.Error);
+		}
+
+		// Not worth a level of its own, or too far from the source.
+		if(lod.Mesh.Indices32.empty() || lod.Mesh.Indices32.size() > previousIndexCount*9/10 ||
+			lod.Error > maxError)
+		{
+			break;
+		}
+
+		lod.Mesh.Vertices = meshData.Vertices;
+		MeshOptimizer::OptimizeVertexCache(lod.Mesh);
+		MeshOptimizer::OptimizeVertexFetch(lod.Mesh);
+
+		previousIndexCount = lod.Mesh.Indices32.size();
+		lods.push_back(std::move(lod));
+	}
+
+	return lods;
+}
@@ -0,0 +1,52 @@
+//***************************************************************************************
+// MeshSimplifier.h
+//
+// Quadric error edge collapse simplification of GeometryGenerator::MeshData, used to
+// build level of detail chains for the generated shapes.
+//
+// Vertices are only ever collapsed onto one of their neighbours, so every LOD uses a
+// subset of the original vertices and keeps their attributes.  Vertices that share a
+// position with another vertex (texture seams, hard edges) are never moved, so weld
+// the mesh first if only positions matter.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <vector>
+
+// One level of a LOD chain.
+struct MeshLod
+{
+	GeometryGenerator::MeshData Mesh;
+
+	// Largest object space distance from a source vertex to the simplified surface.
+	float Error = 0.0f;
+};
+
+class MeshSimplifier
+{
+public:
+	using uint32 = GeometryGenerator::uint32;
+	using MeshData = GeometryGenerator::MeshData;
+
+	///<summary>
+	/// Collapses edges in order of increasing quadric error until the mesh has at most
+	/// targetIndexCount indices or the next collapse has a root mean square quadric
+	/// error above maxError.  Returns the simplified index buffer, which still indexes
+	/// the source vertices, and writes the largest distance from a source vertex to the
+	/// simplified surface to resultError if given.
+	///</summary>
+	static std::vector<uint32> Simplify(const MeshData& meshData, size_t targetIndexCount,
+		float maxError, float* resultError = nullptr);
+
+	///<summary>
+	/// Builds up to lodCount simplified versions of the mesh, each with about
+	/// reduction times the triangles of the previous one, fewer if that would take its
+	/// measured error over maxError.  The chain stops early once a level cannot be
+	/// reduced any further within maxError.  Each level is compacted to its own
+	/// vertices and optimized for the vertex cache.
+	///</summary>
+	static std::vector<MeshLod> BuildLodChain(const MeshData& meshData, uint32 lodCount,
+		float maxError, float reduction = 0.5f);
+};
@@ -0,0 +1,238 @@
+//***************************************************************************************
+// MeshletBuilder.cpp
+//***************************************************************************************
+
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	using uint32 = MeshletBuilder::uint32;
+
+	XMVECTOR TriangleCentroid(const GeometryGenerator::MeshData& meshData, uint32 tri)
+	{
+		const uint32* indices = &meshData.Indices32[tri*3];
+
+		XMVECTOR sum = XMLoadFloat3(&meshData.Vertices[indices[0]].Position);
+		sum += XMLoadFloat3(&meshData.Vertices[indices[1]].Position);
+		sum += XMLoadFloat3(&meshData.Vertices[indices[2]].Position);
+
+		return sum / 3.0f;
+	}
+
+	void ComputeMeshletBounds(Meshlet& meshlet, const GeometryGenerator::MeshData& meshData,
+		const std::vector<uint32>& vertices, const std::vector<uint32>& triangles)
+	{
+		std::vector<XMFLOAT3> points(vertices.size());
+		for(size_t i = 0; i < vertices.size(); ++i)
+			points[i] = meshData.Vertices[vertices[i]].Position;
+
+		BoundingSphere sphere;
+		BoundingSphere::CreateFromPoints(sphere, points.size(), points.data(), sizeof(XMFLOAT3));
+		meshlet.Center = sphere.Center;
+		meshlet.Radius = sphere.Radius;
+
+		//
+		// Normal cone: the average face normal is the axis, the widest normal from it
+		// gives the half angle.
+		//
+
+		std::vector<XMVECTOR> normals;
+		normals.reserve(triangles.size());
+
+		XMVECTOR axis = XMVectorZero();
+		for(uint32 t : triangles)
+		{
+			const uint32* tri = &meshData.Indices32[t*3];
+			XMVECTOR p0 = XMLoadFloat3(&meshData.Vertices[tri[0]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&meshData.Vertices[tri[1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&meshData.Vertices[tri[2]].Position);
+
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			if(XMVectorGetX(XMVector3LengthSq(n)) == 0.0f)
+				continue;
+
+			n = XMVector3Normalize(n);
+			normals.push_back(n);
+			axis += n;
+		}
+
+		meshlet.ConeCutoff = 1.0f;
+		if(normals.empty() || XMVectorGetX(XMVector3LengthSq(axis)) == 0.0f)
+			return;
+
+		// Measure the cone from the quantized axis, so the culling test, which reads
+		// that axis back, stays conservative.
+		XMStoreByteN4(&meshlet.ConeAxis, XMVector3Normalize(axis));
+		axis = XMVector3Normalize(XMLoadByteN4(&meshlet.ConeAxis));
+
+		float minDot = 1.0f;
+		for(const XMVECTOR& n : normals)
+			minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, n)));
+
+		// A cone of 90 degrees or more always has a triangle facing the eye.
+		if(minDot > 0.0f)
+			meshlet.ConeCutoff = sqrtf(1.0f - minDot*minDot);
+	}
+}
+
+std::vector<Meshlet> MeshletBuilder::Build(MeshData& meshData, uint32 maxVertices, uint32 maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+
+	std::vector<uint32>& indices = meshData.Indices32;
+	const uint32 triCount = (uint32)(indices.size() / 3);
+	const size_t vertexCount = meshData.Vertices.size();
+
+	// Meshlet::IndexCount is 16 bits.
+	maxTriangles = std::min(maxTriangles, 0xffffu / 3);
+
+	if(triCount == 0 || maxVertices < 3 || maxTriangles == 0 ||
+		!MeshOptimizer::ValidateIndices(indices.data(), triCount*3, vertexCount))
+	{
+		return meshlets;
+	}
+
+	// Vertex -> triangle adjacency as one flat array with per vertex offsets.
+	std::vector<uint32> adjOffset(vertexCount + 1, 0);
+	for(size_t i = 0; i < triCount*3; ++i)
+		++adjOffset[indices[i] + 1];
+	for(size_t v = 0; v < vertexCount; ++v)
+		adjOffset[v + 1] += adjOffset[v];
+
+	std::vector<uint32> adjTris(triCount*3);
+	{
+		std::vector<uint32> cursor(adjOffset.begin(), adjOffset.end() - 1);
+		for(uint32 t = 0; t < triCount; ++t)
+		{
+			for(uint32 k = 0; k < 3; ++k)
+				adjTris[cursor[indices[t*3 + k]]++] = t;
+		}
+	}
+
+	std::vector<bool> emitted(triCount, false);
+
+	// Index of the meshlet each vertex was last added to.
+	std::vector<uint32> vertexMeshlet(vertexCount, ~0u);
+
+	std::vector<uint32> meshletVertices;
+	std::vector<uint32> meshletTriangles;
+	meshletVertices.reserve(maxVertices);
+	meshletTriangles.reserve(maxTriangles);
+
+	std::vector<uint32> output;
+	output.reserve(triCount*3);
+
+	uint32 scanCursor = 0;
+	while(output.size() < triCount*3)
+	{
+		const uint32 id = (uint32)meshlets.size();
+		meshletVertices.clear();
+		meshletTriangles.clear();
+
+		// Seed each meshlet with the first triangle not yet taken.
+		while(emitted[scanCursor])
+			++scanCursor;
+
+		uint32 next = scanCursor;
+		XMVECTOR vertexSum = XMVectorZero();
+
+		for(;;)
+		{
+			emitted[next] = true;
+			meshletTriangles.push_back(next);
+
+			for(uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[next*3 + k];
+				if(vertexMeshlet[v] != id)
+				{
+					vertexMeshlet[v] = id;
+					meshletVertices.push_back(v);
+					vertexSum += XMLoadFloat3(&meshData.Vertices[v].Position);
+				}
+			}
+
+			if(meshletTriangles.size() == maxTriangles)
+				break;
+
+			// Grow across the meshlet's own vertices: prefer triangles that add the
+			// fewest new vertices, then the ones closest to the meshlet's centre.
+			XMVECTOR centroid = vertexSum / (float)meshletVertices.size();
+
+			int best = -1;
+			uint32 bestNewVertices = 4;
+			float bestDistance = FLT_MAX;
+
+			for(uint32 v : meshletVertices)
+			{
+				for(uint32 a = adjOffset[v]; a < adjOffset[v + 1]; ++a)
+				{
+					uint32 t = adjTris[a];
+					if(emitted[t])
+						continue;
+
+					uint32 newVertices = 0;
+					for(uint32 k = 0; k < 3; ++k)
+					{
+						if(vertexMeshlet[indices[t*3 + k]] != id)
+							++newVertices;
+					}
+
+					if(meshletVertices.size() + newVertices > maxVertices || newVertices > bestNewVertices)
+						continue;
+
+					float distance = XMVectorGetX(XMVector3LengthSq(TriangleCentroid(meshData, t) - centroid));
+					if(newVertices < bestNewVertices || distance < bestDistance)
+					{
+						best = (int)t;
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+					}
+				}
+			}
+
+			if(best < 0)
+				break;
+
+			next = (uint32)best;
+		}
+
+		Meshlet meshlet;
+		meshlet.StartIndex = (uint32)output.size();
+		meshlet.IndexCount = (GeometryGenerator::uint16)(meshletTriangles.size()*3);
+		meshlet.VertexCount = (GeometryGenerator::uint16)meshletVertices.size();
+		ComputeMeshletBounds(meshlet, meshData, meshletVertices, meshletTriangles);
+
+		for(uint32 t : meshletTriangles)
+		{
+			output.push_back(indices[t*3 + 0]);
+			output.push_back(indices[t*3 + 1]);
+			output.push_back(indices[t*3 + 2]);
+		}
+
+		meshlets.push_back(meshlet);
+	}
+
+	indices.swap(output);
+
+	return meshlets;
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& meshlet, FXMVECTOR eyePos)
+{
+	// Conservative test against the whole bounding sphere: the eye must be behind
+	// every plane whose normal lies inside the cone.
+	XMVECTOR toCenter = XMLoadFloat3(&meshlet.Center) - eyePos;
+	float distance = XMVectorGetX(XMVector3Length(toCenter));
+	XMVECTOR axis = XMVector3Normalize(XMLoadByteN4(&meshlet.ConeAxis));
+
+	return XMVectorGetX(XMVector3Dot(toCenter, axis)) >=
+		meshlet.ConeCutoff*distance + meshlet.Radius;
+}
@@ -0,0 +1,61 @@
+//***************************************************************************************
+// MeshletBuilder.h
+//
+// Splits GeometryGenerator::MeshData into meshlets: small clusters of adjacent
+// triangles with a bounded number of vertices, each with its own bounds and normal
+// cone so a big mesh can be culled a piece at a time.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <DirectXPackedVector.h>
+#include <vector>
+
+// A meshlet is a contiguous range of the mesh's index buffer.  32 bytes.
+struct Meshlet
+{
+	// Range of the meshlet's triangles in the index buffer, in indices.
+	GeometryGenerator::uint32 StartIndex = 0;
+	GeometryGenerator::uint16 IndexCount = 0;
+
+	// Number of distinct vertices the triangles reference.
+	GeometryGenerator::uint16 VertexCount = 0;
+
+	// Object space bounding sphere.
+	DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+
+	// Every triangle normal is within the cone around ConeAxis, stored as snorm8 with w
+	// unused.  ConeCutoff is the sine of the cone's half angle around the axis as it
+	// reads back, or 1 if the normals are too spread out to ever cull.
+	DirectX::PackedVector::XMBYTEN4 ConeAxis = {};
+	float ConeCutoff = 1.0f;
+};
+
+static_assert(sizeof(Meshlet) == 32, "Meshlet should stay 32 bytes");
+
+class MeshletBuilder
+{
+public:
+	using uint32 = GeometryGenerator::uint32;
+	using MeshData = GeometryGenerator::MeshData;
+
+	static const uint32 DefaultMaxVertices = 64;
+	static const uint32 DefaultMaxTriangles = 124;
+
+	///<summary>
+	/// Groups the triangles into meshlets of at most maxVertices distinct vertices and
+	/// maxTriangles triangles, growing each one across shared edges.  The index buffer
+	/// is reordered so every meshlet's triangles are contiguous; the vertex buffer is
+	/// left untouched.
+	///</summary>
+	static std::vector<Meshlet> Build(MeshData& meshData,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles);
+
+	///<summary>
+	/// Returns true if every triangle of the meshlet faces away from eyePos.  The eye
+	/// position must be in the same space as the mesh.
+	///</summary>
+	static bool IsBackfacing(const Meshlet& meshlet, DirectX::FXMVECTOR eyePos);
+};
@@ -0,0 +1,368 @@
+//***************************************************************************************
+// OcclusionCuller.cpp
+//***************************************************************************************
+
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = OcclusionCuller::uint32;
+
+	// Signed distance to the near plane, z >= 0 in clip space.
+	inline float NearDistance(const XMFLOAT4& v)
+	{
+		return v.z;
+	}
+
+	XMFLOAT4 Lerp(const XMFLOAT4& a, const XMFLOAT4& b, float t)
+	{
+		return XMFLOAT4(a.x + (b.x - a.x)*t, a.y + (b.y - a.y)*t, a.z + (b.z - a.z)*t, a.w + (b.w - a.w)*t);
+	}
+}
+
+void OcclusionCuller::Resize(uint32 width, uint32 height)
+{
+	mTilesX = std::max(1u, (width + kTileWidth - 1) / kTileWidth);
+	mTilesY = std::max(1u, (height + kTileHeight - 1) / kTileHeight);
+	mWidth = mTilesX*kTileWidth;
+	mHeight = mTilesY*kTileHeight;
+
+	for(uint32 level = 0; level < kLevelCount; ++level)
+		mLevels[level].assign((mWidth >> level)*(mHeight >> level), 1.0f);
+
+	mTileBins.assign(mTilesX*mTilesY, std::vector<uint32>());
+}
+
+OcclusionCuller::uint32 OcclusionCuller::GetWidth()const
+{
+	return mWidth;
+}
+
+OcclusionCuller::uint32 OcclusionCuller::GetHeight()const
+{
+	return mHeight;
+}
+
+void OcclusionCuller::BeginFrame(FXMMATRIX viewProj)
+{
+	XMStoreFloat4x4(&mViewProj, viewProj);
+
+	mTriangles.clear();
+	for(std::vector<uint32>& bin : mTileBins)
+		bin.clear();
+}
+
+void OcclusionCuller::AddOccluder(const XMFLOAT3* positions, size_t stride,
+	const uint16* indices, size_t indexCount, FXMMATRIX world)
+{
+	AddIndexedOccluder(positions, stride, indices, indexCount, world);
+}
+
+void OcclusionCuller::AddOccluder(const XMFLOAT3* positions, size_t stride,
+	const uint32* indices, size_t indexCount, FXMMATRIX world)
+{
+	AddIndexedOccluder(positions, stride, indices, indexCount, world);
+}
+
+template<typename Index>
+void OcclusionCuller::AddIndexedOccluder(const XMFLOAT3* positions, size_t stride,
+	const Index* indices, size_t indexCount, FXMMATRIX world)
+{
+	XMMATRIX worldViewProj = XMMatrixMultiply(world, XMLoadFloat4x4(&mViewProj));
+
+	auto position = [&](Index index)
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + index*stride);
+	};
+
+	for(size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		XMFLOAT4 clip[3];
+		for(int k = 0; k < 3; ++k)
+		{
+			XMFLOAT3 p = position(indices[i + k]);
+			XMStoreFloat4(&clip[k], XMVector4Transform(XMVectorSet(p.x, p.y, p.z, 1.0f), worldViewProj));
+		}
+
+		// Entirely outside one plane of the frustum.
+		bool outside = false;
+		outside |= clip[0].x > clip[0].w && clip[1].x > clip[1].w && clip[2].x > clip[2].w;
+		outside |= clip[0].x < -clip[0].w && clip[1].x < -clip[1].w && clip[2].x < -clip[2].w;
+		outside |= clip[0].y > clip[0].w && clip[1].y > clip[1].w && clip[2].y > clip[2].w;
+		outside |= clip[0].y < -clip[0].w && clip[1].y < -clip[1].w && clip[2].y < -clip[2].w;
+		outside |= clip[0].z > clip[0].w && clip[1].z > clip[1].w && clip[2].z > clip[2].w;
+		if(outside)
+			continue;
+
+		//
+		// Clip against the near plane, which leaves a polygon of up to four vertices.
+		// The other planes are handled by clamping to the screen when rasterizing.
+		//
+
+		XMFLOAT4 polygon[4];
+		int polygonCount = 0;
+		for(int k = 0; k < 3; ++k)
+		{
+			const XMFLOAT4& a = clip[k];
+			const XMFLOAT4& b = clip[(k + 1) % 3];
+			float da = NearDistance(a);
+			float db = NearDistance(b);
+
+			if(da >= 0.0f)
+				polygon[polygonCount++] = a;
+			if((da >= 0.0f) != (db >= 0.0f))
+				polygon[polygonCount++] = Lerp(a, b, da / (da - db));
+		}
+
+		for(int k = 1; k + 1 < polygonCount; ++k)
+		{
+			XMFLOAT4 tri[3] = { polygon[0], polygon[k], polygon[k + 1] };
+			AddTriangle(tri);
+		}
+	}
+}
+
+void OcclusionCuller::AddTriangle(const XMFLOAT4 clip[3])
+{
+	Triangle tri;
+	for(int k = 0; k < 3; ++k)
+	{
+		float invW = 1.0f / clip[k].w;
+		tri.X[k] = (clip[k].x*invW*0.5f + 0.5f)*mWidth;
+		tri.Y[k] = (0.5f - clip[k].y*invW*0.5f)*mHeight;
+		tri.Z[k] = clip[k].z*invW;
+	}
+
+	// Clockwise triangles are front facing.  With y pointing down they have a
+	// positive signed area.
+	float area = (tri.X[1] - tri.X[0])*(tri.Y[2] - tri.Y[0]) - (tri.X[2] - tri.X[0])*(tri.Y[1] - tri.Y[0]);
+	if(!(area > 0.0f))
+		return;
+
+	float minX = std::min(tri.X[0], std::min(tri.X[1], tri.X[2]));
+	float maxX = std::max(tri.X[0], std::max(tri.X[1], tri.X[2]));
+	float minY = std::min(tri.Y[0], std::min(tri.Y[1], tri.Y[2]));
+	float maxY = std::max(tri.Y[0], std::max(tri.Y[1], tri.Y[2]));
+
+	if(maxX <= 0.0f || maxY <= 0.0f || minX >= (float)mWidth || minY >= (float)mHeight)
+		return;
+
+	// Clamp before converting, vertices near the near plane can land far off screen.
+	int tileX0 = (int)std::max(minX, 0.0f) / (int)kTileWidth;
+	int tileY0 = (int)std::max(minY, 0.0f) / (int)kTileHeight;
+	int tileX1 = std::min((int)mTilesX - 1, (int)std::min(maxX, (float)mWidth) / (int)kTileWidth);
+	int tileY1 = std::min((int)mTilesY - 1, (int)std::min(maxY, (float)mHeight) / (int)kTileHeight);
+
+	uint32 triIndex = (uint32)mTriangles.size();
+	mTriangles.push_back(tri);
+
+	for(int ty = tileY0; ty <= tileY1; ++ty)
+	{
+		for(int tx = tileX0; tx <= tileX1; ++tx)
+			mTileBins[ty*mTilesX + tx].push_back(triIndex);
+	}
+}
+
+void OcclusionCuller::Rasterize(ThreadPool* pool)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const size_t tileCount = mTileBins.size();
+	if(pool != nullptr)
+	{
+		pool->ParallelFor(tileCount, [this](size_t tile) { RasterizeTile((uint32)tile); });
+	}
+	else
+	{
+		for(size_t tile = 0; tile < tileCount; ++tile)
+			RasterizeTile((uint32)tile);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	mRasterizeMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void OcclusionCuller::RasterizeTile(uint32 tile)
+{
+	const int tileX0 = (int)((tile % mTilesX)*kTileWidth);
+	const int tileY0 = (int)((tile / mTilesX)*kTileHeight);
+	const int tileX1 = tileX0 + (int)kTileWidth;
+	const int tileY1 = tileY0 + (int)kTileHeight;
+
+	float* depth = mLevels[0].data();
+
+	for(int y = tileY0; y < tileY1; ++y)
+		std::fill(depth + y*mWidth + tileX0, depth + y*mWidth + tileX1, 1.0f);
+
+	const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR zero = XMVectorZero();
+
+	for(uint32 triIndex : mTileBins[tile])
+	{
+		const Triangle& tri = mTriangles[triIndex];
+
+		//
+		// Edge k runs from vertex k to vertex k + 1; E(x, y) = A*x + B*y + C is
+		// positive on the triangle's side.  Depth is the plane through the three
+		// vertices, evaluated at pixel centres.
+		//
+
+		float a[3], b[3], c[3];
+		for(int k = 0; k < 3; ++k)
+		{
+			int n = (k + 1) % 3;
+			a[k] = tri.Y[k] - tri.Y[n];
+			b[k] = tri.X[n] - tri.X[k];
+			c[k] = -(a[k]*tri.X[k] + b[k]*tri.Y[k]);
+		}
+
+		float x10 = tri.X[1] - tri.X[0], y10 = tri.Y[1] - tri.Y[0], z10 = tri.Z[1] - tri.Z[0];
+		float x20 = tri.X[2] - tri.X[0], y20 = tri.Y[2] - tri.Y[0], z20 = tri.Z[2] - tri.Z[0];
+		float invArea = 1.0f / (x10*y20 - x20*y10);
+		float dzdx = (z10*y20 - z20*y10)*invArea;
+		float dzdy = (z20*x10 - z10*x20)*invArea;
+		float z0 = tri.Z[0] - dzdx*tri.X[0] - dzdy*tri.Y[0];
+
+		float minX = std::max((float)tileX0, std::min(tri.X[0], std::min(tri.X[1], tri.X[2])));
+		float maxX = std::min((float)tileX1, std::max(tri.X[0], std::max(tri.X[1], tri.X[2])));
+		float minY = std::max((float)tileY0, std::min(tri.Y[0], std::min(tri.Y[1], tri.Y[2])));
+		float maxY = std::min((float)tileY1, std::max(tri.Y[0], std::max(tri.Y[1], tri.Y[2])));
+
+		// Rows and groups of four columns covering the triangle within the tile.
+		int x0 = (int)floorf(minX) & ~3;
+		int x1 = (int)ceilf(maxX);
+		int y0 = (int)floorf(minY);
+		int y1 = (int)ceilf(maxY);
+
+		XMVECTOR a0 = XMVectorReplicate(a[0]), a1 = XMVectorReplicate(a[1]), a2 = XMVectorReplicate(a[2]);
+		XMVECTOR dzdxV = XMVectorReplicate(dzdx);
+
+		for(int y = y0; y < y1; ++y)
+		{
+			float py = (float)y + 0.5f;
+
+			XMVECTOR rowE0 = XMVectorReplicate(b[0]*py + c[0]);
+			XMVECTOR rowE1 = XMVectorReplicate(b[1]*py + c[1]);
+			XMVECTOR rowE2 = XMVectorReplicate(b[2]*py + c[2]);
+			XMVECTOR rowZ = XMVectorReplicate(dzdy*py + z0);
+
+			float* row = depth + y*mWidth;
+
+			for(int x = x0; x < x1; x += 4)
+			{
+				XMVECTOR px = XMVectorAdd(XMVectorReplicate((float)x), laneOffsets);
+
+				XMVECTOR e0 = XMVectorMultiplyAdd(a0, px, rowE0);
+				XMVECTOR e1 = XMVectorMultiplyAdd(a1, px, rowE1);
+				XMVECTOR e2 = XMVectorMultiplyAdd(a2, px, rowE2);
+
+				XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero),
+					XMVectorAndInt(XMVectorGreaterOrEqual(e1, zero), XMVectorGreaterOrEqual(e2, zero)));
+
+				XMVECTOR z = XMVectorMultiplyAdd(dzdxV, px, rowZ);
+
+				XMFLOAT4* pixels = reinterpret_cast<XMFLOAT4*>(row + x);
+				XMVECTOR current = XMLoadFloat4(pixels);
+				XMStoreFloat4(pixels, XMVectorSelect(current, XMVectorMin(current, z), inside));
+			}
+		}
+	}
+
+	//
+	// Build this tile's part of the pyramid.  Each texel keeps the farthest of the
+	// four below it, so a box nearer than a texel is nearer than every pixel in it.
+	//
+
+	for(uint32 level = 1; level < kLevelCount; ++level)
+	{
+		const uint32 srcWidth = mWidth >> (level - 1);
+		const uint32 dstWidth = mWidth >> level;
+		const float* src = mLevels[level - 1].data();
+		float* dst = mLevels[level].data();
+
+		for(uint32 y = (uint32)tileY0 >> level; y < ((uint32)tileY1 >> level); ++y)
+		{
+			for(uint32 x = (uint32)tileX0 >> level; x < ((uint32)tileX1 >> level); ++x)
+			{
+				const float* s = src + (y*2)*srcWidth + x*2;
+				dst[y*dstWidth + x] = std::max(std::max(s[0], s[1]), std::max(s[srcWidth], s[srcWidth + 1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& worldBox)const
+{
+	XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+
+	XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+	worldBox.GetCorners(corners);
+
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for(const XMFLOAT3& corner : corners)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSet(corner.x, corner.y, corner.z, 1.0f), viewProj));
+
+		if(clip.z < 0.0f)
+			return true;
+
+		float invW = 1.0f / clip.w;
+		float x = (clip.x*invW*0.5f + 0.5f)*mWidth;
+		float y = (0.5f - clip.y*invW*0.5f)*mHeight;
+
+		minX = std::min(minX, x); maxX = std::max(maxX, x);
+		minY = std::min(minY, y); maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z*invW);
+	}
+
+	minX = std::max(minX, 0.0f);
+	minY = std::max(minY, 0.0f);
+	maxX = std::min(maxX, (float)mWidth);
+	maxY = std::min(maxY, (float)mHeight);
+
+	int x0 = (int)floorf(minX);
+	int y0 = (int)floorf(minY);
+	int x1 = std::min((int)mWidth - 1, (int)ceilf(maxX) - 1);
+	int y1 = std::min((int)mHeight - 1, (int)ceilf(maxY) - 1);
+
+	if(x0 > x1 || y0 > y1)
+		return true;
+
+	// Coarsest level where the box covers at most 4 x 4 texels.
+	uint32 level = 0;
+	while(level + 1 < kLevelCount && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+		++level;
+
+	const uint32 levelWidth = mWidth >> level;
+	const float* depth = mLevels[level].data();
+
+	for(int y = y0 >> level; y <= (y1 >> level); ++y)
+	{
+		for(int x = x0 >> level; x <= (x1 >> level); ++x)
+		{
+			if(depth[y*levelWidth + x] >= minZ)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+size_t OcclusionCuller::GetTriangleCount()const
+{
+	return mTriangles.size();
+}
+
+double OcclusionCuller::GetRasterizeMs()const
+{
+	return mRasterizeMs;
+}
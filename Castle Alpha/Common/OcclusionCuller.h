@@ -0,0 +1,114 @@
+//***************************************************************************************
+// OcclusionCuller.h
+//
+// Software occlusion culling.  A few large occluder meshes are rasterized on the CPU
+// into a small depth buffer every frame, then the bounding boxes of other objects are
+// tested against a max depth pyramid built from it.
+//
+// The screen is split into tiles that are rasterized independently, four pixels at a
+// time, so the work spreads across a ThreadPool.  Depth follows the D3D convention of
+// 0 at the near plane and 1 at the far plane.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+class OcclusionCuller
+{
+public:
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	static const uint32 kTileWidth = 32;
+	static const uint32 kTileHeight = 32;
+
+	// Levels of the depth pyramid; the last has one texel per tile.
+	static const uint32 kLevelCount = 6;
+
+	///<summary>
+	/// Sets the depth buffer size, rounded up to whole tiles.  A few hundred pixels
+	/// wide is plenty; the buffer only needs to resolve large occluders.
+	///</summary>
+	void Resize(uint32 width, uint32 height);
+
+	uint32 GetWidth()const;
+	uint32 GetHeight()const;
+
+	///<summary>
+	/// Starts a frame seen through viewProj, dropping last frame's occluders.
+	///</summary>
+	void BeginFrame(DirectX::FXMMATRIX viewProj);
+
+	///<summary>
+	/// Queues a triangle list for rasterization.  positions points at the first vertex
+	/// the indices refer to, with stride bytes between vertices, so the position of an
+	/// interleaved vertex buffer can be passed directly.  Triangles are clipped to the
+	/// near plane; back faces (counter-clockwise on screen) are dropped, so occluders
+	/// should be closed meshes.
+	///</summary>
+	void AddOccluder(const DirectX::XMFLOAT3* positions, size_t stride,
+		const uint16* indices, size_t indexCount, DirectX::FXMMATRIX world);
+	void AddOccluder(const DirectX::XMFLOAT3* positions, size_t stride,
+		const uint32* indices, size_t indexCount, DirectX::FXMMATRIX world);
+
+	///<summary>
+	/// Rasterizes the queued occluders and builds the depth pyramid, one tile per
+	/// ThreadPool piece.  pool may be null to run on the calling thread.
+	///</summary>
+	void Rasterize(ThreadPool* pool);
+
+	///<summary>
+	/// Returns false if worldBox is entirely behind the rasterized occluders.  Boxes
+	/// crossing the near plane or off screen are reported visible and left to frustum
+	/// culling.  Call after Rasterize.
+	///</summary>
+	bool IsVisible(const DirectX::BoundingBox& worldBox)const;
+
+	// Triangles queued this frame after clipping and back face removal.
+	size_t GetTriangleCount()const;
+
+	// Wall time of the last Rasterize.
+	double GetRasterizeMs()const;
+
+private:
+	// Screen space triangle in pixels, wound clockwise on screen so that with y
+	// pointing down all three edge functions are positive inside.
+	struct Triangle
+	{
+		float X[3];
+		float Y[3];
+		float Z[3];
+	};
+
+	template<typename Index>
+	void AddIndexedOccluder(const DirectX::XMFLOAT3* positions, size_t stride,
+		const Index* indices, size_t indexCount, DirectX::FXMMATRIX world);
+
+	void AddTriangle(const DirectX::XMFLOAT4 clip[3]);
+	void RasterizeTile(uint32 tile);
+
+	uint32 mWidth = 0;
+	uint32 mHeight = 0;
+	uint32 mTilesX = 0;
+	uint32 mTilesY = 0;
+
+	DirectX::XMFLOAT4X4 mViewProj;
+
+	std::vector<Triangle> mTriangles;
+
+	// Indices into mTriangles of the triangles touching each tile.
+	std::vector<std::vector<uint32>> mTileBins;
+
+	// Farthest occluder depth per texel.  Level 0 is the full resolution buffer and
+	// every level after it halves both dimensions.
+	std::vector<float> mLevels[kLevelCount];
+
+	double mRasterizeMs = 0.0;
+};
@@ -0,0 +1,99 @@
+//***************************************************************************************
+// RenderQueue.cpp
+//***************************************************************************************
+
+#include "RenderQueue.h"
+#include <cstring>
+#include <utility>
+
+RenderQueue::uint64 RenderQueue::MakeKey(uint32 pso, uint32 geometry, uint32 topology, float depth)
+{
+	// Non-negative floats compare the same as their bit patterns.  The test also
+	// turns NaN into 0.
+	if(!(depth > 0.0f))
+		depth = 0.0f;
+
+	uint32 depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return ((uint64)(pso & 0xff) << 56) |
+		((uint64)(geometry & 0xffff) << 40) |
+		((uint64)(topology & 0xff) << 32) |
+		(uint64)depthBits;
+}
+
+RenderQueue::uint32 RenderQueue::GetPso(uint64 key)
+{
+	return (uint32)(key >> 56) & 0xff;
+}
+
+RenderQueue::uint32 RenderQueue::GetGeometry(uint64 key)
+{
+	return (uint32)(key >> 40) & 0xffff;
+}
+
+RenderQueue::uint32 RenderQueue::GetTopology(uint64 key)
+{
+	return (uint32)(key >> 32) & 0xff;
+}
+
+void RenderQueue::Clear()
+{
+	mPackets.clear();
+}
+
+void RenderQueue::Push(uint64 key, uint32 item)
+{
+	mPackets.push_back({ key, item });
+}
+
+void RenderQueue::Sort()
+{
+	const size_t count = mPackets.size();
+	if(count < 2)
+		return;
+
+	// Histograms for all eight bytes in one read of the keys.
+	uint32 histograms[8][256] = {};
+	for(const DrawPacket& packet : mPackets)
+	{
+		for(int pass = 0; pass < 8; ++pass)
+			histograms[pass][(packet.Key >> (pass*8)) & 0xff]++;
+	}
+
+	mScratch.resize(count);
+
+	DrawPacket* src = mPackets.data();
+	DrawPacket* dst = mScratch.data();
+
+	for(int pass = 0; pass < 8; ++pass)
+	{
+		uint32* histogram = histograms[pass];
+		const int shift = pass*8;
+
+		// Every key has the same byte here: the pass would not move anything.
+		if(histogram[(src[0].Key >> shift) & 0xff] == count)
+			continue;
+
+		uint32 offset = 0;
+		for(int digit = 0; digit < 256; ++digit)
+		{
+			uint32 digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+
+		for(size_t i = 0; i < count; ++i)
+			dst[histogram[(src[i].Key >> shift) & 0xff]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if(src != mPackets.data())
+		mPackets.swap(mScratch);
+}
+
+const std::vector<DrawPacket>& RenderQueue::GetPackets()const
+{
+	return mPackets;
+}
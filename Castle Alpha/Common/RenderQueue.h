@@ -0,0 +1,60 @@
+//***************************************************************************************
+// RenderQueue.h
+//
+// Draw packets ordered by a 64-bit sort key, so draws that share pipeline state,
+// geometry and topology are submitted next to each other and the state only needs
+// binding once per run.
+//
+// Key layout, most significant first:
+//
+//   63..56  pipeline state id
+//   55..40  geometry id
+//   39..32  primitive topology
+//   31..0   view depth (bit pattern of a non-negative float), near first
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct DrawPacket
+{
+	std::uint64_t Key;
+
+	// Caller defined, usually an index into a render item array.
+	std::uint32_t Item;
+};
+
+class RenderQueue
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	///<summary>
+	/// Packs a sort key.  pso and topology must fit in 8 bits and geometry in 16; depth
+	/// is clamped to be non-negative.
+	///</summary>
+	static uint64 MakeKey(uint32 pso, uint32 geometry, uint32 topology, float depth);
+
+	static uint32 GetPso(uint64 key);
+	static uint32 GetGeometry(uint64 key);
+	static uint32 GetTopology(uint64 key);
+
+	void Clear();
+	void Push(uint64 key, uint32 item);
+
+	///<summary>
+	/// Sorts the packets by key with a stable least significant digit radix sort, a
+	/// byte per pass.  Passes where every key has the same byte are skipped, which for
+	/// a scene with one PSO and one geometry leaves only the depth bytes.
+	///</summary>
+	void Sort();
+
+	const std::vector<DrawPacket>& GetPackets()const;
+
+private:
+	std::vector<DrawPacket> mPackets;
+	std::vector<DrawPacket> mScratch;
+};
@@ -0,0 +1,719 @@
+//***************************************************************************************
+// SceneBvh.cpp
+//***************************************************************************************
+
+#include "SceneBvh.h"
+#include "FrustumCuller.h"
+#include "BoundsUtil.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = SceneBvh::uint32;
+
+	const uint32 kInvalidIndex = 0xffffffff;
+
+	const int kBinCount = 16;
+	const uint32 kMaxLeafSize = 4;
+
+	// Cost of visiting a node relative to testing one item's box.
+	const float kTraversalCost = 1.0f;
+
+	struct Aabb
+	{
+		XMFLOAT3 Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+		XMFLOAT3 Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const XMFLOAT3& p)
+		{
+			Min.x = std::min(Min.x, p.x); Min.y = std::min(Min.y, p.y); Min.z = std::min(Min.z, p.z);
+			Max.x = std::max(Max.x, p.x); Max.y = std::max(Max.y, p.y); Max.z = std::max(Max.z, p.z);
+		}
+
+		void Grow(const Aabb& b)
+		{
+			Grow(b.Min);
+			Grow(b.Max);
+		}
+
+		float HalfArea()const
+		{
+			if(Min.x > Max.x)
+				return 0.0f;
+
+			float dx = Max.x - Min.x, dy = Max.y - Min.y, dz = Max.z - Min.z;
+			return dx*dy + dy*dz + dz*dx;
+		}
+	};
+
+	Aabb ToAabb(const BoundingBox& box)
+	{
+		Aabb result;
+		result.Min = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+		result.Max = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+		return result;
+	}
+
+	float Component(const XMFLOAT3& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	// Node of the intermediate binary tree.  Count > 0 marks a leaf.
+	struct BinaryNode
+	{
+		Aabb Bounds;
+		uint32 Left = kInvalidIndex;
+		uint32 Right = kInvalidIndex;
+		uint32 First = 0;
+		uint32 Count = 0;
+	};
+
+	class BinaryBuilder
+	{
+	public:
+		BinaryBuilder(const std::vector<BoundingBox>& boxes, std::vector<uint32>& items) :
+			mItems(items)
+		{
+			mBounds.resize(boxes.size());
+			mCentroids.resize(boxes.size());
+			for(size_t i = 0; i < boxes.size(); ++i)
+			{
+				mBounds[i] = ToAabb(boxes[i]);
+				mCentroids[i] = boxes[i].Center;
+			}
+
+			mNodes.reserve(boxes.size() * 2);
+		}
+
+		uint32 BuildRange(uint32 first, uint32 count)
+		{
+			uint32 nodeIndex = (uint32)mNodes.size();
+			mNodes.push_back(BinaryNode());
+
+			Aabb bounds;
+			Aabb centroidBounds;
+			for(uint32 i = first; i < first + count; ++i)
+			{
+				bounds.Grow(mBounds[mItems[i]]);
+				centroidBounds.Grow(mCentroids[mItems[i]]);
+			}
+			mNodes[nodeIndex].Bounds = bounds;
+
+			uint32 mid = first;
+			if(!FindSplit(first, count, bounds, centroidBounds, mid))
+			{
+				mNodes[nodeIndex].First = first;
+				mNodes[nodeIndex].Count = count;
+				return nodeIndex;
+			}
+
+			uint32 left = BuildRange(first, mid - first);
+			uint32 right = BuildRange(mid, first + count - mid);
+			mNodes[nodeIndex].Left = left;
+			mNodes[nodeIndex].Right = right;
+
+			return nodeIndex;
+		}
+
+		const std::vector<BinaryNode>& GetNodes()const
+		{
+			return mNodes;
+		}
+
+	private:
+		// Partitions the range at the cheapest binned split and returns true, or returns
+		// false if the range is cheaper as a leaf.
+		bool FindSplit(uint32 first, uint32 count, const Aabb& bounds, const Aabb& centroidBounds, uint32& mid)
+		{
+			if(count == 1)
+				return false;
+
+			int axis = 0;
+			float extent = centroidBounds.Max.x - centroidBounds.Min.x;
+			for(int a = 1; a < 3; ++a)
+			{
+				float e = Component(centroidBounds.Max, a) - Component(centroidBounds.Min, a);
+				if(e > extent)
+				{
+					axis = a;
+					extent = e;
+				}
+			}
+
+			// Every centroid in the same place: no split separates them.
+			if(extent <= 0.0f)
+			{
+				if(count <= kMaxLeafSize)
+					return false;
+
+				mid = first + count / 2;
+				return true;
+			}
+
+			const float axisMin = Component(centroidBounds.Min, axis);
+			const float binScale = kBinCount / extent;
+			auto binOf = [&](uint32 item)
+			{
+				int bin = (int)((Component(mCentroids[item], axis) - axisMin)*binScale);
+				return std::min(bin, kBinCount - 1);
+			};
+
+			Aabb binBounds[kBinCount];
+			uint32 binCounts[kBinCount] = {};
+			for(uint32 i = first; i < first + count; ++i)
+			{
+				int bin = binOf(mItems[i]);
+				binBounds[bin].Grow(mBounds[mItems[i]]);
+				binCounts[bin]++;
+			}
+
+			// Sweep from the right to get the cost of everything right of each plane.
+			float rightCost[kBinCount];
+			{
+				Aabb b;
+				uint32 n = 0;
+				for(int i = kBinCount - 1; i > 0; --i)
+				{
+					b.Grow(binBounds[i]);
+					n += binCounts[i];
+					rightCost[i] = b.HalfArea()*n;
+				}
+			}
+
+			float bestCost = FLT_MAX;
+			int bestSplit = -1;
+			{
+				Aabb b;
+				uint32 n = 0;
+				for(int i = 0; i < kBinCount - 1; ++i)
+				{
+					b.Grow(binBounds[i]);
+					n += binCounts[i];
+
+					float cost = b.HalfArea()*n + rightCost[i + 1];
+					if(n > 0 && n < count && cost < bestCost)
+					{
+						bestCost = cost;
+						bestSplit = i;
+					}
+				}
+			}
+
+			float area = bounds.HalfArea();
+			float splitCost = kTraversalCost*area + bestCost;
+			float leafCost = area*count;
+
+			if(count <= kMaxLeafSize && (bestSplit < 0 || leafCost <= splitCost))
+				return false;
+
+			if(bestSplit >= 0)
+			{
+				uint32* begin = &mItems[first];
+				uint32* split = std::partition(begin, begin + count,
+					[&](uint32 item) { return binOf(item) <= bestSplit; });
+				mid = first + (uint32)(split - begin);
+			}
+			else
+			{
+				mid = first + count / 2;
+			}
+
+			return true;
+		}
+
+		std::vector<uint32>& mItems;
+		std::vector<Aabb> mBounds;
+		std::vector<XMFLOAT3> mCentroids;
+		std::vector<BinaryNode> mNodes;
+	};
+
+	inline XMVECTOR Load4(const float* values)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(values));
+	}
+
+	bool BoxOutsidePlanes(const BoundingBox& box, const XMFLOAT4 planes[6])
+	{
+		for(int p = 0; p < 6; ++p)
+		{
+			float dist = planes[p].x*box.Center.x + planes[p].y*box.Center.y + planes[p].z*box.Center.z + planes[p].w;
+			float radius = fabsf(planes[p].x)*box.Extents.x + fabsf(planes[p].y)*box.Extents.y + fabsf(planes[p].z)*box.Extents.z;
+			if(dist + radius < 0.0f)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Slab test.  Returns the entry distance, clamped to 0 for rays starting inside,
+	// or a negative value on a miss.
+	// Axes the ray runs parallel to have an infinite reciprocal direction.  The slab
+	// products would be NaN for an origin on one of the slab's planes, so those axes
+	// are tested by position instead: the ray is inside the slab for every t, or never.
+	bool IsParallel(float invDir)
+	{
+		return fabsf(invDir) == INFINITY;
+	}
+
+	float RayBoxEntry(const XMFLOAT3& origin, const XMFLOAT3& invDir, const BoundingBox& box, float maxDistance)
+	{
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+
+		const float o[3] = { origin.x, origin.y, origin.z };
+		const float inv[3] = { invDir.x, invDir.y, invDir.z };
+		const float c[3] = { box.Center.x, box.Center.y, box.Center.z };
+		const float e[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+
+		for(int a = 0; a < 3; ++a)
+		{
+			if(IsParallel(inv[a]))
+			{
+				if(o[a] < c[a] - e[a] || o[a] > c[a] + e[a])
+					return -1.0f;
+				continue;
+			}
+
+			float t1 = (c[a] - e[a] - o[a])*inv[a];
+			float t2 = (c[a] + e[a] - o[a])*inv[a];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+
+		return tMin <= tMax ? tMin : -1.0f;
+	}
+}
+
+void SceneBvh::Build(const std::vector<BoundingBox>& boxes)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	mNodes.clear();
+	mItems.resize(boxes.size());
+	for(uint32 i = 0; i < (uint32)boxes.size(); ++i)
+		mItems[i] = i;
+
+	if(!boxes.empty())
+	{
+		BinaryBuilder builder(boxes, mItems);
+		builder.BuildRange(0, (uint32)boxes.size());
+		const std::vector<BinaryNode>& binary = builder.GetNodes();
+
+		//
+		// Collapse the binary tree: each four-wide node starts with the two children of
+		// a binary node and keeps replacing its largest inner child by that child's two
+		// children until it has four.
+		//
+
+		mNodes.reserve(binary.size() / 2 + 1);
+
+		struct Collapse
+		{
+			const std::vector<BinaryNode>& Binary;
+			std::vector<Node>& Nodes;
+
+			uint32 operator()(uint32 binaryIndex)
+			{
+				uint32 children[4];
+				uint32 childCount = 0;
+
+				const BinaryNode& b = Binary[binaryIndex];
+				if(b.Count > 0)
+				{
+					children[childCount++] = binaryIndex;
+				}
+				else
+				{
+					children[childCount++] = b.Left;
+					children[childCount++] = b.Right;
+				}
+
+				while(childCount < 4)
+				{
+					int widest = -1;
+					float widestArea = -1.0f;
+					for(uint32 i = 0; i < childCount; ++i)
+					{
+						const BinaryNode& c = Binary[children[i]];
+						if(c.Count == 0 && c.Bounds.HalfArea() > widestArea)
+						{
+							widest = (int)i;
+							widestArea = c.Bounds.HalfArea();
+						}
+					}
+
+					if(widest < 0)
+						break;
+
+					const BinaryNode& c = Binary[children[widest]];
+					children[widest] = c.Left;
+					children[childCount++] = c.Right;
+				}
+
+				uint32 nodeIndex = (uint32)Nodes.size();
+				Nodes.push_back(Node());
+				{
+					Node& node = Nodes[nodeIndex];
+					for(uint32 i = 0; i < 4; ++i)
+					{
+						node.MinX[i] = node.MinY[i] = node.MinZ[i] = 0.0f;
+						node.MaxX[i] = node.MaxY[i] = node.MaxZ[i] = 0.0f;
+						node.Child[i] = kInvalidIndex;
+						node.Count[i] = 0;
+					}
+				}
+
+				for(uint32 i = 0; i < childCount; ++i)
+				{
+					const BinaryNode& c = Binary[children[i]];
+
+					uint32 child = c.Count > 0 ? c.First : (*this)(children[i]);
+
+					// Nodes may have grown, so the node is looked up again.
+					Node& node = Nodes[nodeIndex];
+					node.MinX[i] = c.Bounds.Min.x; node.MinY[i] = c.Bounds.Min.y; node.MinZ[i] = c.Bounds.Min.z;
+					node.MaxX[i] = c.Bounds.Max.x; node.MaxY[i] = c.Bounds.Max.y; node.MaxZ[i] = c.Bounds.Max.z;
+					node.Child[i] = child;
+					node.Count[i] = c.Count;
+				}
+
+				return nodeIndex;
+			}
+		};
+
+		Collapse collapse = { binary, mNodes };
+		collapse(0);
+	}
+
+	mBoxes = boxes;
+
+	auto end = std::chrono::high_resolution_clock::now();
+	mBuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void SceneBvh::Refit(const std::vector<BoundingBox>& boxes)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	mBoxes = boxes;
+
+	// Children are always stored after their parents.
+	for(size_t i = mNodes.size(); i-- > 0; )
+		RefitNode((uint32)i, boxes);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	mRefitMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void SceneBvh::RefitNode(uint32 nodeIndex, const std::vector<BoundingBox>& boxes)
+{
+	Node& node = mNodes[nodeIndex];
+
+	for(uint32 i = 0; i < 4; ++i)
+	{
+		if(node.Child[i] == kInvalid)
+			continue;
+
+		Aabb bounds;
+		if(node.Count[i] > 0)
+		{
+			for(uint32 k = node.Child[i]; k < node.Child[i] + node.Count[i]; ++k)
+				bounds.Grow(ToAabb(boxes[mItems[k]]));
+		}
+		else
+		{
+			const Node& child = mNodes[node.Child[i]];
+			for(uint32 k = 0; k < 4; ++k)
+			{
+				if(child.Child[k] == kInvalid)
+					continue;
+
+				bounds.Grow(XMFLOAT3(child.MinX[k], child.MinY[k], child.MinZ[k]));
+				bounds.Grow(XMFLOAT3(child.MaxX[k], child.MaxY[k], child.MaxZ[k]));
+			}
+		}
+
+		node.MinX[i] = bounds.Min.x; node.MinY[i] = bounds.Min.y; node.MinZ[i] = bounds.Min.z;
+		node.MaxX[i] = bounds.Max.x; node.MaxY[i] = bounds.Max.y; node.MaxZ[i] = bounds.Max.z;
+	}
+}
+
+void SceneBvh::QueryFrustum(FXMMATRIX viewProj, std::vector<uint32>& results)const
+{
+	if(mNodes.empty())
+		return;
+
+	XMFLOAT4 planes[6];
+	FrustumCuller::ExtractPlanes(viewProj, planes);
+
+	XMVECTOR nx[6], ny[6], nz[6], d[6], absNx[6], absNy[6], absNz[6];
+	for(int p = 0; p < 6; ++p)
+	{
+		XMVECTOR plane = XMLoadFloat4(&planes[p]);
+		XMVECTOR absPlane = XMVectorAbs(plane);
+		nx[p] = XMVectorSplatX(plane);
+		ny[p] = XMVectorSplatY(plane);
+		nz[p] = XMVectorSplatZ(plane);
+		d[p] = XMVectorSplatW(plane);
+		absNx[p] = XMVectorSplatX(absPlane);
+		absNy[p] = XMVectorSplatY(absPlane);
+		absNz[p] = XMVectorSplatZ(absPlane);
+	}
+
+	// Adds every item below a node that is entirely inside the frustum.
+	std::vector<uint32> insideStack;
+	auto addSubtree = [&](uint32 nodeIndex)
+	{
+		insideStack.push_back(nodeIndex);
+		while(!insideStack.empty())
+		{
+			const Node& node = mNodes[insideStack.back()];
+			insideStack.pop_back();
+
+			for(uint32 i = 0; i < 4; ++i)
+			{
+				if(node.Child[i] == kInvalid)
+					continue;
+
+				if(node.Count[i] > 0)
+					results.insert(results.end(), mItems.begin() + node.Child[i], mItems.begin() + node.Child[i] + node.Count[i]);
+				else
+					insideStack.push_back(node.Child[i]);
+			}
+		}
+	};
+
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR half = XMVectorReplicate(0.5f);
+
+	std::vector<uint32> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while(!stack.empty())
+	{
+		const Node& node = mNodes[stack.back()];
+		stack.pop_back();
+
+		XMVECTOR minX = Load4(node.MinX), maxX = Load4(node.MaxX);
+		XMVECTOR minY = Load4(node.MinY), maxY = Load4(node.MaxY);
+		XMVECTOR minZ = Load4(node.MinZ), maxZ = Load4(node.MaxZ);
+
+		XMVECTOR cx = (minX + maxX)*half, ex = (maxX - minX)*half;
+		XMVECTOR cy = (minY + maxY)*half, ey = (maxY - minY)*half;
+		XMVECTOR cz = (minZ + maxZ)*half, ez = (maxZ - minZ)*half;
+
+		XMVECTOR outside = XMVectorFalseInt();
+		XMVECTOR straddles = XMVectorFalseInt();
+		for(int p = 0; p < 6; ++p)
+		{
+			XMVECTOR dist = XMVectorMultiplyAdd(nx[p], cx, XMVectorMultiplyAdd(ny[p], cy, XMVectorMultiplyAdd(nz[p], cz, d[p])));
+			XMVECTOR radius = XMVectorMultiplyAdd(absNx[p], ex, XMVectorMultiplyAdd(absNy[p], ey, absNz[p]*ez));
+
+			outside = XMVectorOrInt(outside, XMVectorLess(dist + radius, zero));
+			straddles = XMVectorOrInt(straddles, XMVectorLess(dist - radius, zero));
+		}
+
+		uint32 outsideMask = BoundsUtil::LaneMask(outside);
+		uint32 straddleMask = BoundsUtil::LaneMask(straddles);
+
+		for(uint32 i = 0; i < 4; ++i)
+		{
+			if(node.Child[i] == kInvalid || (outsideMask & (1 << i)))
+				continue;
+
+			bool inside = (straddleMask & (1 << i)) == 0;
+
+			if(node.Count[i] == 0)
+			{
+				if(inside)
+					addSubtree(node.Child[i]);
+				else
+					stack.push_back(node.Child[i]);
+				continue;
+			}
+
+			for(uint32 k = node.Child[i]; k < node.Child[i] + node.Count[i]; ++k)
+			{
+				if(inside || !BoxOutsidePlanes(mBoxes[mItems[k]], planes))
+					results.push_back(mItems[k]);
+			}
+		}
+	}
+}
+
+void SceneBvh::QueryOverlap(const BoundingBox& box, std::vector<uint32>& results)const
+{
+	if(mNodes.empty())
+		return;
+
+	Aabb query = ToAabb(box);
+	XMVECTOR qMinX = XMVectorReplicate(query.Min.x), qMaxX = XMVectorReplicate(query.Max.x);
+	XMVECTOR qMinY = XMVectorReplicate(query.Min.y), qMaxY = XMVectorReplicate(query.Max.y);
+	XMVECTOR qMinZ = XMVectorReplicate(query.Min.z), qMaxZ = XMVectorReplicate(query.Max.z);
+
+	std::vector<uint32> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while(!stack.empty())
+	{
+		const Node& node = mNodes[stack.back()];
+		stack.pop_back();
+
+		// Separated on any axis means no overlap.
+		XMVECTOR separated = XMVectorOrInt(
+			XMVectorOrInt(XMVectorLess(Load4(node.MaxX), qMinX), XMVectorGreater(Load4(node.MinX), qMaxX)),
+			XMVectorOrInt(
+				XMVectorOrInt(XMVectorLess(Load4(node.MaxY), qMinY), XMVectorGreater(Load4(node.MinY), qMaxY)),
+				XMVectorOrInt(XMVectorLess(Load4(node.MaxZ), qMinZ), XMVectorGreater(Load4(node.MinZ), qMaxZ))));
+
+		uint32 separatedMask = BoundsUtil::LaneMask(separated);
+
+		for(uint32 i = 0; i < 4; ++i)
+		{
+			if(node.Child[i] == kInvalid || (separatedMask & (1 << i)))
+				continue;
+
+			if(node.Count[i] == 0)
+			{
+				stack.push_back(node.Child[i]);
+				continue;
+			}
+
+			for(uint32 k = node.Child[i]; k < node.Child[i] + node.Count[i]; ++k)
+			{
+				if(mBoxes[mItems[k]].Intersects(box))
+					results.push_back(mItems[k]);
+			}
+		}
+	}
+}
+
+bool SceneBvh::RayCast(FXMVECTOR origin, FXMVECTOR direction, float maxDistance,
+	uint32& hitIndex, float& hitDistance)const
+{
+	if(mNodes.empty())
+		return false;
+
+	XMFLOAT3 o;
+	XMFLOAT3 invDir;
+	XMStoreFloat3(&o, origin);
+	XMStoreFloat3(&invDir, XMVectorReciprocal(direction));
+
+	XMVECTOR ox = XMVectorReplicate(o.x), oy = XMVectorReplicate(o.y), oz = XMVectorReplicate(o.z);
+	XMVECTOR ix = XMVectorReplicate(invDir.x), iy = XMVectorReplicate(invDir.y), iz = XMVectorReplicate(invDir.z);
+
+	// Entry and exit distances of the four child slabs along one axis.  On a parallel
+	// axis they are -inf and +inf for the children the origin is inside, and an empty
+	// range for the others.
+	const bool parallel[3] = { IsParallel(invDir.x), IsParallel(invDir.y), IsParallel(invDir.z) };
+	auto slab = [](const float* mins, const float* maxs, FXMVECTOR origin, FXMVECTOR inv, bool isParallel,
+		XMVECTOR& tNear, XMVECTOR& tFar)
+	{
+		XMVECTOR lo = Load4(mins);
+		XMVECTOR hi = Load4(maxs);
+
+		if(isParallel)
+		{
+			XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(origin, lo), XMVectorLessOrEqual(origin, hi));
+			tNear = XMVectorSelect(g_XMInfinity, XMVectorNegate(g_XMInfinity), inside);
+			tFar = XMVectorSelect(XMVectorNegate(g_XMInfinity), g_XMInfinity, inside);
+			return;
+		}
+
+		XMVECTOR t1 = (lo - origin)*inv;
+		XMVECTOR t2 = (hi - origin)*inv;
+		tNear = XMVectorMin(t1, t2);
+		tFar = XMVectorMax(t1, t2);
+	};
+
+	float best = maxDistance;
+	bool hit = false;
+
+	// Nodes are pushed with their entry distance so ones behind the best hit so far
+	// are skipped when popped.
+	std::vector<std::pair<uint32, float>> stack;
+	stack.reserve(64);
+	stack.push_back(std::make_pair(0u, 0.0f));
+
+	while(!stack.empty())
+	{
+		std::pair<uint32, float> entry = stack.back();
+		stack.pop_back();
+
+		if(entry.second > best)
+			continue;
+
+		const Node& node = mNodes[entry.first];
+
+		XMVECTOR nearX, farX, nearY, farY, nearZ, farZ;
+		slab(node.MinX, node.MaxX, ox, ix, parallel[0], nearX, farX);
+		slab(node.MinY, node.MaxY, oy, iy, parallel[1], nearY, farY);
+		slab(node.MinZ, node.MaxZ, oz, iz, parallel[2], nearZ, farZ);
+
+		XMVECTOR tEnter = XMVectorMax(XMVectorMax(nearX, nearY), XMVectorMax(nearZ, XMVectorZero()));
+		XMVECTOR tExit = XMVectorMin(XMVectorMin(farX, farY), XMVectorMin(farZ, XMVectorReplicate(best)));
+
+		uint32 hitMask = ~BoundsUtil::LaneMask(XMVectorGreater(tEnter, tExit)) & 0xf;
+
+		XMFLOAT4 enter;
+		XMStoreFloat4(&enter, tEnter);
+		const float enterDistance[4] = { enter.x, enter.y, enter.z, enter.w };
+
+		for(uint32 i = 0; i < 4; ++i)
+		{
+			if(node.Child[i] == kInvalid || !(hitMask & (1 << i)))
+				continue;
+
+			if(node.Count[i] == 0)
+			{
+				stack.push_back(std::make_pair(node.Child[i], enterDistance[i]));
+				continue;
+			}
+
+			for(uint32 k = node.Child[i]; k < node.Child[i] + node.Count[i]; ++k)
+			{
+				float t = RayBoxEntry(o, invDir, mBoxes[mItems[k]], best);
+				if(t >= 0.0f && (!hit || t < best))
+				{
+					best = t;
+					hitIndex = mItems[k];
+					hit = true;
+				}
+			}
+		}
+	}
+
+	if(hit)
+		hitDistance = best;
+
+	return hit;
+}
+
+size_t SceneBvh::GetNodeCount()const
+{
+	return mNodes.size();
+}
+
+size_t SceneBvh::GetItemCount()const
+{
+	return mItems.size();
+}
+
+double SceneBvh::GetBuildMs()const
+{
+	return mBuildMs;
+}
+
+double SceneBvh::GetRefitMs()const
+{
+	return mRefitMs;
+}
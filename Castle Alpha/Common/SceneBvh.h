@@ -0,0 +1,89 @@
+//***************************************************************************************
+// SceneBvh.h
+//
+// Static four-wide bounding volume hierarchy over world space boxes, for culling and
+// spatial queries over large numbers of scene objects.
+//
+// The tree is built top down with a binned surface area heuristic into a binary tree,
+// which is then collapsed so every node holds the bounds of up to four children in
+// structure of arrays form and all four can be tested at once.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+class SceneBvh
+{
+public:
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Builds the tree over the given boxes.  Query results are indices into boxes.
+	///</summary>
+	void Build(const std::vector<DirectX::BoundingBox>& boxes);
+
+	///<summary>
+	/// Recomputes the node bounds bottom up after boxes moved, keeping the tree
+	/// structure.  boxes must be the same size as the array the tree was built from.
+	/// Cheaper than a rebuild, but the tree degrades if objects move far.
+	///</summary>
+	void Refit(const std::vector<DirectX::BoundingBox>& boxes);
+
+	///<summary>
+	/// Appends the boxes that intersect or are inside the frustum of viewProj to
+	/// results.  Subtrees entirely inside the frustum are added without further tests.
+	///</summary>
+	void QueryFrustum(DirectX::FXMMATRIX viewProj, std::vector<uint32>& results)const;
+
+	///<summary>
+	/// Appends the boxes that overlap box to results.
+	///</summary>
+	void QueryOverlap(const DirectX::BoundingBox& box, std::vector<uint32>& results)const;
+
+	///<summary>
+	/// Finds the nearest box the ray from origin along direction enters within
+	/// maxDistance.  direction does not need to be normalized; distances are in units
+	/// of its length.  Returns false if nothing is hit.
+	///</summary>
+	bool RayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance,
+		uint32& hitIndex, float& hitDistance)const;
+
+	size_t GetNodeCount()const;
+	size_t GetItemCount()const;
+
+	// Wall time of the last Build and Refit.
+	double GetBuildMs()const;
+	double GetRefitMs()const;
+
+private:
+	static const uint32 kInvalid = 0xffffffff;
+
+	// Four children.  A slot with Count > 0 is a leaf holding mItems[Child, Child + Count),
+	// a slot with Count == 0 is the inner node mNodes[Child], and an unused slot has
+	// Child == kInvalid.  128 bytes.
+	struct Node
+	{
+		float MinX[4], MinY[4], MinZ[4];
+		float MaxX[4], MaxY[4], MaxZ[4];
+		uint32 Child[4];
+		uint32 Count[4];
+	};
+
+	void RefitNode(uint32 nodeIndex, const std::vector<DirectX::BoundingBox>& boxes);
+
+	std::vector<Node> mNodes;
+
+	// Box indices, grouped by leaf.
+	std::vector<uint32> mItems;
+
+	// Copy of the boxes for the exact tests at the leaves, in the caller's order.
+	std::vector<DirectX::BoundingBox> mBoxes;
+
+	double mBuildMs = 0.0;
+	double mRefitMs = 0.0;
+};
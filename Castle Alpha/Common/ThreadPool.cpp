@@ -0,0 +1,107 @@
+//***************************************************************************************
+// ThreadPool.cpp
+//***************************************************************************************
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned workerCount) :
+	mNextIndex(0)
+{
+	if(workerCount == 0)
+	{
+		unsigned hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	for(unsigned i = 0; i < workerCount; ++i)
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWorkReady.notify_all();
+
+	for(std::thread& worker : mWorkers)
+		worker.join();
+}
+
+unsigned ThreadPool::GetThreadCount()const
+{
+	return (unsigned)mWorkers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+	if(count == 0)
+		return;
+
+	// Not worth waking anyone for a single piece.
+	if(mWorkers.empty() || count == 1)
+	{
+		for(size_t i = 0; i < count; ++i)
+			fn(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJob = &fn;
+		mJobCount = count;
+		mNextIndex = 0;
+		mBusyWorkers = (unsigned)mWorkers.size();
+		++mGeneration;
+	}
+	mWorkReady.notify_all();
+
+	RunJob();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+	mJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	std::uint64_t seenGeneration = 0;
+
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkReady.wait(lock, [&]() { return mStopping || mGeneration != seenGeneration; });
+
+			if(mStopping)
+				return;
+
+			seenGeneration = mGeneration;
+		}
+
+		RunJob();
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			last = --mBusyWorkers == 0;
+		}
+
+		if(last)
+			mWorkDone.notify_one();
+	}
+}
+
+void ThreadPool::RunJob()
+{
+	// Indices are handed out one at a time, so uneven pieces balance themselves.
+	for(;;)
+	{
+		size_t i = mNextIndex.fetch_add(1);
+		if(i >= mJobCount)
+			break;
+
+		(*mJob)(i);
+	}
+}
@@ -0,0 +1,60 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// Fixed set of worker threads for splitting per frame CPU work into independent
+// pieces.  The calling thread works on the job too, so a pool of N threads runs N + 1
+// pieces at a time.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	///<summary>
+	/// Starts workerCount threads.  0 uses one less than the number of hardware
+	/// threads, leaving one for the caller.
+	///</summary>
+	explicit ThreadPool(unsigned workerCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+	// Worker threads plus the caller.
+	unsigned GetThreadCount()const;
+
+	///<summary>
+	/// Calls fn(i) for every i in [0, count) across the workers and the calling thread,
+	/// and returns once all calls have finished.  The order of the calls is undefined,
+	/// so each i must only touch data no other i writes.  Not reentrant: fn must not
+	/// call ParallelFor on the same pool.
+	///</summary>
+	void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+	void WorkerLoop();
+	void RunJob();
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWorkReady;
+	std::condition_variable mWorkDone;
+
+	// Current job.  Each ParallelFor bumps mGeneration so every worker joins it once.
+	const std::function<void(size_t)>* mJob = nullptr;
+	size_t mJobCount = 0;
+	std::atomic<size_t> mNextIndex;
+	std::uint64_t mGeneration = 0;
+	unsigned mBusyWorkers = 0;
+	bool mStopping = false;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "UploadRing.h"
 
 template<typename T>
 class UploadBuffer
@@ -55,10 +56,71 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Copies count consecutive elements starting at elementIndex, in one memcpy unless
+    // the elements are padded to constant buffer size.
+    void CopyData(int elementIndex, const T* data, int count)
+    {
+        if(mElementByteSize == sizeof(T))
+        {
+            memcpy(&mMappedData[elementIndex*mElementByteSize], data, count*sizeof(T));
+            return;
+        }
+
+        for(int i = 0; i < count; ++i)
+            CopyData(elementIndex + i, data[i]);
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
 
     UINT mElementByteSize = 0;
     bool mIsConstantBuffer = false;
+};
+
+// An upload heap buffer that stays mapped for its lifetime and is handed out by an
+// UploadRing.  One is shared by all the frame resources; the ring's fences keep a
+// frame from overwriting data the GPU has not read yet.
+class UploadRingBuffer
+{
+public:
+    UploadRingBuffer(ID3D12Device* device, UINT64 byteSize)
+    {
+        ThrowIfFailed(device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&mUploadBuffer)));
+
+        BYTE* mappedData = nullptr;
+        ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)));
+
+        // Buffers start on a 64KB boundary, so every ring offset aligned to 256 bytes is
+        // a valid constant buffer address.
+        mRing.Reset(mappedData, mUploadBuffer->GetGPUVirtualAddress(), byteSize);
+    }
+
+    UploadRingBuffer(const UploadRingBuffer& rhs) = delete;
+    UploadRingBuffer& operator=(const UploadRingBuffer& rhs) = delete;
+    ~UploadRingBuffer()
+    {
+        if(mUploadBuffer != nullptr)
+            mUploadBuffer->Unmap(0, nullptr);
+    }
+
+    ID3D12Resource* Resource()const
+    {
+        return mUploadBuffer.Get();
+    }
+
+    UploadRing& Ring()
+    {
+        return mRing;
+    }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+    UploadRing mRing;
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+//***************************************************************************************
+// UploadRing.cpp
+//***************************************************************************************
+
+#include "UploadRing.h"
+#include <algorithm>
+#include <cassert>
+
+void UploadRing::Reset(std::uint8_t* mappedData, uint64 gpuAddress, uint64 capacity)
+{
+	mMappedData = mappedData;
+	mGpuAddress = gpuAddress;
+	mCapacity = capacity;
+
+	mHead = 0;
+	mTail = 0;
+	mFrameStart = 0;
+	mFrames.clear();
+
+	mFrameHighWater = 0;
+	mUsedHighWater = 0;
+	mFailedAllocationCount = 0;
+}
+
+UploadRing::Allocation UploadRing::Allocate(uint64 size, uint64 alignment)
+{
+	assert(mCapacity > 0);
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	// Nothing is in use, so start again from the beginning of the buffer rather than
+	// splitting the next allocation's room between the tail and the head.
+	if(mHead == mTail && mHead % mCapacity != 0)
+	{
+		mHead += mCapacity - mHead % mCapacity;
+		mTail = mHead;
+		mFrameStart = mHead;
+	}
+
+	uint64 offset = mHead % mCapacity;
+	uint64 alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+
+	// Skip the end of the buffer if the allocation does not fit before it.
+	if(alignedOffset + size > mCapacity)
+		alignedOffset = 0;
+
+	uint64 padding = alignedOffset >= offset ? alignedOffset - offset : mCapacity - offset;
+
+	if(size > mCapacity || mHead - mTail + padding + size > mCapacity)
+	{
+		mFailedAllocationCount++;
+		return Allocation();
+	}
+
+	mHead += padding + size;
+	mUsedHighWater = std::max(mUsedHighWater, mHead - mTail);
+
+	Allocation allocation;
+	allocation.CpuAddress = mMappedData + alignedOffset;
+	allocation.GpuAddress = mGpuAddress + alignedOffset;
+	allocation.Offset = alignedOffset;
+	allocation.Size = size;
+	return allocation;
+}
+
+void UploadRing::EndFrame(uint64 fence)
+{
+	FrameMark mark;
+	mark.Fence = fence;
+	mark.End = mHead;
+	mFrames.push_back(mark);
+
+	mFrameHighWater = std::max(mFrameHighWater, mHead - mFrameStart);
+	mFrameStart = mHead;
+}
+
+void UploadRing::Retire(uint64 completedFence)
+{
+	while(!mFrames.empty() && mFrames.front().Fence <= completedFence)
+	{
+		// Allocate may have moved the tail past an empty frame's end.
+		mTail = std::max(mTail, mFrames.front().End);
+		mFrames.pop_front();
+	}
+}
+
+UploadRing::uint64 UploadRing::GetOldestFence()const
+{
+	return mFrames.empty() ? 0 : mFrames.front().Fence;
+}
+
+UploadRing::uint64 UploadRing::GetCapacity()const
+{
+	return mCapacity;
+}
+
+UploadRing::uint64 UploadRing::GetUsedBytes()const
+{
+	return mHead - mTail;
+}
+
+UploadRing::uint64 UploadRing::GetFrameBytes()const
+{
+	return mHead - mFrameStart;
+}
+
+UploadRing::uint64 UploadRing::GetFrameHighWater()const
+{
+	return std::max(mFrameHighWater, mHead - mFrameStart);
+}
+
+UploadRing::uint64 UploadRing::GetUsedHighWater()const
+{
+	return mUsedHighWater;
+}
+
+UploadRing::uint64 UploadRing::GetFailedAllocationCount()const
+{
+	return mFailedAllocationCount;
+}
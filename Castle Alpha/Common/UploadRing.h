@@ -0,0 +1,116 @@
+//***************************************************************************************
+// UploadRing.h
+//
+// Linear suballocator over one persistently mapped buffer, used as a ring across the
+// frames the GPU may still be reading.  Every allocation of a frame is freed together
+// once the fence value the frame was closed with has completed, so transient data
+// (constants, instance streams) needs no per-object slots.
+//
+// The ring only sees a CPU pointer and a base GPU address, so it can run on plain
+// host memory.  UploadRingBuffer in UploadBuffer.h backs it with an upload heap.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+class UploadRing
+{
+public:
+	using uint64 = std::uint64_t;
+
+	struct Allocation
+	{
+		// Null when the ring had no room.
+		std::uint8_t* CpuAddress = nullptr;
+		uint64 GpuAddress = 0;
+
+		// Offset of the allocation in the buffer and its size in bytes.
+		uint64 Offset = 0;
+		uint64 Size = 0;
+	};
+
+	///<summary>
+	/// Points the ring at capacity bytes of mapped memory starting at gpuAddress and
+	/// forgets all earlier allocations.  Offsets are aligned relative to the start of
+	/// the buffer, so gpuAddress must be aligned to the largest alignment requested.
+	///</summary>
+	void Reset(std::uint8_t* mappedData, uint64 gpuAddress, uint64 capacity);
+
+	///<summary>
+	/// Suballocates size bytes from the current frame.  alignment must be a power of
+	/// two.  An allocation never wraps around the end of the buffer; the tail is
+	/// skipped instead.  Returns an empty allocation when the frames still in flight
+	/// leave no room.
+	///</summary>
+	Allocation Allocate(uint64 size, uint64 alignment);
+
+	///<summary>
+	/// Allocates and copies data, aligned to alignment or to the type's own alignment.
+	///</summary>
+	template<typename T>
+	Allocation Push(const T& data, uint64 alignment = alignof(T))
+	{
+		Allocation allocation = Allocate(sizeof(T), alignment);
+		if(allocation.CpuAddress != nullptr)
+			std::memcpy(allocation.CpuAddress, &data, sizeof(T));
+
+		return allocation;
+	}
+
+	///<summary>
+	/// Closes the current frame.  Its allocations stay alive until Retire is called
+	/// with a completed fence value of at least fence.
+	///</summary>
+	void EndFrame(uint64 fence);
+
+	///<summary>
+	/// Frees the frames whose fence value is at most completedFence.
+	///</summary>
+	void Retire(uint64 completedFence);
+
+	// Fence value of the oldest frame still holding memory, or 0 if there is none.
+	uint64 GetOldestFence()const;
+
+	uint64 GetCapacity()const;
+
+	// Bytes held by the frames in flight and the current frame, alignment padding included.
+	uint64 GetUsedBytes()const;
+
+	// Bytes allocated by the current frame so far.
+	uint64 GetFrameBytes()const;
+
+	// Most bytes a single frame has allocated, and most bytes held at once.
+	uint64 GetFrameHighWater()const;
+	uint64 GetUsedHighWater()const;
+
+	// Allocations that found no room since the last Reset.
+	uint64 GetFailedAllocationCount()const;
+
+private:
+	struct FrameMark
+	{
+		uint64 Fence;
+
+		// Value of mHead when the frame was closed.
+		uint64 End;
+	};
+
+	std::uint8_t* mMappedData = nullptr;
+	uint64 mGpuAddress = 0;
+	uint64 mCapacity = 0;
+
+	// Running byte counts; the buffer offset is the count modulo the capacity.  Every
+	// byte in [mTail, mHead) is in use.
+	uint64 mHead = 0;
+	uint64 mTail = 0;
+	uint64 mFrameStart = 0;
+
+	std::deque<FrameMark> mFrames;
+
+	uint64 mFrameHighWater = 0;
+	uint64 mUsedHighWater = 0;
+	uint64 mFailedAllocationCount = 0;
+};
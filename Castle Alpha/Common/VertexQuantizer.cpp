@@ -0,0 +1,179 @@
+//***************************************************************************************
+// VertexQuantizer.cpp
+//***************************************************************************************
+
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Scale and offset that map bounds onto [-1, 1] and back.  A flat axis keeps a
+	// scale of 1 so it does not divide by zero; every position on it is the centre.
+	struct BoundsTransform
+	{
+		XMVECTOR Center;
+		XMVECTOR Extents;
+		XMVECTOR InvExtents;
+	};
+
+	BoundsTransform MakeBoundsTransform(const BoundingBox& bounds)
+	{
+		BoundsTransform t;
+		t.Center = XMLoadFloat3(&bounds.Center);
+
+		XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+		XMVECTOR flat = XMVectorLessOrEqual(extents, XMVectorReplicate(FLT_MIN));
+		t.Extents = XMVectorSelect(extents, XMVectorSplatOne(), flat);
+		t.InvExtents = XMVectorReciprocal(t.Extents);
+		return t;
+	}
+
+	inline void StoreOctahedral(XMSHORTN2* dst, FXMVECTOR v) { XMStoreShortN2(dst, v); }
+	inline void StoreOctahedral(XMBYTEN2* dst, FXMVECTOR v) { XMStoreByteN2(dst, v); }
+	inline XMVECTOR LoadOctahedral(const XMSHORTN2* src) { return XMLoadShortN2(src); }
+	inline XMVECTOR LoadOctahedral(const XMBYTEN2* src) { return XMLoadByteN2(src); }
+
+	template<typename Encoded>
+	void EncodeVertices(const std::vector<GeometryGenerator::Vertex>& vertices, const BoundingBox& bounds,
+		std::vector<Encoded>& encoded)
+	{
+		BoundsTransform t = MakeBoundsTransform(bounds);
+
+		encoded.resize(vertices.size());
+		for(size_t i = 0; i < vertices.size(); ++i)
+		{
+			const GeometryGenerator::Vertex& v = vertices[i];
+			Encoded& e = encoded[i];
+
+			// XMStoreShortN4 saturates, which clamps positions outside the bounds.
+			XMVECTOR p = (XMLoadFloat3(&v.Position) - t.Center)*t.InvExtents;
+			XMStoreShortN4(&e.Position, XMVectorSetW(p, 0.0f));
+
+			StoreOctahedral(&e.Normal, VertexQuantizer::EncodeOctahedral(XMLoadFloat3(&v.Normal)));
+			StoreOctahedral(&e.TangentU, VertexQuantizer::EncodeOctahedral(XMLoadFloat3(&v.TangentU)));
+			XMStoreHalf2(&e.TexC, XMLoadFloat2(&v.TexC));
+		}
+	}
+
+	template<typename Encoded>
+	void DecodeVertices(const std::vector<Encoded>& encoded, const BoundingBox& bounds,
+		std::vector<GeometryGenerator::Vertex>& vertices)
+	{
+		BoundsTransform t = MakeBoundsTransform(bounds);
+
+		vertices.resize(encoded.size());
+		for(size_t i = 0; i < encoded.size(); ++i)
+		{
+			const Encoded& e = encoded[i];
+			GeometryGenerator::Vertex& v = vertices[i];
+
+			XMStoreFloat3(&v.Position, XMVectorMultiplyAdd(XMLoadShortN4(&e.Position), t.Extents, t.Center));
+			XMStoreFloat3(&v.Normal, VertexQuantizer::DecodeOctahedral(LoadOctahedral(&e.Normal)));
+			XMStoreFloat3(&v.TangentU, VertexQuantizer::DecodeOctahedral(LoadOctahedral(&e.TangentU)));
+			XMStoreFloat2(&v.TexC, XMLoadHalf2(&e.TexC));
+		}
+	}
+
+	// Angle in degrees between two directions, or 0 if the source has no direction.
+	float AngleDegrees(FXMVECTOR source, FXMVECTOR decoded)
+	{
+		if(XMVectorGetX(XMVector3LengthSq(source)) <= FLT_MIN)
+			return 0.0f;
+
+		XMVECTOR cosAngle = XMVector3Dot(XMVector3Normalize(source), XMVector3Normalize(decoded));
+		cosAngle = XMVectorClamp(cosAngle, XMVectorReplicate(-1.0f), XMVectorSplatOne());
+		return XMConvertToDegrees(XMVectorGetX(XMVectorACos(cosAngle)));
+	}
+}
+
+void VertexQuantizer::Encode(const std::vector<GeometryGenerator::Vertex>& vertices, const BoundingBox& bounds,
+	std::vector<QuantizedVertex>& encoded)
+{
+	EncodeVertices(vertices, bounds, encoded);
+}
+
+void VertexQuantizer::Encode(const std::vector<GeometryGenerator::Vertex>& vertices, const BoundingBox& bounds,
+	std::vector<CompactQuantizedVertex>& encoded)
+{
+	EncodeVertices(vertices, bounds, encoded);
+}
+
+void VertexQuantizer::Decode(const std::vector<QuantizedVertex>& encoded, const BoundingBox& bounds,
+	std::vector<GeometryGenerator::Vertex>& vertices)
+{
+	DecodeVertices(encoded, bounds, vertices);
+}
+
+void VertexQuantizer::Decode(const std::vector<CompactQuantizedVertex>& encoded, const BoundingBox& bounds,
+	std::vector<GeometryGenerator::Vertex>& vertices)
+{
+	DecodeVertices(encoded, bounds, vertices);
+}
+
+QuantizationError VertexQuantizer::MeasureError(const std::vector<GeometryGenerator::Vertex>& source,
+	const std::vector<GeometryGenerator::Vertex>& decoded)
+{
+	QuantizationError error;
+	if(source.empty())
+		return error;
+
+	double positionSum = 0.0;
+	XMVECTOR maxTexC = XMVectorZero();
+
+	for(size_t i = 0; i < source.size(); ++i)
+	{
+		const GeometryGenerator::Vertex& s = source[i];
+		const GeometryGenerator::Vertex& d = decoded[i];
+
+		float position = XMVectorGetX(XMVector3Length(XMLoadFloat3(&s.Position) - XMLoadFloat3(&d.Position)));
+		error.MaxPosition = std::max(error.MaxPosition, position);
+		positionSum += position;
+
+		error.MaxNormalDegrees = std::max(error.MaxNormalDegrees,
+			AngleDegrees(XMLoadFloat3(&s.Normal), XMLoadFloat3(&d.Normal)));
+		error.MaxTangentDegrees = std::max(error.MaxTangentDegrees,
+			AngleDegrees(XMLoadFloat3(&s.TangentU), XMLoadFloat3(&d.TangentU)));
+
+		maxTexC = XMVectorMax(maxTexC, XMVectorAbs(XMLoadFloat2(&s.TexC) - XMLoadFloat2(&d.TexC)));
+	}
+
+	error.MeanPosition = (float)(positionSum / source.size());
+	error.MaxTexC = std::max(XMVectorGetX(maxTexC), XMVectorGetY(maxTexC));
+	return error;
+}
+
+XMVECTOR XM_CALLCONV VertexQuantizer::EncodeOctahedral(FXMVECTOR direction)
+{
+	// Project onto the octahedron.
+	XMVECTOR l1 = XMVector3Dot(XMVectorAbs(direction), XMVectorSplatOne());
+	if(XMVectorGetX(l1) <= FLT_MIN)
+		return XMVectorZero();
+
+	XMVECTOR p = direction / l1;
+
+	// The lower half is folded over the diagonals onto the corners of the square:
+	// xy = (1 - |yx|) * sign(xy), with sign(0) = 1 so the fold is continuous.
+	XMVECTOR sign = XMVectorSelect(XMVectorSplatOne(), XMVectorReplicate(-1.0f), XMVectorLess(p, XMVectorZero()));
+	XMVECTOR folded = (XMVectorSplatOne() - XMVectorAbs(XMVectorSwizzle<1, 0, 3, 2>(p)))*sign;
+
+	XMVECTOR lower = XMVectorLess(XMVectorSplatZ(p), XMVectorZero());
+	return XMVectorSelect(p, folded, lower);
+}
+
+XMVECTOR XM_CALLCONV VertexQuantizer::DecodeOctahedral(FXMVECTOR encoded)
+{
+	// z = 1 - |x| - |y|; where it is negative the point came from the lower half, and
+	// unfolding moves x and y back towards the axes by -z.
+	XMVECTOR absXY = XMVectorAbs(encoded);
+	XMVECTOR z = XMVectorSplatOne() - XMVectorSplatX(absXY) - XMVectorSplatY(absXY);
+	XMVECTOR t = XMVectorSaturate(-z);
+
+	XMVECTOR xy = encoded + XMVectorSelect(t, -t, XMVectorGreaterOrEqual(encoded, XMVectorZero()));
+
+	XMVECTOR n = XMVectorPermute<0, 1, 4, 4>(xy, z);
+	return XMVector3Normalize(XMVectorSetW(n, 0.0f));
+}
@@ -0,0 +1,92 @@
+//***************************************************************************************
+// VertexQuantizer.h
+//
+// Compact encodings of GeometryGenerator::Vertex, which stores 11 floats (44 bytes):
+//
+//   position  16-bit normalized, relative to the submesh bounding box
+//   normal    octahedral, 2 x 16 or 2 x 8 bit normalized
+//   tangent   octahedral, same width as the normal
+//   texcoord  2 x half float
+//
+// for 20 or 16 bytes per vertex.  The packing goes through DirectXPackedVector, so
+// each component is converted with SIMD instructions; MeasureError reports how far a
+// decoded mesh is from its source.
+//***************************************************************************************
+
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <DirectXCollision.h>
+#include "GeometryGenerator.h"
+
+// 20 bytes.  Position.w is unused.
+struct QuantizedVertex
+{
+	DirectX::PackedVector::XMSHORTN4 Position;
+	DirectX::PackedVector::XMSHORTN2 Normal;
+	DirectX::PackedVector::XMSHORTN2 TangentU;
+	DirectX::PackedVector::XMHALF2 TexC;
+};
+
+// 16 bytes.  8-bit octahedral normals are within about a degree of the source.
+struct CompactQuantizedVertex
+{
+	DirectX::PackedVector::XMSHORTN4 Position;
+	DirectX::PackedVector::XMBYTEN2 Normal;
+	DirectX::PackedVector::XMBYTEN2 TangentU;
+	DirectX::PackedVector::XMHALF2 TexC;
+};
+
+struct QuantizationError
+{
+	// Distance between source and decoded positions, in object space units.
+	float MaxPosition = 0.0f;
+	float MeanPosition = 0.0f;
+
+	// Largest angle between source and decoded directions, in degrees.  Vertices with
+	// a zero length source direction are skipped.
+	float MaxNormalDegrees = 0.0f;
+	float MaxTangentDegrees = 0.0f;
+
+	// Largest error of a single texture coordinate.
+	float MaxTexC = 0.0f;
+};
+
+class VertexQuantizer
+{
+public:
+	///<summary>
+	/// Encodes vertices relative to bounds, which should contain every position; those
+	/// outside are clamped to it.  Usually the bounds of the submesh the vertices
+	/// belong to, which the decoder then needs too.
+	///</summary>
+	static void Encode(const std::vector<GeometryGenerator::Vertex>& vertices, const DirectX::BoundingBox& bounds,
+		std::vector<QuantizedVertex>& encoded);
+	static void Encode(const std::vector<GeometryGenerator::Vertex>& vertices, const DirectX::BoundingBox& bounds,
+		std::vector<CompactQuantizedVertex>& encoded);
+
+	static void Decode(const std::vector<QuantizedVertex>& encoded, const DirectX::BoundingBox& bounds,
+		std::vector<GeometryGenerator::Vertex>& vertices);
+	static void Decode(const std::vector<CompactQuantizedVertex>& encoded, const DirectX::BoundingBox& bounds,
+		std::vector<GeometryGenerator::Vertex>& vertices);
+
+	///<summary>
+	/// Compares decoded against source, which must have the same number of vertices.
+	///</summary>
+	static QuantizationError MeasureError(const std::vector<GeometryGenerator::Vertex>& source,
+		const std::vector<GeometryGenerator::Vertex>& decoded);
+
+	///<summary>
+	/// Maps a direction onto the octahedron |x| + |y| + |z| = 1 and unfolds it into
+	/// the square [-1, 1]^2, returned in x and y.  The direction need not be unit
+	/// length; a zero vector encodes to the origin.
+	///</summary>
+	static DirectX::XMVECTOR XM_CALLCONV EncodeOctahedral(DirectX::FXMVECTOR direction);
+
+	///<summary>
+	/// Inverse of EncodeOctahedral: a unit direction from x and y.
+	///</summary>
+	static DirectX::XMVECTOR XM_CALLCONV DecodeOctahedral(DirectX::FXMVECTOR encoded);
+};
@@ -155,6 +155,9 @@ struct SubmeshGeometry
     // Bounding box of the geometry defined by this submesh. 
     // This is used in later chapters of the book.
 	DirectX::BoundingBox Bounds;
+
+	// Bounding sphere of the same geometry, centred on Bounds.
+	DirectX::BoundingSphere SphereBounds;
 };
 
 struct MeshGeometry